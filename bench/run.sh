@@ -0,0 +1,34 @@
+#!/bin/sh
+# ---------------------------------------------------------------------------
+# run.sh : builds xjs_bench with every combination of the XJS_CFLAG_* flags
+# and runs it, arguments are passed to xjs_bench (e.g. -m 4 -r 3).
+#
+#   CC=clang CFLAGS=-O3 bench/run.sh -m 16
+#   FLAGS="XJS_CFLAG_DISABLE_SIMD" bench/run.sh    only combinations of these
+# ---------------------------------------------------------------------------
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:-"-O2"}
+FLAGS=${FLAGS:-"XJS_CFLAG_DISABLE_MEM_FALLBACK XJS_CFLAG_ENABLE_BLOCKS XJS_CFLAG_DISABLE_DESCRIPTIONS XJS_CFLAG_DISABLE_ARRAY_POS_AS_NAME XJS_CFLAG_DISABLE_SIZE_T XJS_CFLAG_DISABLE_SIMD XJS_CFLAG_DISABLE_UTF8_CHECK XJS_CFLAG_ENABLE_STATS"}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT=${OUT:-"${TMPDIR:-/tmp}/xjs_bench"}
+mkdir -p "$OUT" || exit 1
+
+n=0; for f in $FLAGS; do n=$((n+1)); done
+combos=$((1<<n)); fails=0
+i=0
+while [ $i -lt $combos ]; do
+  defs=""; name="base"; b=0
+  for f in $FLAGS; do
+    if [ $(( (i>>b)&1 )) -eq 1 ]; then defs="$defs -D$f"; name="$name+${f#XJS_CFLAG_}"; fi
+    b=$((b+1))
+  done
+  echo "== $name"
+  if $CC $CFLAGS $defs -I"$ROOT" -o "$OUT/xjs_bench" "$ROOT/bench/xjs_bench.c" "$ROOT/xjs.c"; then
+    "$OUT/xjs_bench" "$@" || fails=$((fails+1))
+  else
+    fails=$((fails+1))
+  fi
+  i=$((i+1))
+done
+echo "== $combos builds, $fails failed"
+[ $fails -eq 0 ]
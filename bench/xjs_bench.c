@@ -0,0 +1,349 @@
+/* ---------------------------------------------------------------------------
+** xjs_bench : generates a corpus and measures the parser on it
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+**
+** Build it with the flags to measure (bench/run.sh builds every combination):
+**
+**   cc -O2 -I. [-DXJS_CFLAG_...] -o xjs_bench bench/xjs_bench.c xjs.c
+**
+**   xjs_bench [-s shape] [-m MB] [-r runs] [-b piece] [-seed n]
+**   xjs_bench -o file -s shape [-m MB] [-seed n]   writes the corpus
+**   xjs_bench [-r runs] [-b piece] file...         measures files
+**
+** The shapes are numbers (coordinates), strings (log records and posts
+** with escapes and UTF-8), nested (documents 64 levels deep), wide
+** (objects with 1000 members) and blocks (with XJS_CFLAG_ENABLE_BLOCKS).
+** The corpus comes from a fixed generator and seed, so a shape, size and
+** seed always give the same bytes. Each shape is parsed with the memory
+** manager of xjs_ex1.c (static buffers), of xjsf.c style (malloc) and the
+** built-in arena (NULL), through xjs_parse_n (values copied) and
+** xjs_parse_view (zero copy). The input is handed over through an input
+** callback in pieces of -b bytes (64 KB, 0 for one piece). Each line is the
+** best of the runs:
+**
+**   shape  mem  api  MB  MB/s  nodes/s  allocs/MB  inputs/MB
+** ---------------------------------------------------------------------------
+*/
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "xjs.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ---------------------------------------------------------------------------
+** Generator: a corpus of about size bytes of one shape, from a xorshift
+** generator so that it is the same on every system.
+** ---------------------------------------------------------------------------
+*/
+typedef struct { char *b; size_t n, sz; unsigned long long rnd; } Gen;
+
+static unsigned long long rnd(Gen *g)
+{ g->rnd^=g->rnd<<13; g->rnd^=g->rnd>>7; g->rnd^=g->rnd<<17;
+  return g->rnd;
+}
+
+static void put(Gen *g, const char *s, size_t n)
+{ if (g->n+n+1>g->sz)
+  { g->sz=(g->n+n+1)*2;
+    if ((g->b=(char*)realloc(g->b, g->sz))==NULL) { printf("out of memory\n"); exit(1); }
+  }
+  memcpy(g->b+g->n, s, n); g->n+=n; g->b[g->n]=0;
+}
+static void puts_(Gen *g, const char *s) { put(g, s, strlen(s)); }
+
+static void putf(Gen *g, const char *fmt, double d)
+{ char t[256]; snprintf(t, sizeof(t), fmt, d); puts_(g, t);
+}
+
+static const char *words[]=
+{ "the", "parser", "request", "took", "ms", "user", "login", "failed", "café", "naïve", "über", "日本",
+  "error", "retry", "cache", "miss", "hit", "GET", "POST", "/api/v1/items", "200", "404", "json", "ok" };
+#define NWORDS ((int)(sizeof(words)/sizeof(words[0])))
+
+static void gen_text(Gen *g, int nwords)
+{ int i, w;
+  put(g, "\"", 1);
+  for (i=0; i<nwords; i++)
+  { if (i) put(g, " ", 1);
+    w=(int)(rnd(g)%(NWORDS+6));
+    if (w<NWORDS) puts_(g, words[w]);
+    else if (w==NWORDS) puts_(g, "\\\"quoted\\\"");
+    else if (w==NWORDS+1) puts_(g, "C:\\\\tmp\\\\x");
+    else if (w==NWORDS+2) puts_(g, "line\\nbreak");
+    else if (w==NWORDS+3) puts_(g, "\\u00e9t\\u00e9");
+    else if (w==NWORDS+4) puts_(g, "tab\\there");
+    else puts_(g, "\\ud83d\\ude00");
+  }
+  put(g, "\"", 1);
+}
+
+static void gen_numbers(Gen *g, size_t size)
+{ int i=0;
+  puts_(g, "{\"type\":\"FeatureCollection\",\"features\":[");
+  while (g->n<size)
+  { int k, n=8+(int)(rnd(g)%64);
+    if (i++) put(g, ",", 1);
+    putf(g, "{\"type\":\"Feature\",\"id\":%.0f,\"geometry\":{\"type\":\"LineString\",\"coordinates\":[", (double)i);
+    for (k=0; k<n; k++)
+    { if (k) put(g, ",", 1);
+      putf(g, "[%.7f,", -180.0+(double)(rnd(g)%3600000000ULL)/1e7);
+      putf(g, "%.7f", -90.0+(double)(rnd(g)%1800000000ULL)/1e7);
+      if (rnd(g)%4==0) putf(g, ",%.3e", (double)(rnd(g)%100000)/7.0);
+      put(g, "]", 1);
+    }
+    putf(g, "]},\"properties\":{\"length\":%.15g,\"lanes\":", (double)(rnd(g)%1000000)/3.0);
+    putf(g, "%.0f}}", (double)(rnd(g)%6));
+  }
+  puts_(g, "]}");
+}
+
+static void gen_strings(Gen *g, size_t size)
+{ int i=0;
+  put(g, "[", 1);
+  while (g->n<size)
+  { if (i++) put(g, ",\n", 2);
+    putf(g, "{\"id\":%.0f,\"ts\":\"2016-11-", (double)(1000000+i));
+    putf(g, "%02.0fT", (double)(1+rnd(g)%28));
+    putf(g, "%02.0f:", (double)(rnd(g)%24)); putf(g, "%02.0f:", (double)(rnd(g)%60)); putf(g, "%02.0fZ\",\"level\":", (double)(rnd(g)%60));
+    puts_(g, (rnd(g)%5)?"\"INFO\"":"\"ERROR\""); puts_(g, ",\"user\":");
+    gen_text(g, 1); puts_(g, ",\"text\":");
+    gen_text(g, 5+(int)(rnd(g)%40)); puts_(g, ",\"tags\":[");
+    gen_text(g, 1); put(g, ",", 1); gen_text(g, 1); puts_(g, "],\"reply\":");
+    puts_(g, (rnd(g)%3)?"null":"true"); put(g, "}", 1);
+  }
+  put(g, "]", 1);
+}
+
+static void gen_nested(Gen *g, size_t size)
+{ int i=0, d;
+  put(g, "[", 1);
+  while (g->n<size)
+  { if (i++) put(g, ",", 1);
+    for (d=0; d<64; d++) puts_(g, (d%2)?"[":"{\"a\":");
+    putf(g, "%.0f", (double)(rnd(g)%1000));
+    for (d=63; d>=0; d--)
+    { if (d%2) { put(g, ",", 1); gen_text(g, 1); put(g, "]", 1); }
+      else puts_(g, ",\"b\":false}");
+    }
+  }
+  put(g, "]", 1);
+}
+
+static void gen_wide(Gen *g, size_t size)
+{ int i=0, k;
+  put(g, "[", 1);
+  while (g->n<size)
+  { if (i++) put(g, ",", 1);
+    put(g, "{", 1);
+    for (k=0; k<1000; k++)
+    { if (k) put(g, ",", 1);
+      putf(g, "\"field_%04.0f\":", (double)k);
+      switch (rnd(g)%4)
+      { case 0: putf(g, "%.0f", (double)(rnd(g)%100000)); break;
+        case 1: gen_text(g, 1); break;
+        case 2: puts_(g, "null"); break;
+        default: putf(g, "%.4f", (double)(rnd(g)%100000)/100.0); break;
+      }
+    }
+    put(g, "}", 1);
+  }
+  put(g, "]", 1);
+}
+
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+static void gen_blocks(Gen *g, size_t size)
+{ int i=0, r;
+  put(g, "[", 1);
+  while (g->n<size)
+  { if (i++) put(g, ",", 1);
+    puts_(g, "([\"Rank\",\"Team\",\"2016\",\"Last 3\",\"Last 1\",\"Home\",\"Away\",\"Note\"]");
+    for (r=0; r<1000; r++)
+    { putf(g, ",\n [%.0f,", (double)(r+1)); gen_text(g, 2);
+      putf(g, ",%.2f", (double)(rnd(g)%1000)/100.0); putf(g, ",%.2f", (double)(rnd(g)%1000)/100.0);
+      putf(g, ",%.2f", (double)(rnd(g)%1000)/100.0); putf(g, ",%.2f", (double)(rnd(g)%1000)/100.0);
+      putf(g, ",%.2f,", (double)(rnd(g)%1000)/100.0); puts_(g, (rnd(g)%2)?"null]":"\"n/a\"]");
+    }
+    put(g, ")", 1);
+  }
+  put(g, "]", 1);
+}
+#endif
+
+static const char *shapes[]=
+{ "numbers", "strings", "nested", "wide",
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  "blocks",
+#endif
+};
+#define NSHAPES ((int)(sizeof(shapes)/sizeof(shapes[0])))
+
+static int generate(Gen *g, const char *shape, size_t size, unsigned long long seed)
+{ g->n=0; g->rnd=(seed)?seed:1;
+  if (strcmp(shape, "numbers")==0) gen_numbers(g, size);
+  else if (strcmp(shape, "strings")==0) gen_strings(g, size);
+  else if (strcmp(shape, "nested")==0) gen_nested(g, size);
+  else if (strcmp(shape, "wide")==0) gen_wide(g, size);
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  else if (strcmp(shape, "blocks")==0) gen_blocks(g, size);
+#endif
+  else return 0;
+  return 1;
+}
+
+/* ---------------------------------------------------------------------------
+** Memory managers, counting what they are asked for. static is the one of
+** xjs_ex1.c with buffers that fit the corpus, malloc is libc.
+** ---------------------------------------------------------------------------
+*/
+static unsigned long g_allocs, g_inputs, g_nodes;
+
+static void *memcb_static(XJSMemReq action, XJSType context, void *prev, XJSSize size, XJSSize *actsz)
+{ static char s_name[4096], s_value[65536]; static double s_stack[65536/sizeof(double)];
+  if (action==XJS_free) return NULL; // nothing to free.
+  g_allocs++;
+  if (prev) { *actsz=0; return NULL; } // no reallocation allowed.
+  if (context==XJS_parser) { *actsz=sizeof(s_stack); return s_stack; } // the stack for deep nesting, once
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if (context==XJS_block_header) { *actsz=0; return NULL; } // no header names to keep, records are named by position
+#endif
+  if (context==XJS_name) { *actsz=sizeof(s_name); return s_name; }
+  *actsz=sizeof(s_value);
+  return s_value;
+}
+
+static void *memcb_malloc(XJSMemReq action, XJSType context, void *prev, XJSSize size, XJSSize *actsz)
+{ void *ret=NULL; if (actsz) *actsz=0;
+  if (action==XJS_free) { free(prev); return NULL; }
+  g_allocs++;
+  ret=(prev)?realloc(prev, size):malloc(size);
+  if ((ret)&&(actsz)) *actsz=size;
+  return ret;
+}
+
+/* ---------------------------------------------------------------------------
+** Input in pieces, and node callbacks that look at what they get.
+** ---------------------------------------------------------------------------
+*/
+typedef struct { const char *b; size_t n, at, piece; } Input;
+
+static int inpcb(const char **input, XJSSize *len, void *arg)
+{ Input *in=(Input*)arg; size_t n=in->n-in->at;
+  g_inputs++;
+  if (n==0) return XJS_END;
+  if ((in->piece)&&(n>in->piece)) n=in->piece;
+  *input=in->b+in->at; *len=n; in->at+=n;
+  return XJS_OK;
+}
+
+static unsigned long g_sum;
+
+static int nodecb(void **parent, XJSType kind, const char *name, const char *value, void *arg)
+{ g_nodes++;
+  if (value) g_sum+=(unsigned char)value[0];
+  return XJS_OK;
+}
+
+static int viewcb(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *arg)
+{ g_nodes++;
+  if (value_len) g_sum+=(unsigned char)value[0];
+  return XJS_OK;
+}
+
+static double now(void)
+{ struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec+(double)ts.tv_nsec/1e9;
+}
+
+/* ---------------------------------------------------------------------------
+** Measure one corpus with every memory manager and both APIs.
+** ---------------------------------------------------------------------------
+*/
+static int measure(const char *shape, const char *json, size_t len, int runs, size_t piece)
+{ static const char *mems[]={ "static", "malloc", "arena" };
+  static const char *apis[]={ "copy", "view" };
+  XJSMemCB mcb[3]={ memcb_static, memcb_malloc, NULL };
+  int m, a, i, r, fails=0; double mb=(double)len/(1024.0*1024.0);
+  for (m=0; m<3; m++) for (a=0; a<2; a++)
+  { double best=0, t; unsigned long nodes=0, allocs=0, inputs=0; const char *err=NULL;
+#ifdef XJS_CFLAG_DISABLE_MEM_FALLBACK
+    if (mcb[m]==NULL) continue; // no arena
+#endif
+    for (i=0, r=XJS_OK; (i<runs)&&(r==XJS_OK); i++)
+    { Input in; in.b=json; in.n=len; in.at=0; in.piece=piece;
+      g_allocs=g_inputs=g_nodes=0;
+      t=now();
+      if (a==0) r=xjs_parse_n(NULL, 0, nodecb, NULL, inpcb, &in, mcb[m], &err);
+      else r=xjs_parse_view(NULL, 0, viewcb, NULL, inpcb, &in, mcb[m], &err);
+      t=now()-t;
+      if ((i==0)||(t<best)) best=t;
+      nodes=g_nodes; allocs=g_allocs; inputs=g_inputs;
+    }
+    if (r!=XJS_OK) { printf("%-8s %-6s %-4s error %d at %ld\n", shape, mems[m], apis[a], r, (err)?(long)(err-json):-1L); fails++; continue; }
+    if (best<=0) best=1e-9;
+    printf("%-8s %-6s %-4s %8.1f %9.1f %12.0f ", shape, mems[m], apis[a], mb, mb/best, (double)nodes/best);
+    if (mcb[m]) printf("%10.1f ", (double)allocs/mb); else printf("%10s ", "-");
+    printf("%10.1f\n", (double)inputs/mb);
+  }
+  return fails;
+}
+
+/* ---------------------------------------------------------------------------
+**  xjs_bench [-s shape] [-m MB] [-r runs] [-b piece] [-seed n] [-o file] [file...]
+** ---------------------------------------------------------------------------
+*/
+int main(int argc, char *argv[])
+{ const char *shape=NULL, *out=NULL; double mbs=16; int runs=5, i, k, fails=0, nfiles=0; size_t piece=64*1024;
+  unsigned long long seed=1; Gen g; memset(&g, 0, sizeof(g));
+  for (i=1; i<argc; i++)
+  { if ((strcmp(argv[i], "-s")==0)&&(i+1<argc)) shape=argv[++i];
+    else if ((strcmp(argv[i], "-m")==0)&&(i+1<argc)) mbs=atof(argv[++i]);
+    else if ((strcmp(argv[i], "-r")==0)&&(i+1<argc)) runs=atoi(argv[++i]);
+    else if ((strcmp(argv[i], "-b")==0)&&(i+1<argc)) piece=(size_t)atol(argv[++i]);
+    else if ((strcmp(argv[i], "-seed")==0)&&(i+1<argc)) seed=strtoull(argv[++i], NULL, 10);
+    else if ((strcmp(argv[i], "-o")==0)&&(i+1<argc)) out=argv[++i];
+    else if (argv[i][0]=='-') { printf("%s [-s shape] [-m MB] [-r runs] [-b piece] [-seed n] [-o file] [file...]\n", argv[0]); return 1; }
+    else nfiles++;
+  }
+  if (runs<1) runs=1;
+  if (out)
+  { FILE *f;
+    if ((shape==NULL)||(!generate(&g, shape, (size_t)(mbs*1024*1024), seed))) { printf("-o needs a shape\n"); return 1; }
+    if (((f=fopen(out, "wb"))==NULL)||(fwrite(g.b, 1, g.n, f)!=g.n)) { printf("can't write %s\n", out); return 1; }
+    fclose(f); free(g.b);
+    return 0;
+  }
+  printf("%-8s %-6s %-4s %8s %9s %12s %10s %10s\n", "shape", "mem", "api", "MB", "MB/s", "nodes/s", "allocs/MB", "inputs/MB");
+  if (nfiles)
+  { for (i=1; i<argc; i++)
+    { FILE *f; long n;
+      if (argv[i][0]=='-') { i++; continue; }
+      if (((f=fopen(argv[i], "rb"))==NULL)||(fseek(f, 0, SEEK_END)!=0)||((n=ftell(f))<0)) { printf("can't read %s\n", argv[i]); return 1; }
+      rewind(f);
+      if (g.sz<(size_t)n+1)
+      { g.sz=(size_t)n+1;
+        if ((g.b=(char*)realloc(g.b, g.sz))==NULL) { printf("out of memory\n"); return 1; }
+      }
+      g.n=fread(g.b, 1, (size_t)n, f);
+      fclose(f);
+      fails+=measure(argv[i], g.b, g.n, runs, piece);
+    }
+  }
+  else if ((shape)&&(!generate(&g, shape, 0, seed))) { printf("unknown shape %s\n", shape); return 1; }
+  else for (k=0; k<NSHAPES; k++)
+  { if ((shape)&&(strcmp(shape, shapes[k])!=0)) continue;
+    generate(&g, shapes[k], (size_t)(mbs*1024*1024), seed);
+    fails+=measure(shapes[k], g.b, g.n, runs, piece);
+  }
+  free(g.b);
+  return (fails)?1:0;
+}
+
+/* EOF */
@@ -24,6 +24,7 @@ void *memcb_static(XJSMemReq action, XJSType context, void *prev, XJSSize size,
 { static char s_name[NAME_BUF_SIZE], s_value[VALUE_BUF_SIZE];
   if (action==XJS_free) return NULL;   // nothing to free.
   if (prev) { *actsz=0; return NULL; } // no reallocation allowed.
+  if (context==XJS_parser) { *actsz=0; return NULL; } // nesting deeper than the parser's own stack fails
   if (context==XJS_name) { *actsz=NAME_BUF_SIZE; return s_name; } // require two buffers for object members (name:value)
   *actsz=VALUE_BUF_SIZE; 
   return s_value;
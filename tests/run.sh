@@ -0,0 +1,25 @@
+#!/bin/sh
+# ---------------------------------------------------------------------------
+# run.sh : builds each tests/test_*.c with the library and runs it, fails if
+# a build or a test fails.
+#
+#   CC=clang CFLAGS="-O1 -fsanitize=address" tests/run.sh
+#   DEFS="-DXJS_CFLAG_ENABLE_BLOCKS" tests/run.sh
+# ---------------------------------------------------------------------------
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:-"-O2 -Wall"}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT=${OUT:-"${TMPDIR:-/tmp}/xjs_tests"}
+mkdir -p "$OUT" || exit 1
+
+fails=0; n=0
+for t in "$ROOT"/tests/test_*.c; do
+  name=$(basename "$t" .c); n=$((n+1))
+  if $CC $CFLAGS $DEFS -I"$ROOT" -o "$OUT/$name" "$t" "$ROOT/xjs.c" "$ROOT/xjs_write.c" "$ROOT/xjs_par.c" -lpthread && "$OUT/$name"; then
+    echo "== $name ok"
+  else
+    echo "== $name FAILED"; fails=$((fails+1))
+  fi
+done
+echo "== $n tests, $fails failed"
+[ $fails -eq 0 ]
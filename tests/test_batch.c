@@ -0,0 +1,82 @@
+/* ---------------------------------------------------------------------------
+** test_batch : the events of a batch (xjs_parser_batch) are the nodes the
+** view callback gets, for any batch size and with the input fed in pieces,
+** and with a key dictionary (xjs_parser_keys) their names are its own
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+*/
+#include "xjs.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+typedef struct
+{ char *p; size_t n, size;   /* the nodes as lines */
+  const XJSKeys *keys;        /* the names' ids are in the lines too */
+  XJSEvent ev[64];
+} Out;
+
+/* A node as a line, the names of array elements are left out (they are positions). */
+static void add(Out *o, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len)
+{ size_t need=name_len+value_len+48;
+  if (o->n+need>o->size) { o->size=2*(o->n+need); o->p=(char*)realloc(o->p, o->size); }
+  if ((name)&&(name_len)&&(name[0]>='0')&&(name[0]<='9')) name=NULL;
+  o->n+=(size_t)sprintf(o->p+o->n, "%d %d [", (int)kind, (o->keys)?xjs_key(o->keys, (name)?name:""):-2);
+  if (name) { memcpy(o->p+o->n, name, name_len); o->n+=name_len; }
+  o->p[o->n++]=']';
+  if (value) { memcpy(o->p+o->n, value, value_len); o->n+=value_len; }
+  o->p[o->n++]='\n';
+}
+
+static int viewcb(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *node_arg)
+{ (void)parent;
+  add((Out*)node_arg, kind, name, name_len, value, value_len);
+  return XJS_OK;
+}
+
+static int batchcb(const XJSEvent *events, int n, long long first, void *node_arg)
+{ int i; (void)first;
+  for (i=0;i<n;i++) add((Out*)node_arg, events[i].kind, events[i].name, events[i].name_len, events[i].value, events[i].value_len);
+  return XJS_OK;
+}
+
+/* Parse json with batches of size events (0 for the view callback), fed in pieces of piece bytes (0 for all of it). */
+static int parse(Out *o, const char *json, size_t len, int size, size_t piece)
+{ XJSParser *p=xjs_parser_new_view(viewcb, o, NULL); const char *err; size_t k; int r=XJS_OK;
+  o->n=0;
+  if (o->keys) r=xjs_parser_keys(p, o->keys);
+  if ((r==XJS_OK)&&(size)) r=xjs_parser_batch(p, o->ev, size, batchcb);
+  if ((r==XJS_OK)&&(piece==0)) r=xjs_parser_parse(p, json, len, NULL, NULL, &err);
+  else if (r==XJS_OK)
+  { for (k=0;(k<len)&&((r==XJS_OK)||(r==XJS_MORE));k+=piece) r=xjs_feed(p, json+k, (len-k<piece)?len-k:piece, &err);
+    if ((r==XJS_OK)||(r==XJS_MORE)) r=xjs_finish(p, &err);
+  }
+  xjs_parser_free(p);
+  return r;
+}
+
+int main(void)
+{ static const char *names[]={ "id", "name", "tags", "a rather long member name that is split", NULL };
+  static const char json[]="{\"id\":7,\"name\":\"x\\\"y\",\"tags\":[\"a\",{\"id\":1,\"zz\":null}],"
+                           "\"a rather long member name that is split\":{\"name\":[true,false]},\"na\\u006de\":-1.5e3,\"\":\"\"}";
+  static const int sizes[]={ 1, 2, 3, 7, 64, 0 };
+  static const size_t pieces[]={ 0, 1, 2, 5, 13, 64, 1000 };
+  Out a={0}, b={0}; XJSKeys *keys=NULL; int k, i, j, r, fails=0;
+  if (xjs_keys_new(&keys, names, 4, NULL)!=XJS_OK) { printf("keys\n"); return 1; }
+  for (k=0;k<2;k++)
+  { a.keys=b.keys=(k)?keys:NULL;
+    if ((r=parse(&a, json, sizeof(json)-1, 0, 0))!=XJS_OK) { printf("view%s: r=%d\n", (k)?", keys":"", r); fails++; continue; }
+    if ((k)&&(strstr(a.p, " 0 [id]")==NULL)) { printf("view, keys: no ids\n%.*s", (int)a.n, a.p); fails++; }
+    for (i=0;sizes[i];i++) for (j=0;j<(int)(sizeof(pieces)/sizeof(pieces[0]));j++)
+    { if ((r=parse(&b, json, sizeof(json)-1, sizes[i], pieces[j]))!=XJS_OK) { printf("batch %d, pieces %lu%s: r=%d\n", sizes[i], (unsigned long)pieces[j], (k)?", keys":"", r); fails++; }
+      else if ((b.n!=a.n)||(memcmp(a.p, b.p, a.n)!=0))
+      { printf("batch %d, pieces %lu%s: other events\n%.*s--\n%.*s", sizes[i], (unsigned long)pieces[j], (k)?", keys":"", (int)a.n, a.p, (int)b.n, b.p); fails++; }
+    }
+  }
+  xjs_keys_free(keys); free(a.p); free(b.p);
+  return (fails)?1:0;
+}
+
+/* EOF */
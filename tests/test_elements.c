@@ -0,0 +1,149 @@
+/* ---------------------------------------------------------------------------
+** test_elements : the elements of an array (xjs_parser_elements) parsed with
+** and without the structural index (XJS_OPT_INDEX) give the same nodes as
+** the array parsed whole, also on the workers of xjs_par (XJS_PAR_ARRAY),
+** and indexed parses on several threads at once give the nodes of a serial one
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+*/
+#include "xjs.h"
+#include "xjs_par.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+typedef struct 
+{ char *p; size_t n, size;   /* the nodes as lines */
+  unsigned long long sum;     /* and a checksum of them that does not depend on the order */
+  XJSSize nodes; 
+  int depth, min;             /* nodes at depth min and deeper are kept */
+} Out;
+
+/* Each node as a line, the names of array elements are left out (they are positions). */
+static int nodecb(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *node_arg)
+{ Out *o=(Out*)node_arg; size_t need=name_len+value_len+32; XJSSize i; int d=o->depth;
+  (void)parent;
+  if ((kind==XJS_array)||(kind==XJS_object)) o->depth++;
+  else if ((kind==XJS_array_end)||(kind==XJS_object_end)) d=--o->depth;
+  if (d<o->min) return XJS_OK;
+  if (o->n+need>o->size) { o->size=2*(o->n+need); o->p=(char*)realloc(o->p, o->size); }
+  o->n+=(size_t)sprintf(o->p+o->n, "%d [", (int)kind);
+  if ((name)&&((name_len==0)||(name[0]<'0')||(name[0]>'9'))) { memcpy(o->p+o->n, name, name_len); o->n+=name_len; }
+  o->p[o->n++]=']';
+  if (value) { memcpy(o->p+o->n, value, value_len); o->n+=value_len; }
+  o->p[o->n++]='\n';
+  o->nodes++; o->sum+=(unsigned long long)(kind+10)*31+value_len;
+  for (i=0;i<value_len;i++) o->sum+=(unsigned char)value[i]*(i+1);
+  return XJS_OK;
+}
+
+static int parse(Out *o, const char *json, size_t len, int elements, int opts)
+{ XJSParser *p=xjs_parser_new_view(nodecb, o, NULL); const char *err; int r;
+  o->n=0; o->sum=0; o->nodes=0; o->depth=0; o->min=(elements)?0:1; // the array itself is left out
+  if ((r=xjs_parser_options(p, opts))==XJS_OK) 
+    if ((!elements)||((r=xjs_parser_elements(p, 0))==XJS_OK)) r=xjs_parser_parse(p, json, len, NULL, NULL, &err);
+  xjs_parser_free(p);
+  return r;
+}
+
+/* The nodes of the list against those inside [list]. */
+static int check(const char *list, size_t len)
+{ Out a={0}, b={0}; char *arr=(char*)malloc(len+2); int r, opts, fails=0; 
+  arr[0]='['; memcpy(arr+1, list, len); arr[len+1]=']';
+  if ((r=parse(&a, arr, len+2, 0, 0))!=XJS_OK) { printf("array: r=%d\n", r); fails++; }
+  else 
+  { for (opts=0;opts<=XJS_OPT_INDEX;opts+=XJS_OPT_INDEX)
+    { if ((r=parse(&b, list, len, 1, opts))!=XJS_OK) { printf("elements%s: r=%d [%.*s]\n", (opts)?"+index":"", r, (int)((len<60)?len:60), list); fails++; }
+      else if ((b.n!=a.n)||(memcmp(a.p, b.p, a.n)!=0)) { printf("elements%s: other nodes [%.*s]\n", (opts)?"+index":"", (int)((len<60)?len:60), list); fails++; }
+    }
+  }
+  free(a.p); free(b.p); free(arr);
+  return fails;
+}
+
+/* An element list with escaped strings, numbers and literals at the ends. */
+static size_t gen(char *b, int n, unsigned seed)
+{ size_t k=0; int i;
+  for (i=0;i<n;i++)
+  { if (i) k+=(size_t)sprintf(b+k, (seed%5==0)?" , ":",");
+    seed=seed*1103515245u+12345u;
+    switch ((seed>>16)%6)
+    { case 0: k+=(size_t)sprintf(b+k, "\"\\\"%u\\\\\"", seed%1000); break;
+      case 1: k+=(size_t)sprintf(b+k, "%d", (int)(seed%20000)-10000); break;
+      case 2: k+=(size_t)sprintf(b+k, "{\"\\\"k\":[%u,\"x\\n\"],\"v\":null}", seed%7); break;
+      case 3: k+=(size_t)sprintf(b+k, "[\"\\\"\",true,-1.5e%u]", seed%9); break;
+      case 4: k+=(size_t)sprintf(b+k, "%s", (seed&1)?"true":"null"); break;
+      default: k+=(size_t)sprintf(b+k, "\"plain %u\"", seed%100); break;
+    }
+  }
+  return k;
+}
+
+/* The name of the last element, elements from past 2^32 are named by their full position. */
+static int namecb(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *node_arg)
+{ char *last=(char*)node_arg;
+  (void)parent; (void)kind; (void)value; (void)value_len;
+  if ((name)&&(name_len<32)) { memcpy(last, name, name_len); last[name_len]=0; }
+  return XJS_OK;
+}
+
+static int far(void)
+{ XJSSize first=(XJSSize)5000000000ULL; char last[32]=""; const char *err; int r; XJSParser *p;
+  if (first!=5000000000ULL) return 0; // a 32 bit XJSSize
+  p=xjs_parser_new_view(namecb, last, NULL);
+  if ((r=xjs_parser_elements(p, first))==XJS_OK) r=xjs_parser_parse(p, "1,2", 3, NULL, NULL, &err);
+  xjs_parser_free(p);
+#ifdef XJS_CFLAG_DISABLE_ARRAY_POS_AS_NAME
+  strcpy(last, "5000000002"); // elements have no names
+#endif
+  if ((r!=XJS_OK)||(strcmp(last, "5000000002")!=0)) { printf("elements from %s: r=%d, last named %s\n", "5000000000", r, last); return 1; }
+  return 0;
+}
+
+/* A thread that parses the array with the index, against the serial nodes. */
+typedef struct { const char *json; size_t len; const Out *serial; int fails; } Job;
+
+static void *job(void *arg)
+{ Job *j=(Job*)arg; Out o={0}; int i, r;
+  for (i=0;i<20;i++)
+  { if ((r=parse(&o, j->json, j->len, 0, XJS_OPT_INDEX))!=XJS_OK) { printf("thread: r=%d\n", r); j->fails++; break; }
+    if ((o.n!=j->serial->n)||(memcmp(o.p, j->serial->p, o.n)!=0)) { printf("thread: other nodes\n"); j->fails++; break; }
+  }
+  free(o.p);
+  return NULL;
+}
+
+int main(void)
+{ static const char *lists[]={ "\"\\\"\",1", "\"\\\"\",null", "{\"\\\"\":1},null", "[\"\\\"\"],true", "1,\"a\\\"b\"", "\"\\\"\"", " 7 ", NULL };
+  static char big[1<<20], small[1<<16]; Out serial={0}; Out w[8]; void *args[8];
+  int i, n, t, fails=0, r; size_t len, k; XJSSize chunk;
+  // an array, parsed first with the index on threads at once (none may see another choose the kernels)
+  len=gen(big+1, 20000, 7)+2; big[0]='['; big[len-1]=']';
+  if ((r=parse(&serial, big, len, 0, 0))!=XJS_OK) { printf("serial: r=%d\n", r); return 1; }
+  { pthread_t th[8]; Job jobs[8];
+    for (t=0;t<8;t++) { jobs[t].json=big; jobs[t].len=len; jobs[t].serial=&serial; jobs[t].fails=0; pthread_create(&th[t], NULL, job, &jobs[t]); }
+    for (t=0;t<8;t++) { pthread_join(th[t], NULL); fails+=jobs[t].fails; }
+  }
+  for (i=0;lists[i];i++) fails+=check(lists[i], strlen(lists[i]));
+  fails+=far();
+  for (n=1;n<200;n+=7) { k=gen(small, n, (unsigned)n); fails+=check(small, k); }
+  // the array on the workers, with and without the index
+  for (t=1;t<=8;t*=8) for (chunk=1000;chunk<=100000;chunk*=10) for (i=0;i<=XJS_OPT_INDEX;i+=XJS_OPT_INDEX)
+  { XJSPar *p; XJSSize nodes=0, err=0; unsigned long long sum=0; int k;
+    memset(w, 0, sizeof(w)); for (k=0;k<t;k++) args[k]=&w[k];
+    p=xjs_par_new(nodecb, args, t, NULL);
+    xjs_par_options(p, i); xjs_par_chunks(p, NULL, NULL, XJS_PAR_ARRAY, chunk);
+    r=xjs_par_parse(p, big, len, &err);
+    xjs_par_free(p);
+    for (k=0;k<t;k++) { nodes+=w[k].nodes; sum+=w[k].sum; free(w[k].p); }
+    if ((r!=XJS_OK)||(nodes!=serial.nodes)) { printf("par %d threads, chunk %lu%s: r=%d at %lu, %lu nodes (%lu)\n", t, (unsigned long)chunk, (i)?", index":"", r, (unsigned long)err, (unsigned long)nodes, (unsigned long)serial.nodes); fails++; }
+    else if (sum!=serial.sum) { printf("par %d threads, chunk %lu%s: other nodes\n", t, (unsigned long)chunk, (i)?", index":""); fails++; }
+  }
+  free(serial.p);
+  return (fails)?1:0;
+}
+
+/* EOF */
@@ -0,0 +1,107 @@
+/* ---------------------------------------------------------------------------
+** test_keys : a key dictionary (xjs_keys_new, xjs_parser_keys) gives every
+** known member name its id and no other name one, through the node, view
+** and batch callbacks, decoded or not, whole or fed in pieces
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+*/
+#include "xjs.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define NKEYS    500   /* k0 to k499 are known */
+#define NMEMBERS 600   /* the document has k0 to k599 */
+
+typedef struct
+{ const XJSKeys *keys;
+  int names, known, bad;      /* names seen, of them with an id, ids that are wrong */
+  XJSEvent ev[16];
+} Out;
+
+/* The id name should have: n for kn with n below NKEYS, otherwise none. */
+static int expect(const char *name, XJSSize len)
+{ XJSSize i; int n=0;
+  if ((name==NULL)||(len<2)||(name[0]!='k')) return XJS_KEY_UNKNOWN;
+  for (i=1;i<len;i++) { if ((name[i]<'0')||(name[i]>'9')) return XJS_KEY_UNKNOWN; n=n*10+(name[i]-'0'); }
+  return (n<NKEYS)?n:XJS_KEY_UNKNOWN;
+}
+
+static void see(Out *o, const char *name, XJSSize len)
+{ int id=xjs_key(o->keys, name), e=expect(name, len);
+  if (name) o->names++;
+  if (id!=XJS_KEY_UNKNOWN) o->known++;
+  if (id!=e) { if (o->bad++<5) printf("%.*s: id %d, not %d\n", (int)len, (name)?name:"", id, e); }
+}
+
+static int nodecb(void **parent, XJSType kind, const char *name, const char *value, void *node_arg)
+{ (void)parent; (void)kind; (void)value;
+  if ((kind!=XJS_object_end)&&(kind!=XJS_array_end)) see((Out*)node_arg, name, (name)?strlen(name):0);
+  return XJS_OK;
+}
+
+static int viewcb(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *node_arg)
+{ (void)parent; (void)value; (void)value_len;
+  if ((kind!=XJS_object_end)&&(kind!=XJS_array_end)) see((Out*)node_arg, name, name_len);
+  return XJS_OK;
+}
+
+static int batchcb(const XJSEvent *events, int n, long long first, void *node_arg)
+{ int i; (void)first;
+  for (i=0;i<n;i++) if ((events[i].kind!=XJS_object_end)&&(events[i].kind!=XJS_array_end)) see((Out*)node_arg, events[i].name, events[i].name_len);
+  return XJS_OK;
+}
+
+/* Parse json with the node (how 0), view (1) or batch (2) callbacks, fed in pieces of piece bytes (0 for all of it). */
+static int parse(Out *o, const char *json, size_t len, int how, int opts, size_t piece)
+{ XJSParser *p=(how)?xjs_parser_new_view(viewcb, o, NULL):xjs_parser_new(nodecb, o, NULL); const char *err; size_t k; int r;
+  o->names=o->known=o->bad=0;
+  r=xjs_parser_keys(p, o->keys);
+  if (r==XJS_OK) r=xjs_parser_options(p, opts);
+  if ((r==XJS_OK)&&(how==2)) r=xjs_parser_batch(p, o->ev, 16, batchcb);
+  if ((r==XJS_OK)&&(piece==0)) r=xjs_parser_parse(p, json, len, NULL, NULL, &err);
+  else if (r==XJS_OK)
+  { for (k=0;(k<len)&&((r==XJS_OK)||(r==XJS_MORE));k+=piece) r=xjs_feed(p, json+k, (len-k<piece)?len-k:piece, &err);
+    if ((r==XJS_OK)||(r==XJS_MORE)) r=xjs_finish(p, &err);
+  }
+  xjs_parser_free(p);
+  return r;
+}
+
+int main(void)
+{ static char *names[NKEYS], json[NMEMBERS*64]; static const char *hows[]={ "node", "view", "batch" };
+  static const size_t pieces[]={ 0, 1, 3, 17, 4096 };
+  Out o; XJSKeys *keys=NULL, *twice=NULL; size_t len=0; int i, how, opts, j, r, fails=0, escaped=0;
+  const char *dup[]={ "a", "b", "a" };
+  for (i=0;i<NKEYS;i++) { names[i]=(char*)malloc(16); sprintf(names[i], "k%d", i); }
+  if ((r=xjs_keys_new(&keys, (const char *const *)names, NKEYS, NULL))!=XJS_OK) { printf("keys: r=%d\n", r); return 1; }
+  if ((r=xjs_keys_new(&twice, dup, 3, NULL))!=XJS_ERR_USAGE) { printf("a name twice: r=%d\n", r); fails++; xjs_keys_free(twice); }
+  if (xjs_key(keys, "k1")!=XJS_KEY_UNKNOWN) { printf("a copy of a name has an id\n"); fails++; } // ids come from the dictionary's copies
+  // every member name, some with the k escaped, in objects and arrays
+  len+=(size_t)sprintf(json+len, "{");
+  for (i=0;i<NMEMBERS;i++)
+  { if (i) json[len++]=',';
+    if (i%7==3) { len+=(size_t)sprintf(json+len, "\"\\u006b%d\":", i); if (i<NKEYS) escaped++; }
+    else len+=(size_t)sprintf(json+len, "\"k%d\":", i);
+    switch (i%4)
+    { case 0: len+=(size_t)sprintf(json+len, "%d", i); break;
+      case 1: len+=(size_t)sprintf(json+len, "\"k%d\"", i); break;  // a value is never a key
+      case 2: len+=(size_t)sprintf(json+len, "[{\"k%d\":null},\"x\"]", (i+1)%NKEYS); break;
+      default: len+=(size_t)sprintf(json+len, "{}"); break;
+    }
+  }
+  len+=(size_t)sprintf(json+len, ",\"\":1,\"k\":2,\"k1x\":3}");
+  o.keys=keys;
+  for (how=0;how<3;how++) for (opts=0;opts<=XJS_OPT_DECODE;opts+=XJS_OPT_DECODE) for (j=0;j<(int)(sizeof(pieces)/sizeof(pieces[0]));j++)
+  { int known=NKEYS+NMEMBERS/4-((opts)?0:escaped); // the names, and those in the arrays (all known), less the escaped ones unless decoded
+    if ((r=parse(&o, json, len, how, opts, pieces[j]))!=XJS_OK) { printf("%s%s, pieces %lu: r=%d\n", hows[how], (opts)?", decoded":"", (unsigned long)pieces[j], r); fails++; }
+    else if ((o.bad)||(o.known!=known)) { printf("%s%s, pieces %lu: %d of %d names known (not %d), %d wrong\n", hows[how], (opts)?", decoded":"", (unsigned long)pieces[j], o.known, o.names, known, o.bad); fails++; }
+  }
+  xjs_keys_free(keys);
+  for (i=0;i<NKEYS;i++) free(names[i]);
+  return (fails)?1:0;
+}
+
+/* EOF */
@@ -0,0 +1,65 @@
+/* ---------------------------------------------------------------------------
+** test_write : values larger than the writer's buffer, with a buffer that
+** grows and with a flush callback
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+*/
+#include "xjs.h"
+#include "xjs_write.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+typedef struct { char *p; XJSSize n, size; } Out;
+
+static int flushcb(const char *data, XJSSize len, void *flush_arg)
+{ Out *o=(Out*)flush_arg;
+  if (o->n+len>o->size) return XJS_ERR;
+  memcpy(o->p+o->n, data, len); o->n+=len;
+  return XJS_OK;
+}
+
+/* ["v","v"] with each v n bytes, then a number of n digits, checked against the output. */
+static int check(const char *mode, const char *out, XJSSize len, const char *v, XJSSize n)
+{ XJSSize want=1+(n+2)+1+(n+2)+1+n+1;
+  if ((len!=want)||(out[0]!='[')||(out[1]!='"')||(memcmp(out+2, v, n)!=0)||(memcmp(out+n+5, v, n)!=0)||(out[len-1]!=']'))
+  { printf("%s: %lu bytes, bad output (%lu expected)\n", mode, (unsigned long)n, (unsigned long)want); return 1; }
+  return 0;
+}
+
+static int write_all(XJSWriter *w, const char *v, const char *d, XJSSize n)
+{ int r;
+  if ((r=xjs_write(w, XJS_array, NULL, 0, NULL, 0))!=XJS_OK) return r;
+  if ((r=xjs_write(w, XJS_string, NULL, 0, v, n))!=XJS_OK) return r;
+  if ((r=xjs_write(w, XJS_string, NULL, 0, v, n))!=XJS_OK) return r;
+  if ((r=xjs_write(w, XJS_number, NULL, 0, d, n))!=XJS_OK) return r;
+  if ((r=xjs_write(w, XJS_array_end, NULL, 0, NULL, 0))!=XJS_OK) return r;
+  return xjs_writer_finish(w);
+}
+
+int main(void)
+{ static const XJSSize sizes[]={ 1, 63, 64, 65, 100, 4095, 70000, 1<<20, 0 };
+  static const XJSSize bufs[]={ 0, 64, 100, 4096, (XJSSize)-1 };
+  int i, j, fails=0, r; XJSSize n, len; char *v, *d; const char *data; Out o;
+  for (i=0; sizes[i]; i++) 
+  { n=sizes[i]; v=(char*)malloc(n); d=(char*)malloc(n);
+    memset(v, 'x', n); memset(d, '7', n); 
+    o.size=3*n+16; o.p=(char*)malloc(o.size);
+    for (j=0; bufs[j]!=(XJSSize)-1; j++)
+    { XJSWriter *w=xjs_writer_new(NULL, NULL, bufs[j], 0, NULL); // grows
+      if ((r=write_all(w, v, d, n))!=XJS_OK) { printf("grow: %lu bytes, buffer %lu: r=%d\n", (unsigned long)n, (unsigned long)bufs[j], r); fails++; }
+      else { data=xjs_writer_data(w, &len); fails+=check("grow", data, len, v, n); }
+      xjs_writer_free(w);
+      o.n=0; w=xjs_writer_new(flushcb, &o, bufs[j], 0, NULL); // flushes
+      if ((r=write_all(w, v, d, n))!=XJS_OK) { printf("flush: %lu bytes, buffer %lu: r=%d\n", (unsigned long)n, (unsigned long)bufs[j], r); fails++; }
+      else fails+=check("flush", o.p, o.n, v, n);
+      xjs_writer_free(w);
+    }
+    free(o.p); free(v); free(d);
+  }
+  return (fails)?1:0;
+}
+
+/* EOF */
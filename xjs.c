@@ -29,12 +29,21 @@
 
 #include "xjs.h"
 
-#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK 
+#include <string.h>
 #include <stdlib.h>
+
+#if !defined(XJS_CFLAG_DISABLE_SIMD) && (defined(__GNUC__)||defined(__clang__)) && (defined(__x86_64__)||(defined(__i386__)&&defined(__SSE2__)))
+#define IXJS_SIMD_X86
+#include <immintrin.h>
 #endif
 
-#ifndef XJS_CFLAG_DISABLE_ARRAY_POS_AS_NAME  
-#include <stdio.h>
+#ifdef XJS_CFLAG_ENABLE_STATS
+#if (defined(__GNUC__)||defined(__clang__)) && (defined(__x86_64__)||defined(__i386__))
+#define IXJS_STATS_TSC
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
 #endif
 
 #if !defined(NULL)
@@ -48,14 +57,57 @@ extern "C" {
 /*
 ** ---------------------------------------------------------------------------
 ** These are the allocation suggested sizes when calling the memory manager.
-** IXJS_MEM_STR_BLOCK_SIZE - Suggested 256 bytes for String/Value size.
+** IXJS_MEM_STR_BLOCK_SIZE - Suggested 256 bytes for String/Value size, a
+** string that outgrows its storage asks for twice as much.
 ** IXJS_MEM_HEADER_BLOCK_SIZE - Suggested 256 block array elements (Alloc 256xptr).
+** IXJS_COL_ROWS - Records in a batch of block columns, unless the parser is
+** given another number (xjs_parser_columns).
+** IXJS_BATCH_TEXT - Suggested 4 KB for the copies of a batch of events.
 ** ---------------------------------------------------------------------------
 */
 #define IXJS_MEM_STR_BLOCK_SIZE  256  
+#define IXJS_BATCH_TEXT  4096
 
 #ifdef XJS_CFLAG_ENABLE_BLOCKS
 #define IXJS_MEM_HEADER_BLOCK_SIZE  256
+#define IXJS_COL_ROWS  1024
+#endif
+
+/*
+** IXJS_BIX_EVERY - Records between the marks of a block index, unless
+** xjs_block_index_new is given another number.
+*/
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+#define IXJS_BIX_EVERY  1024
+#endif
+
+/* 
+** IXJS_MEM_STACK_SIZE - Container frames kept on the C stack by xjs_parse, and
+** the first allocation of a push parser. Deeper input grows the stack with the
+** memory manager (XJS_parser).
+** IXJS_MAX_DEPTH - Deepest container nesting allowed unless the parser is
+** given another limit (xjs_parser_limit), XJS_CFLAG_MAX_DEPTH overrides it.
+*/
+#define IXJS_MEM_STACK_SIZE  16
+
+/*
+** IXJS_MEM_ARENA_LOCAL - Bytes on the C stack for the first chunk of the
+** arena xjs_parse uses when it has no memory manager callback.
+** IXJS_MEM_ARENA_CHUNK, IXJS_MEM_ARENA_MAX - The size of the first chunk
+** taken from libc, the next ones double up to IXJS_MEM_ARENA_MAX (a bigger
+** allocation gets a chunk of its own size).
+*/
+#define IXJS_MEM_ARENA_LOCAL  2048
+#define IXJS_MEM_ARENA_CHUNK  4096
+#define IXJS_MEM_ARENA_MAX    (1024*1024)
+
+/* IXJS_OPT_ALL - the XJS_OPT_* flags xjs_parser_options knows */
+#define IXJS_OPT_ALL  (XJS_OPT_DECODE|XJS_OPT_INDEX|XJS_OPT_SEQ)
+
+#ifdef XJS_CFLAG_MAX_DEPTH
+#define IXJS_MAX_DEPTH  XJS_CFLAG_MAX_DEPTH
+#else
+#define IXJS_MAX_DEPTH  1024
 #endif
 
 /*
@@ -77,8 +129,16 @@ const char *xjs_desc_type(XJSType nodetype)
     case XJS_false            : return "false";
     case XJS_null             : return "null";
     case XJS_name             : return "name";
+    case XJS_parser           : return "parser";
+    case XJS_index            : return "index";
+    case XJS_dom              : return "dom";
+    case XJS_filter           : return "filter";
+    case XJS_keys             : return "keys";
+    case XJS_write            : return "write";
+    case XJS_file             : return "file";
     case XJS_array_end        : return "array_end";
     case XJS_object_end       : return "object_end";
+    case XJS_document_end     : return "document_end";
 #ifdef XJS_CFLAG_ENABLE_BLOCKS
     case XJS_block            : return "block";
     case XJS_block_end        : return "block_end";
@@ -110,6 +170,12 @@ const char *xjs_desc_error(int code)
     case XJS_ERR_BAD_LITERAL      : return "invalid input regarding a literal";
     case XJS_ERR_CONTROL_CHAR     : return "ascii control characters not allowed in strings or values";
     case XJS_ERR_MORE_INPUT       : return "input remaining after first level object/array complete";
+    case XJS_ERR_BAD_UTF8         : return "invalid UTF-8 sequence in a string";
+    case XJS_MORE                 : return "the input ended inside the document, feed more";
+    case XJS_ERR_DEPTH            : return "containers are nested deeper than the limit";
+    case XJS_ERR_BAD_SURROGATE    : return "unpaired UTF-16 surrogate in a \\u escape";
+    case XJS_ERR_IO               : return "a file could not be opened, mapped or read";
+    case XJS_SKIP                 : return "skip the contents of the container (from a callback)";
 #ifdef XJS_CFLAG_ENABLE_BLOCKS
     case XJS_ERR_BLOCK_ARRAY_SIZE : return "block arrays must all be the same size (including header)";
 #endif
@@ -118,344 +184,3323 @@ const char *xjs_desc_error(int code)
 }
 #endif
 
+typedef unsigned long long IXJSU64;
+
 /*
-** Internal funcntion prototypes
+** ---------------------------------------------------------------------------
+** A string or number token. While the token lies inside the current input
+** buffer it is only a view (p,n) into the input. The text is copied into
+** mem (from the memory manager) when the token crosses the end of a buffer,
+** or when the callback needs null terminated text (XJSNodeCB).
+** ---------------------------------------------------------------------------
+*/
+typedef struct IXJSStr
+{ const char *p;       /* the text, NULL for an empty copy (like the original API) */
+  XJSSize n;           /* length of the text */
+  const char *seg;     /* start of the part of the token in the current input buffer */
+  char *mem;           /* storage from the memory manager once copied */
+  XJSSize mxsz;        /* size of mem */
+  XJSType context;     /* the memory manager context for mem */
+  int copied;          /* the text is (being) collected in mem */
+} IXJSStr;
+
+/*
+** States of the resumable engine (see i_run), between tokens and in a token.
 ** ---------------------------------------------------------------------------
 */
-static int r_parse_any(int top, const char **jsp, void *parent, const char *name, XJSNodeCB node_cb, void *node_arg, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb);
-static int i_parse_array(char ***hdr, XJSType kind, int *cnt, const char **jsp, void *parent, const char *name, XJSNodeCB node_cb, void *node_arg, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb);
-static int i_parse_object(const char **jsp, void *parent, const char *name, XJSNodeCB node_cb, void *node_arg, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb);
-static int i_parse_value(const char **jsp, XJSType *kind, char **value, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb);
-static int i_parse_string(const char **jsp, char **value, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb, XJSType context);
-static int i_parse_literal(const char **jsp, const char *lit, char **value, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg);
-static int i_parse_number(const char **jsp, char **value, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb);
-static int i_parse_escape(const char **jsp, char **escape, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb, XJSType context);
-static int i_eatwhite(const char **jsp, XJSInputCB inp_cb, void *inp_arg);
-static int i_assign(const char **jsp, char **to, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb, XJSType context);
-static int i_advance(int ew, const char **jsp, XJSInputCB inp_cb, void *inp_arg);
-static int i_noend(int r) { if (r==XJS_END) return XJS_ERR_BAD_INPUT; return r; }
+#define IXJS_S_VALUE  0   /* a value, at the top level only a container (any value with XJS_OPT_SEQ) */
+#define IXJS_S_FIRST  1   /* the first element or the end of an array */
+#define IXJS_S_KEY0   2   /* the first member name or the end of an object */
+#define IXJS_S_KEY    3   /* a member name */
+#define IXJS_S_COLON  4   /* the colon after a member name */
+#define IXJS_S_NEXT   5   /* a comma or the end of the container */
+#define IXJS_S_HDR    6   /* blocks: the header array or the end of the block */
+#define IXJS_S_REC    7   /* blocks: a record array */
+#define IXJS_S_DONE   8   /* the document is complete, white space may follow (not with XJS_OPT_SEQ) */
+#define IXJS_S_STR    9   /* inside a string (name or value) */
+#define IXJS_S_NUM    10  /* inside a number */
+#define IXJS_S_LIT    11  /* inside a literal */
+#define IXJS_S_SKIP   12  /* in a container the callback skipped (XJS_SKIP) or the filter dropped, subn brackets are open */
+#define IXJS_S_STOP   13  /* the filter has seen every path, the rest of the input is not parsed */
+
+#define IXJS_T_ESC    1   /* string: the character after a backslash */
+#define IXJS_T_HEX    2   /* string: subn hex digits of a \u escape */
+#define IXJS_T_UTF8   3   /* string: subn continuation bytes of a UTF-8 sequence */
+#define IXJS_T_LOW    4   /* string: the backslash of the low surrogate after a high one (decoding) */
+#define IXJS_T_LOWU   5   /* string: the u of the low surrogate */
+#define IXJS_T_SIGN   1   /* number: after the minus sign */
+#define IXJS_T_ZERO   2   /* number: after a leading zero */
+#define IXJS_T_INT    3   /* number: in the integer digits */
+#define IXJS_T_DOT    4   /* number: after the decimal point */
+#define IXJS_T_FRAC   5   /* number: in the fraction digits */
+#define IXJS_T_EXP    6   /* number: after the exponent marker */
+#define IXJS_T_ESIGN  7   /* number: after the exponent sign */
+#define IXJS_T_EXPD   8   /* number: in the exponent digits */
+#define IXJS_T_QUOTE  1   /* skip: inside a string */
+#define IXJS_T_QESC   2   /* skip: the character after a backslash in a string */
 
+/*
+** ---------------------------------------------------------------------------
+** An open container on the stack of the resumable engine (see i_run).
+** stk[0] stands for the document itself.
+** ---------------------------------------------------------------------------
+*/
+typedef struct 
+{ XJSType kind;        /* XJS_object, XJS_array, a block kind, or XJS_unknown for the document */
+  void *np;            /* parent the callback set for the nodes in this container */
+  long long ev;        /* batches: number of the event that opened it, -1 for the document */
+  XJSSize cnt;         /* number of values completed */
+  IXJSStr key;         /* objects: name of the current member */
+  IXJSU64 fl;          /* filter: the paths the container is on (bit per path), 0 when all of it is signaled */
 #ifdef XJS_CFLAG_ENABLE_BLOCKS
-static int i_parse_block(const char **jsp, void *parent, const char *name, XJSNodeCB node_cb, void *node_arg, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb);
+  char **hdr;          /* blocks: the header names (hn of them in tcnt slots, tcnt<0 once refused) */
+  int hn, tcnt, hcnt;  /* hcnt is the number of fields in the header, -1 in a record that is passed over (i_bix_rec) */
 #endif
+} IXJSFrame;
 
 /*
-** Default memory management using libc malloc/free/realloc. 
+** ---------------------------------------------------------------------------
+** A compiled path filter (xjs_filter_new), one allocation. Each path is a
+** list of segments: a member name, an array index, or a wildcard.
 ** ---------------------------------------------------------------------------
 */
-#ifdef XJS_CFLAG_DISABLE_MEM_FALLBACK
-static XJSMemCB i_mem_fallback = NULL;
-#else
-static void *i_mem_fallback(XJSMemReq action, XJSType context, void *prev, XJSSize size, XJSSize *actsz)
-{ void *ret=NULL; if (actsz) *actsz=0; // on realloc, prev!=NULL and actsz will be the last size of prev.
-  if (action==XJS_free) free(prev);
-  else if (action==XJS_alloc)
-  { if (prev) ret=realloc(prev, size);
-    else ret=malloc(size);
-  }
-  if ((ret)&&(actsz)) *actsz=size;
-  return ret;
-}
+#define IXJS_FILTER_MAX  64    /* paths in a filter, a bit each in IXJSFrame.fl */
+
+typedef struct 
+{ const char *s;       /* the name (unescaped), NULL for the wildcard */
+  XJSSize n;           /* length of the name */
+  XJSSize idx;         /* the array index the name spells, or (XJSSize)-1 */
+} IXJSFSeg;
+
+typedef struct { IXJSFSeg *seg; int nseg; } IXJSFPath;
+
+struct XJSFilter
+{ XJSMemCB mem_cb;
+  IXJSFPath *path; int n, flags;
+  IXJSU64 all;         /* the paths below the document, 0 if one is the whole document */
+  IXJSU64 need;        /* the paths without a wildcard, for XJS_FILTER_STOP */
+};
+
+/*
+** ---------------------------------------------------------------------------
+** A key dictionary (xjs_keys_new), one allocation. A perfect hash: the hash
+** of a name picks a bucket, the bucket's displacement d picks the slot
+** (h1+d*h2) where the only key that can match is, see i_key_find. Each
+** name is stored after its id, so xjs_key maps the pointer back to the id.
+** ---------------------------------------------------------------------------
+*/
+typedef struct { const char *s; XJSSize n; } IXJSKey;
+
+struct XJSKeys
+{ XJSMemCB mem_cb;
+  IXJSKey *key;        /* the names by id */
+  unsigned *disp;      /* displacement of each bucket */
+  int *slot;           /* the id in each slot, or -1 */
+  const char *text, *tend; /* the names, each after its id (an int) and null terminated */
+  IXJSU64 seed;
+  int n, sbits, bmask; /* keys, log2 of the slots, buckets-1 */
+};
+
+/*
+** ---------------------------------------------------------------------------
+** Batched events (xjs_parser_batch). Names and values that are not views of
+** the current input buffer are copied into text, the batch is passed on
+** before the copies would not fit, and before the input moves on.
+** ---------------------------------------------------------------------------
+*/
+typedef struct
+{ XJSBatchCB cb;       /* batch callback, or NULL */
+  XJSEvent *ev;        /* the caller's array */
+  int size, n;         /* events it holds, and events in it so far */
+  long long seq;       /* number of the first event in it */
+  char *text;          /* copies of the events in it */
+  XJSSize tn, tsz;     /* bytes of text used, and its size */
+} IXJSBatch;
+
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+/*
+** ---------------------------------------------------------------------------
+** Block columns (xjs_parser_columns). The fixed size vectors of every column
+** are one allocation (mem), the text of each column grows on its own (tsz).
+** Only one block is collected at a time, a block in a cell is text.
+** ---------------------------------------------------------------------------
+*/
+typedef struct
+{ XJSColumnCB cb;      /* column callback, or NULL */
+  int rows;            /* records per batch */
+  int on;              /* the records of the open block are collected */
+  int n;               /* records in the batch so far */
+  XJSSize first;       /* records of the block before the batch */
+  XJSColumn *col; int ncol;
+  XJSSize *tsz;        /* size of each column's text storage */
+  void *mem;
+} IXJSCols;
+
+/*
+** ---------------------------------------------------------------------------
+** A block index (xjs_block_index_new). The marks are their own allocation,
+** the index and the header names (null terminated, one after the other)
+** are one. IXJSBix is the state while one is built.
+** ---------------------------------------------------------------------------
+*/
+struct XJSBlockIndex
+{ XJSMemCB mem_cb;
+  XJSSize every;       /* records from one mark to the next */
+  XJSSize nrec, nmark; /* records in the block, and marks (one for every record k*every) */
+  XJSSize *mark;       /* offset of each marked record's open bracket in the document */
+  XJSSize end;         /* offset of the close parenthesis of the block */
+  int ncol;            /* fields in the header */
+  const char **name;   /* the header names, in text */
+  const char *text; XJSSize ntext;
+};
+
+typedef struct
+{ struct IXJSCtx *c; 
+  XJSMemCB m;
+  XJSSize every, nrec, nmark, msz, end;
+  XJSSize *mark;       /* the marks so far, msz of them fit */
+  char *text;          /* the header names so far */
+  XJSSize ntext, tsz;
+  int ncol, in;        /* in: the block (the document) has started */
+} IXJSBix;
 #endif
 
-/* ---------------------------------------------------------------------------
-** USER FUNCTION
-** returns XJS_OK or an error code
+/*
+** ---------------------------------------------------------------------------
+** The arena. Storage is bumped out of chunks, a chunk from libc (or the
+** caller's stack) at a time. Every allocation has a small header with its
+** size and the allocation before it, so giving back the last one (and then
+** the one before, like a stack) or growing it is done in place. Others are
+** only released when the arena is reset or freed. A reset keeps the chunks
+** for the next parse.
 ** ---------------------------------------------------------------------------
 */
-int xjs_parse(const char *json, XJSNodeCB node_cb, void *node_arg, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb, const char **errpos)
-{ int r; *errpos=NULL; const char *js=json;
-  if (mem_cb==NULL) mem_cb=i_mem_fallback;
-  if (mem_cb==NULL) return XJS_ERR_MEM_MISSING;
-  if (js==NULL)
-  { if (inp_cb==NULL) return XJS_ERR_NO_INPUT;
-    if ((r=inp_cb(&js, inp_arg))!=XJS_OK) return r;
-  }
-  if (js==NULL) return XJS_ERR_BAD_INPUT;  
-  r=r_parse_any(1, &js, NULL, NULL, node_cb, node_arg, inp_cb, inp_arg, mem_cb);
-  if (*js) i_eatwhite(&js, inp_cb, inp_arg);
-  if (*js) r=XJS_ERR_MORE_INPUT;
-  *errpos=js; 
-  return (r==XJS_END)?XJS_OK:r;
-}
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+typedef struct IXJSChunk
+{ struct IXJSChunk *next;
+  XJSSize size, used;  /* bytes of storage after the header, and bytes handed out */
+  int own;             /* from libc, otherwise the caller's */
+} IXJSChunk;
 
-/* ---------------------------------------------------------------------------
-** Parse a JSON array, return XJS_NOPE is the input does not start correctly
-** <white> '[' <white> (',' <white> <any> <white>)* ']' 
-** COMMA only after first item.
+typedef struct { XJSSize size; char *prev; } IXJSBlk; /* in front of every allocation */
+
+struct XJSArena
+{ IXJSChunk *first, *cur; /* the chunks in order, and the one being used */
+  XJSSize grow;           /* size of the next chunk from libc */
+  char *top;              /* the last allocation in cur, or NULL */
+};
+
+#define IXJS_ARENA_ALIGN    16
+#define IXJS_ARENA_UP(n)    (((n)+(IXJS_ARENA_ALIGN-1))&~(XJSSize)(IXJS_ARENA_ALIGN-1))
+#define IXJS_ARENA_HDR      IXJS_ARENA_UP(sizeof(IXJSBlk))
+#define IXJS_CHUNK_DATA(ch) ((char*)(ch)+IXJS_ARENA_UP(sizeof(IXJSChunk)))
+#endif
+
+/*
+** ---------------------------------------------------------------------------
+** Parse context, everything the internal functions share for one parse.
+** The input is consumed from the range [cur,end), when cur reaches end the
+** input callback is asked for the next buffer. Once the input is exhausted
+** cur and end are parked on i_eof so *cur can always be read (as 0). 
+**
+** Before the current buffer is given up, the token being scanned (tok) and
+** the member names on the stack are copied out of it.
+**
+** The engine keeps everything it needs to continue in here: the containers
+** (stk), where it is between tokens (st), and where it is in a token (sub).
+** Pushed input (xjs_feed) returns XJS_MORE at the end of each buffer instead
+** of asking the input callback.
 ** ---------------------------------------------------------------------------
 */
-static int i_parse_array(char ***hdr, XJSType kind, int *cnt, const char **jsp, void *parent, const char *name, XJSNodeCB node_cb, void *node_arg, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb)
-{ XJSSize actsz=0; int i=0, tcnt=0, r=XJS_OK; void *np=parent;
-  char *pos=NULL;
-#ifndef XJS_CFLAG_DISABLE_ARRAY_POS_AS_NAME  
-  char p_pos[40]; pos=p_pos; // the position in the array as text, passed in the item name field.
-#endif  
-  if (cnt) *cnt=0; // cnt can be null for non block arrays!
-  if ((r=i_eatwhite(jsp, inp_cb, inp_arg))!=XJS_OK) return r;
-  if ((**jsp)!='[') return XJS_NOPE; // this is not an array!
-  if ((r=node_cb(&np, kind, name, NULL, node_arg))!=XJS_OK) return r;
-  if ((r=i_advance(1, jsp, inp_cb, inp_arg))!=XJS_OK) return i_noend(r); 
-#ifdef XJS_CFLAG_ENABLE_BLOCKS
-    if (kind==XJS_block_array) if (hdr) if (*hdr==NULL) hdr=NULL;
-#endif
-  while ((**jsp)!=']')  
-  { if (i++!=0) if ((**jsp)!=',') return XJS_ERR_EXP_COMMA; else if ((r=i_advance(0, jsp, inp_cb, inp_arg))!=XJS_OK) return i_noend(r); 
-#ifndef XJS_CFLAG_DISABLE_ARRAY_POS_AS_NAME  
-      snprintf(pos, 40, "%d", i);
+typedef struct IXJSCtx
+{ const char *cur;     /* current position in the input */
+  const char *end;     /* end of the current input buffer (exclusive) */
+  const char *eofpos;  /* end of the last real input buffer, reported as errpos at end of input */
+  const char *buf;     /* start of the current input buffer */
+  XJSSize bufpos;      /* offset of buf in the whole input */
+  XJSNodeCB node_cb;   /* node callback (null terminated copies) */
+  XJSNodeViewCB view_cb; /* node callback (views into the input), only one is set */
+  XJSNodeDescCB desc_cb; /* node callback (a descriptor, views into the input) */
+  XJSNumberCB num_cb;  /* typed numbers instead of node_cb/view_cb, if set */
+  void *node_arg;
+  XJSInputNCB inp_cb;  /* input callback and its argument, NULL once the input has ended */
+  void *inp_arg;
+  XJSMemCB mem_cb;     /* memory manager, NULL when all the storage is from the arena */
+  XJSArena *arena;     /* storage for the parse instead of mem_cb, see i_mem */
+  IXJSStr *tok;        /* the token being scanned, or NULL */
+  IXJSFrame *stk;      /* container stack, stk[depth] is the innermost */
+  int depth, stksz;
+  int mxdepth;         /* deepest nesting allowed */
+  int stkmem, stkfix;  /* stk is from the memory manager, or from the caller (it can't grow) */
+  int st;              /* IXJS_S_* state of the engine */
+  int sub, subn;       /* IXJS_T_* state inside a token, and a count for it */
+  unsigned char lo, hi; /* range of the next byte of a UTF-8 sequence */
+  unsigned cp, hs;     /* decoding: the \u code unit being read, a high surrogate waiting for its low one */
+  const char *lit;     /* rest of the literal being matched */
+  XJSType vkind;       /* kind of the token being scanned, XJS_name for member names */
+  IXJSStr val;         /* the value being scanned */
+  IXJSStr slot;        /* name of an array element, see i_slot */
+  char pos[24];
+  int views;           /* names and values are views, not null terminated copies (all but XJSNodeCB) */
+  XJSSize vpos;        /* offset in the whole input of the scalar being scanned (XJSNodeDescCB) */
+  int opts;            /* XJS_OPT_* */
+  const XJSFilter *filt; /* path filter, see i_filter */
+  const XJSKeys *keys; /* key dictionary, member names in it are interned (i_tok_end) */
+  IXJSBatch bat;       /* batched events instead of the node callbacks, see i_batch_put */
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  IXJSCols cols;       /* block columns, see i_col_begin */
+  IXJSBix *bix;        /* the block index being built, records are passed over (i_bix_rec) */
+  XJSSize bskip, brem; /* seek (xjs_parser_block): records to pass over, then the records left to parse (0 for all) */
+#endif
+  IXJSU64 fl;          /* filter: the paths of the container being opened */
+  IXJSU64 fseen;       /* filter: the paths matched so far */
+  int fend;            /* filter: stop when a value at a depth below fend is complete (XJS_FILTER_STOP), or 0 */
+  int drop;            /* the value being scanned is filtered out, it is not kept or signaled */
+  int elem;            /* the input is elements of an array (xjs_parser_elements), stk[1] is the array */
+  unsigned *ix;        /* structural index of [ixb,end) (XJS_OPT_INDEX), see i_index */
+  XJSSize ixn, ixk, ixsz; /* entries, the next one, and room for them */
+  const char *ixb;
+  const char *ixs, *ixq; /* the string starting at ixs has no escapes and ends at ixq */
+  int more;            /* pushed input, XJS_MORE at the end of a buffer */
+  int fed;             /* any input was pushed */
+  int err;             /* pushed input, the error that stopped the parse */
+#ifdef XJS_CFLAG_ENABLE_STATS
+  XJSStats *stats;     /* counts, see xjs_parser_stats, or NULL */
+#endif
+} IXJSCtx;
+
+struct XJSParser 
+{ IXJSCtx c; 
+  IXJSFrame stk[IXJS_MEM_STACK_SIZE]; /* the first frames of the container stack */
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+  XJSArena a;                         /* storage when the parser has no memory manager */
+#endif
+};
+
+static const char i_eof[1]={0};
+
+/*
+** Internal funcntion prototypes
+** ---------------------------------------------------------------------------
+*/
+static void i_ctx_init(IXJSCtx *c, XJSNodeCB node_cb, XJSNodeViewCB view_cb, void *node_arg, XJSMemCB mem_cb, IXJSFrame *stk, int stksz);
+static int i_parse_pull(IXJSCtx *c, const char *json, XJSSize len, const char **errpos);
+static int i_parse_local(IXJSCtx *c, const char *json, XJSSize len, const char **errpos);
+static void *i_mem(IXJSCtx *c, XJSMemReq action, XJSType context, void *prev, XJSSize size, XJSSize *actsz);
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+static void i_arena_init(XJSArena *a, void *buf, XJSSize size);
+static void i_arena_release(XJSArena *a);
+static void *i_arena_alloc(XJSArena *a, XJSSize size);
+static void *i_arena_grow(XJSArena *a, char *p, XJSSize size);
+static void i_arena_pop(XJSArena *a, char *p);
+#endif
+static int i_eatwhite(IXJSCtx *c);
+static int i_eatwhite_ix(IXJSCtx *c);
+static int i_index(IXJSCtx *c, const char *json, XJSSize len);
+static void i_index_free(IXJSCtx *c);
+static int i_refill(IXJSCtx *c);
+static int i_emit(IXJSCtx *c, IXJSFrame *f, void **np, XJSType kind, const IXJSStr *name, const IXJSStr *value);
+static int i_emit_num(IXJSCtx *c, void **np, const IXJSStr *name, const IXJSStr *value);
+static int i_emit_desc(IXJSCtx *c, IXJSFrame *f, void **np, XJSType kind, const IXJSStr *name, const IXJSStr *value);
+static int i_batch_put(IXJSCtx *c, IXJSFrame *f, XJSType kind, const IXJSStr *name, const IXJSStr *value);
+static int i_batch_flush(IXJSCtx *c);
+static XJSSize i_batch_need(IXJSCtx *c, const IXJSStr *s);
+static const char *i_batch_str(IXJSCtx *c, const IXJSStr *s, XJSSize *n);
+#ifdef XJS_CFLAG_ENABLE_STATS
+static unsigned long long i_ticks(void);
+static void i_stats_node(XJSStats *st, XJSType kind, const IXJSStr *value);
+static void i_stats_mem(XJSStats *st, XJSMemReq action, void *prev, XJSSize size);
+static void i_stats_done(IXJSCtx *c, unsigned long long t, unsigned long long cb);
+#endif
+static int i_num_decode(const char *p, const char *e, XJSNumber *num);
+static void i_str_init(IXJSStr *s, XJSType context, const char *p, XJSSize n);
+static int i_str_append(IXJSCtx *c, IXJSStr *s, const char *src, XJSSize len);
+static int i_str_copy(IXJSCtx *c, IXJSStr *s);
+static void i_str_free(IXJSCtx *c, IXJSStr *s);
+static void i_tok_begin(IXJSCtx *c, IXJSStr *s);
+static int i_tok_end(IXJSCtx *c, IXJSStr *s);
+static XJSSize i_strlen(const char *s) { const char *p=s; while (*p) p++; return (XJSSize)(p-s); }
+
+static int i_run(IXJSCtx *c);
+static int i_run_stop(IXJSCtx *c, int r);
+static int i_run_between(IXJSCtx *c);
+static int i_run_begin(IXJSCtx *c, IXJSFrame *f, char ch);
+static int i_run_open(IXJSCtx *c, XJSType kind);
+static void i_frame_init(IXJSFrame *f, XJSType kind, void *np);
+static int i_run_close(IXJSCtx *c, IXJSFrame *f);
+static int i_run_done(IXJSCtx *c, IXJSFrame *f);
+static int i_run_value(IXJSCtx *c, IXJSFrame *f, XJSType kind, IXJSStr *value);
+static int i_run_strend(IXJSCtx *c, IXJSFrame *f);
+static int i_run_string(IXJSCtx *c);
+static int i_run_seq(IXJSCtx *c);
+static int i_esc_begin(IXJSCtx *c, const char *p);
+static int i_esc_unit(IXJSCtx *c);
+static int i_esc_put(IXJSCtx *c, unsigned u);
+static int i_run_number(IXJSCtx *c);
+static int i_run_literal(IXJSCtx *c);
+static int i_run_skip(IXJSCtx *c);
+static int i_run_skip_ix(IXJSCtx *c);
+static int i_run_drop(IXJSCtx *c, XJSType kind);
+static int i_run_undrop(IXJSCtx *c, IXJSFrame *f);
+static int i_filter(IXJSCtx *c, IXJSFrame *f, char ch);
+static IXJSU64 i_key_hash(IXJSU64 seed, const char *p, XJSSize n);
+static int i_key_place(XJSKeys *k, const IXJSU64 *h, int *order, const int *first);
+static const char *i_key_find(const XJSKeys *k, const char *p, XJSSize n);
+static const IXJSStr *i_slot(IXJSCtx *c, IXJSFrame *f);
+#ifndef XJS_CFLAG_DISABLE_ARRAY_POS_AS_NAME
+static XJSSize i_utoa(char *b, XJSSize v);
 #endif
+static int i_stack_grow(IXJSCtx *c);
+static void i_stack_free(IXJSCtx *c);
 #ifdef XJS_CFLAG_ENABLE_BLOCKS
-    if (kind==XJS_block_header) 
-    { if ((hdr) && (((*cnt)==0)||(((*cnt)+1)>=tcnt))) 
-      { *hdr=(char**)mem_cb(XJS_alloc, XJS_block_header, (void*)(*hdr), ((*cnt)+IXJS_MEM_HEADER_BLOCK_SIZE)*sizeof(char*), &actsz);
-        tcnt=((*hdr)==NULL)?0:(int)(actsz/(sizeof(char*))); // max(tcnt) is probably less than max(actsz/ptrsz)
-        if ((*hdr)==NULL) hdr=NULL; // short circut any more header storage requests if the memory manager rejected the first request.
-      }
-      XJSSize mxsz=0, used=0; char *value=NULL; // value will be freed by the caller as part of hdr.
-      if ((r=i_parse_string(jsp, &value, &mxsz, &used, inp_cb, inp_arg, mem_cb, XJS_name))!=XJS_OK) return i_noend(r);
-      r=node_cb(&np, XJS_name, pos, value, node_arg);
-      if ((hdr)&&(tcnt>(*cnt))) (*hdr)[*cnt] = value;  // remember the name
-      else mem_cb(XJS_free, XJS_name, value, 0, NULL); // forget the name
-      // caller of parse_array must clean up the header, even on error
-    }
-    else
-#endif /* BLOCKS */
-    r=r_parse_any(0, jsp, np, ((hdr==NULL)||(kind==XJS_array))?pos:((*hdr)[*cnt]), node_cb, node_arg, inp_cb, inp_arg, mem_cb);
-    if (r!=XJS_OK) return i_noend(r);    
-    if (cnt) (*cnt)++;
-    if ((r=i_eatwhite(jsp, inp_cb, inp_arg))!=XJS_OK) return i_noend(r);
-  }
-  r=i_advance(0, jsp, inp_cb, inp_arg);
-  if ((r!=XJS_OK)&&(r!=XJS_END)) return i_noend(r); // eat the close bracket, END IS OKAY!
-#ifdef XJS_CFLAG_ENABLE_BLOCKS
-  if (kind==XJS_block_header) kind=XJS_block_header_end;
-  else if (kind==XJS_block_array) kind=XJS_block_array_end;
-  else
+static void i_hdr_add(IXJSCtx *c, IXJSFrame *b, IXJSStr *s);
+static void i_hdr_free(IXJSCtx *c, IXJSFrame *b);
+static int i_col_begin(IXJSCtx *c, IXJSFrame *b);
+static int i_col_raw(IXJSCtx *c, char ch);
+static int i_col_rawend(IXJSCtx *c, IXJSFrame *f);
+static int i_col_put(IXJSCtx *c, IXJSFrame *f, XJSType kind, const IXJSStr *v);
+static int i_col_flush(IXJSCtx *c, IXJSFrame *b);
+static void i_col_free(IXJSCtx *c);
+static int i_bix_rec(IXJSCtx *c, IXJSFrame *n);
+static int i_bix_node(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *node_arg);
+static int i_bix_make(XJSBlockIndex **bi, XJSMemCB m, const char *text, XJSSize ntext, int ncol);
 #endif
-  kind=XJS_array_end;
-  return node_cb(&np, kind, name, NULL, node_arg);
-}
 
 /* ---------------------------------------------------------------------------
-** Parse a JSON object, return XJS_NOPE if the input does not start correctly
-** <white> '{' <white> (',' <white> <string> <white> ':' <white> <any> <white>)* '}'
-** COMMA only after first member
+** Character classes, replaces ctype (and the locale) on the hot paths.
+** IXJS_CC_STR marks the bytes a string scan must stop at: the quote, the
+** backslash, control characters and (to validate UTF-8) non-ascii bytes.
+** IXJS_CC_SKIP marks the ones a skipped container is scanned for: the
+** quote, the backslash and the brackets.
 ** ---------------------------------------------------------------------------
 */
-static int i_parse_object(const char **jsp, void *parent, const char *name, XJSNodeCB node_cb, void *node_arg, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb)
-{ int i=0, r=XJS_OK; void *np=parent;
-  if ((**jsp)!='{') return XJS_NOPE;
-  if ((r=node_cb(&np, XJS_object, name, NULL, node_arg))!=XJS_OK) return r;
-  if ((r=i_advance(1, jsp, inp_cb, inp_arg))!=XJS_OK) return r; 
-  while ((**jsp)!='}')
-  {  if (i++!=0) if ((**jsp)!=',') return XJS_ERR_EXP_COMMA; else if ((r=i_advance(0, jsp, inp_cb, inp_arg))!=XJS_OK) return i_noend(r);
-    XJSSize used=0, mxsz=0; char *new_name=NULL;
-    r=i_parse_string(jsp, &new_name, &mxsz, &used, inp_cb, inp_arg, mem_cb, XJS_name);
-    if (r==XJS_OK) r=i_eatwhite(jsp, inp_cb, inp_arg); // eat up to colon
-    if (r==XJS_OK) if ((**jsp)!=':') r=XJS_ERR_EXP_COLON; 
-    if (r==XJS_OK) r=i_advance(0, jsp, inp_cb, inp_arg); // eat colon
-    if (r==XJS_OK) r=r_parse_any(0, jsp, np, new_name, node_cb, node_arg, inp_cb, inp_arg, mem_cb); // get value(name)
-    if (new_name) mem_cb(XJS_free, XJS_name, new_name, 0, NULL); // done with new_name
-    if (r!=XJS_OK) return i_noend(r);
-    if ((r=i_eatwhite(jsp, inp_cb, inp_arg))!=XJS_OK) return i_noend(r); // eat until comma or end
-  }
-  r=i_advance(0, jsp, inp_cb, inp_arg);
-  if ((r!=XJS_OK)&&(r!=XJS_END)) return r; // eat the close bracket, END IS OKAY!
-  return node_cb(&np, XJS_object_end, name, NULL, node_arg);
-}
+#define IXJS_CC_WHITE 0x01  /* JSON white space: space, tab, new line, carriage return */
+#define IXJS_CC_DIGIT 0x02
+#define IXJS_CC_HEX   0x04
+#define IXJS_CC_ALNUM 0x08
+#define IXJS_CC_STR   0x10
+#define IXJS_CC_SKIP  0x20
+#define IXJS_CC(ch, cc) (i_cclass[(unsigned char)(ch)]&(cc))
+#define IXJS_DIGIT(ch) (((unsigned char)((ch)-'0'))<10)
+static const unsigned char i_cclass[256]=
+{
+  0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x11,0x11,0x10,0x10,0x11,0x10,0x10,
+  0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,
+  0x01,0x00,0x30,0x00,0x00,0x00,0x00,0x00,0x20,0x20,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x0e,0x0e,0x0e,0x0e,0x0e,0x0e,0x0e,0x0e,0x0e,0x0e,0x00,0x00,0x00,0x00,0x00,0x00,
+  0x00,0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,
+  0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x20,0x30,0x20,0x00,0x00,
+  0x00,0x0c,0x0c,0x0c,0x0c,0x0c,0x0c,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,
+  0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x20,0x00,0x20,0x00,0x00,
+  0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,
+  0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,
+  0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,
+  0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,
+  0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,
+  0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,
+  0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,
+  0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x10,
+};
+
+#ifdef XJS_CFLAG_DISABLE_UTF8_CHECK
+#define IXJS_STR_STOP(ch) ((IXJS_CC(ch, IXJS_CC_STR))&&(((unsigned char)(ch))<0x80))
+#else
+#define IXJS_STR_STOP(ch) (IXJS_CC(ch, IXJS_CC_STR))
+#endif
 
-#ifdef XJS_CFLAG_ENABLE_BLOCKS
 /* ---------------------------------------------------------------------------
-** Parse a Block. NOT STANDARD JSON!
-** <white> '(' <white> (',' <white> <array> <white>)* ')'
-** COMMA only after first array, first array is strings only (header)
+** Scanning kernels. 
+** i_scan_str returns the first byte in [p,e) that a string scan has to look
+** at: a quote, a backslash, a control character, or the start of a UTF-8
+** sequence the kernel did not validate itself. i_scan_white returns the
+** first byte in [p,e) that is not white space. i_scan_skip returns the
+** first quote, backslash or bracket (IXJS_CC_SKIP). All return e if there
+** is none. The scalar kernels are always available, SSE2 and AVX2 versions
+** are picked at runtime when the CPU supports them. Loads never reach past
+** e, so the input needs no padding.
 ** ---------------------------------------------------------------------------
 */
-static int i_parse_block(const char **jsp, void *parent, const char *name, XJSNodeCB node_cb, void *node_arg, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb)
-{ int i=0, r, cnt=0, tmpcnt=0; void *np=parent; char **hdr=NULL;
-  if ((**jsp)!='(') return XJS_NOPE;
-  if ((r=node_cb(&np, XJS_block, name, NULL, node_arg))!=XJS_OK) return r;
-  if ((r=i_advance(1, jsp, inp_cb, inp_arg))!=XJS_OK) return i_noend(r); 
-  if (**jsp!=')') r=i_parse_array(&hdr, XJS_block_header, &cnt, jsp, np, NULL, node_cb, node_arg, inp_cb, inp_arg, mem_cb);
-  while ((r==XJS_OK)&&(**jsp!=')'))
-  { if (i++!=0) if ((**jsp)!=',') return XJS_ERR_EXP_COMMA; else r=i_advance(0, jsp, inp_cb, inp_arg);
-    if (r==XJS_OK) r=i_parse_array(&hdr, XJS_block_array, &tmpcnt, jsp, np, NULL, node_cb, node_arg, inp_cb, inp_arg, mem_cb);
-    if ((r==XJS_OK)&&(tmpcnt!=cnt)) r=XJS_ERR_BLOCK_ARRAY_SIZE; // keep first error
+typedef const char *(*IXJSScanFn)(const char *p, const char *e);
+
+static const char *i_scan_str_c(const char *p, const char *e)
+{ while ((p<e)&&(!IXJS_STR_STOP(*p))) p++;
+  return p;
+}
+
+static const char *i_scan_white_c(const char *p, const char *e)
+{ while ((p<e)&&(IXJS_CC(*p, IXJS_CC_WHITE))) p++;
+  return p;
+}
+
+static const char *i_scan_skip_c(const char *p, const char *e)
+{ while ((p<e)&&(!IXJS_CC(*p, IXJS_CC_SKIP))) p++;
+  return p;
+}
+
+#ifdef IXJS_SIMD_X86
+#define IXJS_SSE2 __attribute__((target("sse2")))
+#define IXJS_AVX2 __attribute__((target("avx2")))
+
+IXJS_SSE2 static const char *i_scan_str_sse2(const char *p, const char *e)
+{ const __m128i q=_mm_set1_epi8('"'), b=_mm_set1_epi8('\\');
+#ifdef XJS_CFLAG_DISABLE_UTF8_CHECK
+  const __m128i s=_mm_set1_epi8(0x1F);
+#else
+  const __m128i s=_mm_set1_epi8(0x20);
+#endif
+  while ((e-p)>=16)
+  { __m128i x=_mm_loadu_si128((const __m128i*)p);
+#ifdef XJS_CFLAG_DISABLE_UTF8_CHECK
+    __m128i m=_mm_cmpeq_epi8(_mm_min_epu8(x, s), x); // x <= 0x1F
+#else
+    __m128i m=_mm_cmplt_epi8(x, s); // signed, so x < 0x20 or x >= 0x80
+#endif
+    int k=_mm_movemask_epi8(_mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(x, q), _mm_cmpeq_epi8(x, b))));
+    if (k) return p+__builtin_ctz((unsigned)k);
+    p+=16;
   }
-  if (hdr) // clean up the header storage.
-  { for (i=0;i<cnt;i++) mem_cb(XJS_free, XJS_name, hdr[i], 0, NULL); 
-    mem_cb(XJS_free, XJS_block_header, hdr, 0, NULL);
+  return i_scan_str_c(p, e);
+}
+
+IXJS_SSE2 static const char *i_scan_white_sse2(const char *p, const char *e)
+{ const __m128i sp=_mm_set1_epi8(' '), t=_mm_set1_epi8('\t'), n=_mm_set1_epi8('\n'), r=_mm_set1_epi8('\r');
+  while ((e-p)>=16)
+  { __m128i x=_mm_loadu_si128((const __m128i*)p);
+    __m128i m=_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, sp), _mm_cmpeq_epi8(x, t)), _mm_or_si128(_mm_cmpeq_epi8(x, n), _mm_cmpeq_epi8(x, r)));
+    unsigned k=(~(unsigned)_mm_movemask_epi8(m))&0xFFFF;
+    if (k) return p+__builtin_ctz(k);
+    p+=16;
   }
-  if (r!=XJS_OK) return i_noend(r);
-  r=i_advance(0, jsp, inp_cb, inp_arg);
-  if ((r!=XJS_OK)&&(r!=XJS_END)) return r; // eat the close bracket, END IS OKAY!
-  return node_cb(&np, XJS_block_end, name, NULL, node_arg);
+  return i_scan_white_c(p, e);
 }
+
+/* '[' and '{' are one bit apart, so are ']' and '}' */
+IXJS_SSE2 static const char *i_scan_skip_sse2(const char *p, const char *e)
+{ const __m128i q=_mm_set1_epi8('"'), b=_mm_set1_epi8('\\'), o=_mm_set1_epi8('{'), c=_mm_set1_epi8('}'), l=_mm_set1_epi8(0x20);
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  const __m128i pr=_mm_set1_epi8(')'), one=_mm_set1_epi8(1);
 #endif
+  while ((e-p)>=16)
+  { __m128i x=_mm_loadu_si128((const __m128i*)p), y=_mm_or_si128(x, l);
+    __m128i m=_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, q), _mm_cmpeq_epi8(x, b)), _mm_or_si128(_mm_cmpeq_epi8(y, o), _mm_cmpeq_epi8(y, c)));
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    m=_mm_or_si128(m, _mm_cmpeq_epi8(_mm_or_si128(x, one), pr));
+#endif
+    int k=_mm_movemask_epi8(m);
+    if (k) return p+__builtin_ctz((unsigned)k);
+    p+=16;
+  }
+  return i_scan_skip_c(p, e);
+}
 
-/* ---------------------------------------------------------------------------
-** Determine the next node in the input stream and parse it accordingly.
-** ---------------------------------------------------------------------------
-*/
-static int r_parse_any(int top, const char **jsp, void *parent, const char *name, XJSNodeCB node_cb, void *node_arg, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb)
-{ void *np=parent;
-  int r=i_eatwhite(jsp, inp_cb, inp_arg); if ((r!=XJS_OK)&&(r!=XJS_END)) return r;
-  if (r==XJS_END) return r;
-  if ((**jsp)=='{') r=i_parse_object(jsp, parent, name, node_cb, node_arg, inp_cb, inp_arg, mem_cb);
-  else if ((**jsp)=='[') r=i_parse_array(NULL, XJS_array, NULL, jsp, parent, name, node_cb, node_arg, inp_cb, inp_arg, mem_cb);
-#ifdef XJS_CFLAG_ENABLE_BLOCKS 
-  else if ((**jsp)=='(') r=i_parse_block(jsp, parent, name, node_cb, node_arg, inp_cb, inp_arg, mem_cb);
+IXJS_AVX2 static const char *i_scan_skip_avx2(const char *p, const char *e)
+{ const __m256i q=_mm256_set1_epi8('"'), b=_mm256_set1_epi8('\\'), o=_mm256_set1_epi8('{'), c=_mm256_set1_epi8('}'), l=_mm256_set1_epi8(0x20);
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  const __m256i pr=_mm256_set1_epi8(')'), one=_mm256_set1_epi8(1);
 #endif
-  else if (top==1) r=XJS_ERR_BAD_INPUT;  // can only be one the above at the top level. 
-  else
-  { XJSType kind; XJSSize used=0, mxsz=0; char *value=NULL;
-    r=i_parse_value(jsp, &kind, &value, &mxsz, &used, inp_cb, inp_arg, mem_cb);
-    if (r==XJS_OK) r=node_cb(&np, kind, name, value, node_arg); 
-    mem_cb(XJS_free, kind, value, 0, NULL);
+  while ((e-p)>=32)
+  { __m256i x=_mm256_loadu_si256((const __m256i*)p), y=_mm256_or_si256(x, l);
+    __m256i m=_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, q), _mm256_cmpeq_epi8(x, b)), _mm256_or_si256(_mm256_cmpeq_epi8(y, o), _mm256_cmpeq_epi8(y, c)));
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    m=_mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_or_si256(x, one), pr));
+#endif
+    unsigned k=(unsigned)_mm256_movemask_epi8(m);
+    if (k) return p+__builtin_ctz(k);
+    p+=32;
   }
-  return r;
+  return i_scan_skip_sse2(p, e);
 }
 
-/* ---------------------------------------------------------------------------
-** Parse a value node (literal, string or number).
-** ---------------------------------------------------------------------------
+IXJS_AVX2 static const char *i_scan_white_avx2(const char *p, const char *e)
+{ const __m256i sp=_mm256_set1_epi8(' '), t=_mm256_set1_epi8('\t'), n=_mm256_set1_epi8('\n'), r=_mm256_set1_epi8('\r');
+  while ((e-p)>=32)
+  { __m256i x=_mm256_loadu_si256((const __m256i*)p);
+    __m256i m=_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, sp), _mm256_cmpeq_epi8(x, t)), _mm256_or_si256(_mm256_cmpeq_epi8(x, n), _mm256_cmpeq_epi8(x, r)));
+    unsigned k=~(unsigned)_mm256_movemask_epi8(m);
+    if (k) return p+__builtin_ctz(k);
+    p+=32;
+  }
+  return i_scan_white_sse2(p, e);
+}
+
+#ifdef XJS_CFLAG_DISABLE_UTF8_CHECK
+IXJS_AVX2 static const char *i_scan_str_avx2(const char *p, const char *e)
+{ const __m256i q=_mm256_set1_epi8('"'), b=_mm256_set1_epi8('\\'), s=_mm256_set1_epi8(0x1F);
+  while ((e-p)>=32)
+  { __m256i x=_mm256_loadu_si256((const __m256i*)p);
+    __m256i m=_mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(x, s), x), _mm256_or_si256(_mm256_cmpeq_epi8(x, q), _mm256_cmpeq_epi8(x, b)));
+    unsigned k=(unsigned)_mm256_movemask_epi8(m);
+    if (k) return p+__builtin_ctz(k);
+    p+=32;
+  }
+  return i_scan_str_sse2(p, e);
+}
+#else
+/*
+** UTF-8 validation of 32 bytes at a time with nibble lookups, see Keiser
+** and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte".
+** Every byte pair (previous, current) is classified by three table lookups,
+** the AND of the lookups is non zero for an invalid pair. prev is the block
+** before x, so sequences that cross blocks are checked too.
 */
-static int i_parse_value(const char **jsp, int *kind, char **value, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb)
-{ int r; *kind=XJS_unknown; 
-  if ((r=i_eatwhite(jsp, inp_cb, inp_arg))!=XJS_OK) return r;
-  r=XJS_NOPE;
-  if (r==XJS_NOPE) if ((r=i_parse_literal(jsp, "true",  value, mxsz, used, inp_cb, inp_arg))==XJS_OK) *kind=XJS_true; 
-  if (r==XJS_NOPE) if ((r=i_parse_literal(jsp, "false", value, mxsz, used, inp_cb, inp_arg))==XJS_OK) *kind=XJS_false;
-  if (r==XJS_NOPE) if ((r=i_parse_literal(jsp, "null",  value, mxsz, used, inp_cb, inp_arg))==XJS_OK) *kind=XJS_null;
-  if (r==XJS_NOPE) if ((r=i_parse_number(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb))==XJS_OK) *kind=XJS_number;
-  if (r==XJS_NOPE) if ((r=i_parse_string(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, XJS_string))==XJS_OK) *kind=XJS_string;
-  if (r!=XJS_OK) return r;
-  return XJS_OK;
+#define IXJS_U8_TOO_SHORT      (1<<0)
+#define IXJS_U8_TOO_LONG       (1<<1)
+#define IXJS_U8_OVERLONG_3     (1<<2)
+#define IXJS_U8_TOO_LARGE      (1<<3)
+#define IXJS_U8_SURROGATE      (1<<4)
+#define IXJS_U8_OVERLONG_2     (1<<5)
+#define IXJS_U8_TOO_LARGE_1000 (1<<6)
+#define IXJS_U8_OVERLONG_4     (1<<6)
+#define IXJS_U8_TWO_CONTS      (1<<7)
+#define IXJS_U8_CARRY          (IXJS_U8_TOO_SHORT|IXJS_U8_TOO_LONG|IXJS_U8_TWO_CONTS)
+#define IXJS_U8_X2(a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p) a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p
+#define IXJS_U8_PREV(x, prev, n) _mm256_alignr_epi8((x), _mm256_permute2x128_si256((prev), (x), 0x21), 16-(n))
+
+IXJS_AVX2 static __m256i i_utf8_avx2(__m256i x, __m256i prev)
+{ const __m256i f=_mm256_set1_epi8(0x0F);
+  const __m256i byte_1_high=_mm256_setr_epi8(IXJS_U8_X2(
+    IXJS_U8_TOO_LONG, IXJS_U8_TOO_LONG, IXJS_U8_TOO_LONG, IXJS_U8_TOO_LONG, 
+    IXJS_U8_TOO_LONG, IXJS_U8_TOO_LONG, IXJS_U8_TOO_LONG, IXJS_U8_TOO_LONG,
+    (char)IXJS_U8_TWO_CONTS, (char)IXJS_U8_TWO_CONTS, (char)IXJS_U8_TWO_CONTS, (char)IXJS_U8_TWO_CONTS,
+    IXJS_U8_TOO_SHORT|IXJS_U8_OVERLONG_2, 
+    IXJS_U8_TOO_SHORT,
+    IXJS_U8_TOO_SHORT|IXJS_U8_OVERLONG_3|IXJS_U8_SURROGATE,
+    (char)(IXJS_U8_TOO_SHORT|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000|IXJS_U8_OVERLONG_4)));
+  const __m256i byte_1_low=_mm256_setr_epi8(IXJS_U8_X2(
+    (char)(IXJS_U8_CARRY|IXJS_U8_OVERLONG_3|IXJS_U8_OVERLONG_2|IXJS_U8_OVERLONG_4),
+    (char)(IXJS_U8_CARRY|IXJS_U8_OVERLONG_2),
+    (char)IXJS_U8_CARRY, (char)IXJS_U8_CARRY,
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000|IXJS_U8_SURROGATE),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000),
+    (char)(IXJS_U8_CARRY|IXJS_U8_TOO_LARGE|IXJS_U8_TOO_LARGE_1000)));
+  const __m256i byte_2_high=_mm256_setr_epi8(IXJS_U8_X2(
+    IXJS_U8_TOO_SHORT, IXJS_U8_TOO_SHORT, IXJS_U8_TOO_SHORT, IXJS_U8_TOO_SHORT,
+    IXJS_U8_TOO_SHORT, IXJS_U8_TOO_SHORT, IXJS_U8_TOO_SHORT, IXJS_U8_TOO_SHORT,
+    (char)(IXJS_U8_TOO_LONG|IXJS_U8_OVERLONG_2|IXJS_U8_TWO_CONTS|IXJS_U8_OVERLONG_3|IXJS_U8_TOO_LARGE_1000|IXJS_U8_OVERLONG_4),
+    (char)(IXJS_U8_TOO_LONG|IXJS_U8_OVERLONG_2|IXJS_U8_TWO_CONTS|IXJS_U8_OVERLONG_3|IXJS_U8_TOO_LARGE),
+    (char)(IXJS_U8_TOO_LONG|IXJS_U8_OVERLONG_2|IXJS_U8_TWO_CONTS|IXJS_U8_SURROGATE|IXJS_U8_TOO_LARGE),
+    (char)(IXJS_U8_TOO_LONG|IXJS_U8_OVERLONG_2|IXJS_U8_TWO_CONTS|IXJS_U8_SURROGATE|IXJS_U8_TOO_LARGE),
+    IXJS_U8_TOO_SHORT, IXJS_U8_TOO_SHORT, IXJS_U8_TOO_SHORT, IXJS_U8_TOO_SHORT));
+  __m256i p1=IXJS_U8_PREV(x, prev, 1);
+  __m256i sc=_mm256_and_si256(_mm256_and_si256(
+    _mm256_shuffle_epi8(byte_1_high, _mm256_and_si256(_mm256_srli_epi16(p1, 4), f)),
+    _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(p1, f))),
+    _mm256_shuffle_epi8(byte_2_high, _mm256_and_si256(_mm256_srli_epi16(x, 4), f)));
+  // the third and fourth bytes of a sequence must be continuations, TWO_CONTS is expected there
+  __m256i m23=_mm256_or_si256(_mm256_subs_epu8(IXJS_U8_PREV(x, prev, 2), _mm256_set1_epi8((char)(0xE0-0x80))),
+                              _mm256_subs_epu8(IXJS_U8_PREV(x, prev, 3), _mm256_set1_epi8((char)(0xF0-0x80))));
+  return _mm256_xor_si256(_mm256_and_si256(m23, _mm256_set1_epi8((char)0x80)), sc);
 }
 
-/* ---------------------------------------------------------------------------
-** Parse a string node. JSON strings are surrounded by double quotes.
-** ---------------------------------------------------------------------------
+/*
+** Back up from p to the lead byte of a sequence that may run into p, but
+** never before p0. Used to hand a block back to the scalar validation.
 */
-static int i_parse_string(const char **jsp, char **value, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb, XJSType context)
-{ int r; if ((r=i_eatwhite(jsp, inp_cb, inp_arg))!=XJS_OK) return r;
-  if ((**jsp)!='"') return XJS_NOPE; if ((r=i_advance(0, jsp, inp_cb, inp_arg))!=XJS_OK) return r; 
-  while ((**jsp)&&((**jsp)!='"')) 
-  { if ((**jsp)!='\\') r=i_assign(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, context); 
-    else r=i_parse_escape(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, context);
-    if (r!=XJS_OK) return r; 
+static const char *i_seq_start(const char *p0, const char *p)
+{ const char *q=p; int i;
+  for (i=0;(i<4)&&(q>p0);i++) { q--; if ((((unsigned char)*q)&0xC0)!=0x80) return (((unsigned char)*q)>=0xC0)?q:p; }
+  return p;
+}
+
+/* 32 x 0xFF then 32 x 0, loaded at an offset to keep the bytes before a stop */
+static const unsigned char i_keep[64]={
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255 };
+
+IXJS_AVX2 static const char *i_scan_str_avx2(const char *p, const char *e)
+{ const __m256i q=_mm256_set1_epi8('"'), b=_mm256_set1_epi8('\\'), s=_mm256_set1_epi8(0x1F);
+  const __m256i last=_mm256_setr_epi8(-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+                                      (char)(0xF0-1), (char)(0xE0-1), (char)(0xC0-1));
+  __m256i prev=_mm256_setzero_si256(), incomplete=prev, err=prev; const char *p0=p;
+  while ((e-p)>=32)
+  { __m256i x=_mm256_loadu_si256((const __m256i*)p);
+    __m256i m=_mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(x, s), x), _mm256_or_si256(_mm256_cmpeq_epi8(x, q), _mm256_cmpeq_epi8(x, b)));
+    unsigned k=(unsigned)_mm256_movemask_epi8(m);
+    if (k) x=_mm256_and_si256(x, _mm256_loadu_si256((const __m256i*)(i_keep+32-__builtin_ctz(k)))); // only the bytes before the stop are in the string
+    if (_mm256_movemask_epi8(x)) 
+    { err=_mm256_or_si256(err, i_utf8_avx2(x, prev));
+      incomplete=_mm256_subs_epu8(x, last); // a sequence is still open at the end of x
+    }
+    else err=_mm256_or_si256(err, incomplete);
+    if (!_mm256_testz_si256(err, err)) return i_scan_str_c(i_seq_start(p0, p), e); // let the scalar code find the bad sequence
+    if (k) return p+__builtin_ctz(k);
+    prev=x; p+=32;
   }
-  if ((**jsp)!='"') return XJS_ERR_EXP_END_STRING; if ((r=i_advance(0, jsp, inp_cb, inp_arg))!=XJS_OK) return r; 
-  if (*value) (*value)[(*used)++]=0; 
-  return XJS_OK;
+  if (!_mm256_testz_si256(incomplete, incomplete)) p=i_seq_start(p0, p); // the tail finishes the open sequence
+  return i_scan_str_c(p, e);
 }
+#endif /* UTF8 CHECK */
+#endif /* IXJS_SIMD_X86 */
 
 /* ---------------------------------------------------------------------------
-** Determine if a literal is the next node and parse if it is. 
-** This function can be called to test if the next token is a literal.
-** So don't move the cursor unless we have it.
-** this call is internal, it will only be called for true, false and null
-** We know by the first character, and deviation is an error, so we can
-** advance the input while we look. 
+** Structural index (XJS_OPT_INDEX), the first pass over a document in
+** memory. Each 64 byte block is classified into bit masks (i_class), the
+** quotes that are not escaped give the bytes inside strings (a prefix xor),
+** and what is left outside them is indexed: the structural characters, the
+** quotes, and the first byte of each scalar. An entry is the offset of the
+** byte, with IXJS_IX_SLOW on the open quote of a string that needs the full
+** string scan (escapes, control characters, bytes to validate as UTF-8).
 ** ---------------------------------------------------------------------------
 */
-static int i_parse_literal(const char **jsp, const char *lit, char **value, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg)
-{ int r; if ((r=i_eatwhite(jsp, inp_cb, inp_arg))!=XJS_OK) return r;
-  if ((**jsp)!=*lit) return XJS_NOPE;
-  int i; for (i=0;(lit[i]!=0);i++)
-  { if ((**jsp)!=lit[i]) return XJS_ERR_BAD_LITERAL; // check 0 twice, that's ok.
-    if ((r=i_advance(0, jsp, inp_cb, inp_arg))!=XJS_OK) return r; 
+#define IXJS_IX_SLOW    0x80000000u
+#define IXJS_IX_OFF     0x7FFFFFFFu
+
+typedef struct { IXJSU64 quote, bslash, white, op, slow; } IXJSMasks;
+typedef void (*IXJSClassFn)(const char *p, IXJSMasks *m);
+
+static void i_class_c(const char *p, IXJSMasks *m)
+{ int i; unsigned char ch; IXJSU64 b;
+  m->quote=m->bslash=m->white=m->op=m->slow=0;
+  for (i=0;i<64;i++)
+  { ch=(unsigned char)p[i]; b=1ULL<<i;
+    if (ch=='"') m->quote|=b;
+    else if (ch=='\\') m->bslash|=b;
+    else if (IXJS_CC(ch, IXJS_CC_WHITE)) m->white|=b;
+    else if ((ch=='{')||(ch=='}')||(ch=='[')||(ch==']')||(ch==':')||(ch==',')) m->op|=b;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    else if ((ch=='(')||(ch==')')) m->op|=b;
+#endif
+    if (ch<0x20) m->slow|=b;
+#ifndef XJS_CFLAG_DISABLE_UTF8_CHECK
+    if (ch>=0x80) m->slow|=b;
+#endif
   }
-  if (isalnum(**jsp)) return XJS_ERR_BAD_LITERAL;
-  return XJS_OK;
+  m->slow|=m->bslash;
 }
 
-/* ---------------------------------------------------------------------------
-** Parse a JSON escaped character sequence. 
-** Do not NULL terminate because its part of a string.
-** ---------------------------------------------------------------------------
-*/
-static int i_parse_escape(const char **jsp, char **escape, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb, XJSType context)
-{ int r; 
-  if ((**jsp)!='\\') return XJS_NOPE; 
-  if ((r=i_assign(jsp, escape, mxsz, used, inp_cb, inp_arg, mem_cb, context))!=XJS_OK) return r; 
-  if (((**jsp)!='"') && ((**jsp)!='\\') && ((**jsp)!='/') && ((**jsp)!='b') && ((**jsp)!='f') && 
-      ((**jsp)!='n') && ((**jsp)!='r')  && ((**jsp)!='t') && ((**jsp)!='u')) return XJS_ERR_EXP_ESCAPE;
-  int i=0; if ((**jsp)=='u') i=1;
-  if ((r=i_assign(jsp, escape, mxsz, used, inp_cb, inp_arg, mem_cb, context))!=XJS_OK) return r; 
-  if (i) for (i=0;i<4;i++) 
-  { if (!isxdigit(**jsp)) return XJS_ERR_EXP_ESCAPE_HEX;
-    if ((r=i_assign(jsp, escape, mxsz, used, inp_cb, inp_arg, mem_cb, context))!=XJS_OK) return r; 
+#ifdef IXJS_SIMD_X86
+IXJS_SSE2 static void i_class_sse2(const char *p, IXJSMasks *m)
+{ const __m128i q=_mm_set1_epi8('"'), bs=_mm_set1_epi8('\\'), sp=_mm_set1_epi8(' '), t=_mm_set1_epi8('\t'), n=_mm_set1_epi8('\n'), r=_mm_set1_epi8('\r');
+  const __m128i o1=_mm_set1_epi8('{'), o2=_mm_set1_epi8('}'), o3=_mm_set1_epi8('['), o4=_mm_set1_epi8(']'), o5=_mm_set1_epi8(':'), o6=_mm_set1_epi8(',');
+#ifdef XJS_CFLAG_DISABLE_UTF8_CHECK
+  const __m128i s=_mm_set1_epi8(0x1F);
+#else
+  const __m128i s=_mm_set1_epi8(0x20);
+#endif
+  int i; IXJSU64 k;
+  m->quote=m->bslash=m->white=m->op=m->slow=0;
+  for (i=0;i<64;i+=16)
+  { __m128i x=_mm_loadu_si128((const __m128i*)(p+i)), o;
+    m->quote|=(IXJSU64)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, q))<<i;
+    m->bslash|=(IXJSU64)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, bs))<<i;
+    k=(unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, sp), _mm_cmpeq_epi8(x, t)), _mm_or_si128(_mm_cmpeq_epi8(x, n), _mm_cmpeq_epi8(x, r))));
+    m->white|=k<<i;
+    o=_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, o1), _mm_cmpeq_epi8(x, o2)), _mm_or_si128(_mm_cmpeq_epi8(x, o3), _mm_cmpeq_epi8(x, o4)));
+    o=_mm_or_si128(o, _mm_or_si128(_mm_cmpeq_epi8(x, o5), _mm_cmpeq_epi8(x, o6)));
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    o=_mm_or_si128(o, _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('(')), _mm_cmpeq_epi8(x, _mm_set1_epi8(')'))));
+#endif
+    m->op|=(IXJSU64)(unsigned)_mm_movemask_epi8(o)<<i;
+#ifdef XJS_CFLAG_DISABLE_UTF8_CHECK
+    m->slow|=(IXJSU64)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(x, s), x))<<i; // x <= 0x1F
+#else
+    m->slow|=(IXJSU64)(unsigned)_mm_movemask_epi8(_mm_cmplt_epi8(x, s))<<i; // signed, so x < 0x20 or x >= 0x80
+#endif
   }
-  return XJS_OK;
+  m->slow|=m->bslash;
 }
 
-/* ---------------------------------------------------------------------------
-** Parse a JSON number node.
-** ---------------------------------------------------------------------------
+/*
+** White space and the operators are looked up by the low nibble (pshufb),
+** with [ ] folded onto { } by setting bit 5. Control characters that fold
+** onto an operator are indexed as one and fail in the parser, as they would.
 */
-static int i_parse_number(const char **jsp, char **value, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb)
-{ int r; if ((r=i_eatwhite(jsp, inp_cb, inp_arg))!=XJS_OK) return r;
-  if ((**jsp)=='-') if ((r=i_assign(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, XJS_number))!=XJS_OK) return r; 
-  if (!isdigit(**jsp)) return XJS_NOPE; 
-  if ((**jsp)=='0') r=i_assign(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, XJS_number); 
-  else
-  { if (!isdigit(**jsp)) return XJS_ERR_EXP_DIGIT;
-    while (isdigit(**jsp)) if ((r=i_assign(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, XJS_number))!=XJS_OK) return r; 
-  }
-  if (r!=XJS_OK) return r;
-  if ((**jsp)=='.') 
-  { if ((r=i_assign(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, XJS_number))!=XJS_OK) return r; 
-    if (!isdigit(**jsp)) return XJS_ERR_EXP_DIGIT;
-    while (isdigit(**jsp)) if ((r=i_assign(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, XJS_number))!=XJS_OK) return r; 
-  }
-  if (((**jsp)=='e') || ((**jsp)=='E'))
-  { if ((r=i_assign(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, XJS_number))!=XJS_OK) return r; 
-    if (((**jsp)=='+') || ((**jsp)=='-')) if ((r=i_assign(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, XJS_number))!=XJS_OK) return r; 
-    if (!isdigit(**jsp)) return XJS_ERR_EXP_DIGIT;
-    while (isdigit(**jsp)) if ((r=i_assign(jsp, value, mxsz, used, inp_cb, inp_arg, mem_cb, XJS_number))!=XJS_OK) return r; 
+IXJS_AVX2 static void i_class_avx2(const char *p, IXJSMasks *m)
+{ const __m256i wt=_mm256_setr_epi8(' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', 100, 100,
+                                    ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100, '\r', 100, 100);
+  const __m256i ot=_mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0,
+                                    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0);
+  const __m256i q=_mm256_set1_epi8('"'), bs=_mm256_set1_epi8('\\'), b5=_mm256_set1_epi8(0x20);
+#ifdef XJS_CFLAG_DISABLE_UTF8_CHECK
+  const __m256i s=_mm256_set1_epi8(0x1F);
+#else
+  const __m256i s=_mm256_set1_epi8(0x20);
+#endif
+  int i;
+  m->quote=m->bslash=m->white=m->op=m->slow=0;
+  for (i=0;i<64;i+=32)
+  { __m256i x=_mm256_loadu_si256((const __m256i*)(p+i)), o;
+    m->quote|=(IXJSU64)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, q))<<i;
+    m->bslash|=(IXJSU64)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, bs))<<i;
+    m->white|=(IXJSU64)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_shuffle_epi8(wt, x)))<<i;
+    o=_mm256_cmpeq_epi8(_mm256_or_si256(x, b5), _mm256_shuffle_epi8(ot, x));
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    o=_mm256_or_si256(o, _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('(')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(')'))));
+#endif
+    m->op|=(IXJSU64)(unsigned)_mm256_movemask_epi8(o)<<i;
+#ifdef XJS_CFLAG_DISABLE_UTF8_CHECK
+    m->slow|=(IXJSU64)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(x, s), x))<<i;
+#else
+    m->slow|=(IXJSU64)(unsigned)_mm256_movemask_epi8(_mm256_cmpgt_epi8(s, x))<<i;
+#endif
   }
-  if (*value) (*value)[(*used)++]=0; 
-  return XJS_OK;
+  m->slow|=m->bslash;
 }
+#endif
 
-/* ---------------------------------------------------------------------------
-** Consume the white space in the input stream.
-** ---------------------------------------------------------------------------
+/*
+** Pick the best kernels when the program loads, before any thread parses
+** (the parse itself writes no globals). On first use if it was missed.
+*/
+#ifdef IXJS_SIMD_X86
+static const char *i_scan_str_init(const char *p, const char *e);
+static const char *i_scan_white_init(const char *p, const char *e);
+static const char *i_scan_skip_init(const char *p, const char *e);
+static void i_class_init(const char *p, IXJSMasks *m);
+static IXJSScanFn i_scan_str=i_scan_str_init, i_scan_white=i_scan_white_init, i_scan_skip=i_scan_skip_init;
+static IXJSClassFn i_class=i_class_init;
+
+__attribute__((constructor)) static void i_scan_select(void)
+{ IXJSScanFn str=i_scan_str_c, white=i_scan_white_c, skip=i_scan_skip_c; IXJSClassFn cls=i_class_c;
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) { str=i_scan_str_avx2; white=i_scan_white_avx2; skip=i_scan_skip_avx2; cls=i_class_avx2; }
+  else if (__builtin_cpu_supports("sse2")) { str=i_scan_str_sse2; white=i_scan_white_sse2; skip=i_scan_skip_sse2; cls=i_class_sse2; }
+  i_scan_str=str; i_scan_white=white; i_scan_skip=skip; i_class=cls;
+}
+static const char *i_scan_str_init(const char *p, const char *e) { i_scan_select(); return i_scan_str(p, e); }
+static const char *i_scan_white_init(const char *p, const char *e) { i_scan_select(); return i_scan_white(p, e); }
+static const char *i_scan_skip_init(const char *p, const char *e) { i_scan_select(); return i_scan_skip(p, e); }
+static void i_class_init(const char *p, IXJSMasks *m) { i_scan_select(); i_class(p, m); }
+#else
+static IXJSScanFn i_scan_str=i_scan_str_c, i_scan_white=i_scan_white_c, i_scan_skip=i_scan_skip_c;
+static IXJSClassFn i_class=i_class_c;
+#endif
+
+static int i_ctz64(IXJSU64 w)
+{
+#if defined(__GNUC__)||defined(__clang__)
+  return __builtin_ctzll(w);
+#else
+  int n=0; while (!(w&1)) { w>>=1; n++; } return n;
+#endif
+}
+
+static int i_clz64(IXJSU64 w)
+{
+#if defined(__GNUC__)||defined(__clang__)
+  return __builtin_clzll(w);
+#else
+  int n=0; while (!(w&0x8000000000000000ULL)) { w<<=1; n++; } return n;
+#endif
+}
+
+static int i_popcnt64(IXJSU64 w)
+{
+#if defined(__GNUC__)||defined(__clang__)
+  return __builtin_popcountll(w);
+#else
+  w-=(w>>1)&0x5555555555555555ULL; w=(w&0x3333333333333333ULL)+((w>>2)&0x3333333333333333ULL);
+  return (int)((((w+(w>>4))&0x0F0F0F0F0F0F0F0FULL)*0x0101010101010101ULL)>>56);
+#endif
+}
+
+/*
+** The escaped bytes of a block: those after an odd run of backslashes.
+** pesc carries a backslash that escapes the first byte of the next block.
 */
-static int i_eatwhite(const char **jsp, XJSInputCB inp_cb, void *inp_arg)
-{ int r; while (isspace(**jsp)) if ((r=i_advance(0, jsp, inp_cb, inp_arg))!=XJS_OK) return r; 
+static IXJSU64 i_escaped(IXJSU64 bs, IXJSU64 *pesc)
+{ const IXJSU64 even=0x5555555555555555ULL; IXJSU64 follows, odd, seq;
+  bs&=~(*pesc);
+  follows=(bs<<1)|(*pesc);
+  odd=bs&~even&~follows; 
+  seq=odd+bs; *pesc=(seq<odd)?1:0; // carry out of the block
+  return (even^(seq<<1))&follows;
+}
+
+static IXJSU64 i_prefix_xor(IXJSU64 x)
+{ x^=x<<1; x^=x<<2; x^=x<<4; x^=x<<8; x^=x<<16; x^=x<<32;
+  return x;
+}
+
+/*
+** Index [json,json+len). Returns XJS_OK, or an error if there is no room
+** for the index (the parse goes on without it).
+*/
+static int i_index(IXJSCtx *c, const char *json, XJSSize len)
+{ XJSSize o, n=0, open=(XJSSize)-1, actsz=0; IXJSMasks m; char tail[64];
+  IXJSU64 pesc=0, pin=0, pscal=0, esc, quote, in, scal, st, w, bit; unsigned *ix, b; int i, k;
+  if (len>=IXJS_IX_OFF) return XJS_ERR_USAGE; // offsets are 31 bits
+  c->ixsz=len/8+68;
+  if ((c->ix=(unsigned*)i_mem(c, XJS_alloc, XJS_index, NULL, c->ixsz*sizeof(unsigned), &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+  c->ixsz=actsz/sizeof(unsigned);
+  for (o=0;o<len;o+=64)
+  { if ((c->ixsz-n)<68) // room for a block, and the writes past its last entry
+    { if ((ix=(unsigned*)i_mem(c, XJS_alloc, XJS_index, c->ix, c->ixsz*2*sizeof(unsigned), &actsz))==NULL) { i_index_free(c); return XJS_ERR_MEM_ALLOC; }
+      c->ix=ix; c->ixsz=actsz/sizeof(unsigned);
+      if ((c->ixsz-n)<68) { i_index_free(c); return XJS_ERR_MEM_ALLOC; }
+    }
+    if ((len-o)>=64) i_class(json+o, &m);
+    else { memset(tail, ' ', 64); memcpy(tail, json+o, len-o); i_class(tail, &m); } // white space after the end
+    esc=i_escaped(m.bslash, &pesc);
+    quote=m.quote&~esc;
+    in=i_prefix_xor(quote)^pin; pin=(in>>63)?~0ULL:0; // in a string, from the open quote up to the close quote
+    scal=~(m.op|m.white|quote|in);
+    st=(m.op&~in)|quote|(scal&~((scal<<1)|pscal)); pscal=scal>>63;
+    ix=c->ix+n; b=(unsigned)o; k=i_popcnt64(st);
+    for (i=0,w=st;i<k;i+=4) // four at a time, the extra ones are overwritten
+    { ix[i]=b+(unsigned)i_ctz64(w|0x8000000000000000ULL); w&=w-1;
+      ix[i+1]=b+(unsigned)i_ctz64(w|0x8000000000000000ULL); w&=w-1;
+      ix[i+2]=b+(unsigned)i_ctz64(w|0x8000000000000000ULL); w&=w-1;
+      ix[i+3]=b+(unsigned)i_ctz64(w|0x8000000000000000ULL); w&=w-1;
+    }
+    if (m.slow&in) // the open quote of each string with a slow byte
+    { w=(quote&in)|(m.slow&in);
+      while (w)
+      { bit=w&(~w+1); w^=bit;
+        if (quote&bit) open=n+(XJSSize)i_popcnt64(st&(bit-1));
+        else if (open!=(XJSSize)-1) c->ix[open]|=IXJS_IX_SLOW;
+      }
+    }
+    else if (quote&in) open=n+(XJSSize)i_popcnt64(st&((1ULL<<(63-i_clz64(quote&in)))-1));
+    n+=(XJSSize)k;
+  }
+  if ((pin)&&(open!=(XJSSize)-1)) c->ix[open]|=IXJS_IX_SLOW; // not terminated
+  c->ixn=n; c->ixk=0; c->ixb=json; c->ixq=NULL;
   return XJS_OK;
 }
 
-/* ---------------------------------------------------------------------------
-** Advance the input stream one character. Advance through white space if
-** ew==1.
+static void i_index_free(IXJSCtx *c)
+{ if (c->ix) i_mem(c, XJS_free, XJS_index, c->ix, 0, NULL);
+  c->ix=NULL; c->ixn=c->ixk=c->ixsz=0; c->ixq=NULL;
+}
+
+/*
+** Default memory management using libc malloc/free/realloc. 
 ** ---------------------------------------------------------------------------
 */
-static int i_advance(int ew, const char **jsp, XJSInputCB inp_cb, void *inp_arg)
-{ int r; if ((**jsp)!=0) (*jsp)++; 
-  if ((**jsp)==0) if (inp_cb!=NULL) if ((r=inp_cb(jsp, inp_arg))!=XJS_OK) return r;
-  if ((*jsp)==NULL) return XJS_ERR_USAGE;
-  if ((**jsp)==0) return XJS_END;
-  return (ew)?i_eatwhite(jsp, inp_cb, inp_arg):XJS_OK;
+#ifdef XJS_CFLAG_DISABLE_MEM_FALLBACK
+static XJSMemCB i_mem_fallback = NULL;
+#else
+static void *i_mem_fallback(XJSMemReq action, XJSType context, void *prev, XJSSize size, XJSSize *actsz)
+{ void *ret=NULL; if (actsz) *actsz=0; // on realloc, prev!=NULL and actsz will be the last size of prev.
+  if (action==XJS_free) free(prev);
+  else if (action==XJS_alloc)
+  { if (prev) ret=realloc(prev, size);
+    else ret=malloc(size);
+  }
+  if ((ret)&&(actsz)) *actsz=size;
+  return ret;
 }
+#endif
 
-/* ---------------------------------------------------------------------------
-** Place the current input stream character into the output stream.
-** Adjust the size of the output stream if it runs out of space.
-** ---------------------------------------------------------------------------
+/*
+** All the parser's storage goes through i_mem, to the arena if it has one,
+** otherwise to the memory manager callback.
 */
-static int i_assign(const char **jsp, char **to, XJSSize *mxsz, XJSSize *used, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb, XJSType context)
-{ XJSSize actsz=*mxsz;
-  if (((*to)==NULL) || ((*mxsz)==0) || ((1+(*used))>=(*mxsz)))
-  { (*to)=mem_cb(XJS_alloc, context, (*to), (*mxsz)+IXJS_MEM_STR_BLOCK_SIZE, &actsz); 
-    if (((*to)==NULL)||(actsz<=(*mxsz))) return XJS_ERR_MEM_ALLOC;
-    (*mxsz)=actsz;
+static void *i_mem(IXJSCtx *c, XJSMemReq action, XJSType context, void *prev, XJSSize size, XJSSize *actsz)
+{
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if (c->stats) i_stats_mem(c->stats, action, prev, size);
+#endif
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+  if (c->arena)
+  { char *r; 
+    if (action==XJS_free) { i_arena_pop(c->arena, (char*)prev); return NULL; }
+    r=(char*)((prev)?i_arena_grow(c->arena, (char*)prev, size):i_arena_alloc(c->arena, size));
+    if (actsz) *actsz=(r)?((IXJSBlk*)(r-IXJS_ARENA_HDR))->size:0;
+    return r;
   }
-  if (((**jsp)=='\b')||((**jsp)=='\f')||((**jsp)=='\n')||((**jsp)=='\r')||((**jsp)=='\t')) return XJS_ERR_CONTROL_CHAR;
-  (*to)[(*used)++]=(**jsp);
-  return i_advance(0, jsp, inp_cb, inp_arg);
+#endif
+  return c->mem_cb(action, context, prev, size, actsz);
+}
+
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+/* An empty arena, buf (if not NULL) is the first chunk. */
+static void i_arena_init(XJSArena *a, void *buf, XJSSize size)
+{ char *b=(char*)buf; XJSSize k;
+  a->first=a->cur=NULL; a->grow=IXJS_MEM_ARENA_CHUNK; a->top=NULL;
+  if (b==NULL) return;
+  k=(XJSSize)(IXJS_ARENA_ALIGN-((XJSSize)b&(IXJS_ARENA_ALIGN-1)))&(IXJS_ARENA_ALIGN-1); // align the chunk
+  if (size<k+IXJS_ARENA_UP(sizeof(IXJSChunk))+IXJS_ARENA_HDR) return;
+  a->first=a->cur=(IXJSChunk*)(b+k);
+  a->cur->next=NULL; a->cur->used=0; a->cur->own=0;
+  a->cur->size=(size-k-IXJS_ARENA_UP(sizeof(IXJSChunk)))&~(XJSSize)(IXJS_ARENA_ALIGN-1);
+}
+
+static void i_arena_release(XJSArena *a)
+{ IXJSChunk *ch=a->first, *n;
+  for (;ch;ch=n) { n=ch->next; if (ch->own) free(ch); }
+  a->first=a->cur=NULL; a->top=NULL;
+}
+
+/*
+** Bump size bytes out of the current chunk. When it is full the chunks
+** kept by a reset are tried, then a new one is taken from libc (and
+** linked in after the current one).
+*/
+static void *i_arena_alloc(XJSArena *a, XJSSize size)
+{ XJSSize need=IXJS_ARENA_HDR+IXJS_ARENA_UP(size), sz; IXJSChunk *ch=a->cur; IXJSBlk *b;
+  while ((ch)&&((ch->size-ch->used)<need)) ch=ch->next;
+  if (ch==NULL)
+  { sz=(a->grow<need)?need:a->grow;
+    if ((ch=(IXJSChunk*)malloc(IXJS_ARENA_UP(sizeof(IXJSChunk))+sz))==NULL) return NULL;
+    ch->size=sz; ch->used=0; ch->own=1;
+    if (a->cur) { ch->next=a->cur->next; a->cur->next=ch; } else { ch->next=NULL; a->first=ch; }
+    if (a->grow<IXJS_MEM_ARENA_MAX) a->grow*=2;
+  }
+  if (ch!=a->cur) { a->cur=ch; a->top=NULL; }
+  b=(IXJSBlk*)(IXJS_CHUNK_DATA(ch)+ch->used); b->size=need-IXJS_ARENA_HDR; b->prev=a->top;
+  ch->used+=need; a->top=(char*)b+IXJS_ARENA_HDR;
+  return a->top;
+}
+
+/* Resize p, in place if it is the last allocation and its chunk has room. */
+static void *i_arena_grow(XJSArena *a, char *p, XJSSize size)
+{ IXJSBlk *b=(IXJSBlk*)(p-IXJS_ARENA_HDR); XJSSize old=b->size; char *q;
+  if ((p==a->top)&&((XJSSize)(IXJS_CHUNK_DATA(a->cur)+a->cur->size-p)>=IXJS_ARENA_UP(size)))
+  { b->size=IXJS_ARENA_UP(size); a->cur->used=(XJSSize)(p-IXJS_CHUNK_DATA(a->cur))+b->size;
+    return p;
+  }
+  if ((q=(char*)i_arena_alloc(a, size))==NULL) return NULL;
+  memcpy(q, p, (old<size)?old:size);
+  return q;
+}
+
+/* Give p back if it is the last allocation, the one before it is next. */
+static void i_arena_pop(XJSArena *a, char *p)
+{ IXJSBlk *b;
+  if ((p==NULL)||(p!=a->top)) return;
+  b=(IXJSBlk*)(p-IXJS_ARENA_HDR);
+  a->cur->used=(XJSSize)((char*)b-IXJS_CHUNK_DATA(a->cur)); a->top=b->prev;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns an arena or NULL
+** ---------------------------------------------------------------------------
+*/
+XJSArena *xjs_arena_new(XJSSize chunk_size)
+{ XJSArena *a=(XJSArena*)malloc(sizeof(XJSArena));
+  if (a==NULL) return NULL;
+  i_arena_init(a, NULL, 0);
+  if (chunk_size) a->grow=IXJS_ARENA_UP(chunk_size);
+  return a;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns storage from the arena or NULL
+** ---------------------------------------------------------------------------
+*/
+void *xjs_arena_alloc(XJSArena *arena, XJSSize size)
+{ return (arena)?i_arena_alloc(arena, size):NULL;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_arena_reset(XJSArena *arena)
+{ IXJSChunk *ch;
+  if (arena==NULL) return;
+  for (ch=arena->first;ch;ch=ch->next) ch->used=0;
+  arena->cur=arena->first; arena->top=NULL;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_arena_free(XJSArena *arena)
+{ if (arena==NULL) return;
+  i_arena_release(arena); free(arena);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or XJS_ERR_USAGE once the parse has started
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_arena(XJSParser *parser, XJSArena *arena)
+{ IXJSCtx *c=&parser->c;
+  if ((c->fed)||(c->err)) return XJS_ERR_USAGE;
+  if (arena) c->arena=arena;
+  else c->arena=(c->mem_cb==i_mem_fallback)?&parser->a:NULL; // back to its own
+  return XJS_OK;
+}
+#endif
+
+/* ---------------------------------------------------------------------------
+** Adapter to drive the length delimited parser with a null terminated
+** XJSInputCB (see xjs_parse).
+** ---------------------------------------------------------------------------
+*/
+typedef struct { XJSInputCB inp_cb; void *inp_arg; } IXJSInpLegacy;
+static int i_inp_legacy(const char **input, XJSSize *len, void *inp_arg)
+{ IXJSInpLegacy *l=(IXJSInpLegacy*)inp_arg; int r=l->inp_cb(input, l->inp_arg);
+  *len=((r==XJS_OK)&&(*input))?i_strlen(*input):0;
+  return r;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_parse(const char *json, XJSNodeCB node_cb, void *node_arg, XJSInputCB inp_cb, void *inp_arg, XJSMemCB mem_cb, const char **errpos)
+{ IXJSInpLegacy l; l.inp_cb=inp_cb; l.inp_arg=inp_arg;
+  return xjs_parse_n(json, (json)?i_strlen(json):0, node_cb, node_arg, (inp_cb)?i_inp_legacy:NULL, &l, mem_cb, errpos);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_parse_n(const char *json, XJSSize len, XJSNodeCB node_cb, void *node_arg, XJSInputNCB inp_cb, void *inp_arg, XJSMemCB mem_cb, const char **errpos)
+{ IXJSCtx c; IXJSFrame stk[IXJS_MEM_STACK_SIZE]; 
+  i_ctx_init(&c, node_cb, NULL, node_arg, mem_cb, stk, IXJS_MEM_STACK_SIZE); c.inp_cb=inp_cb; c.inp_arg=inp_arg;
+  return i_parse_local(&c, json, len, errpos);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_parse_view(const char *json, XJSSize len, XJSNodeViewCB node_cb, void *node_arg, XJSInputNCB inp_cb, void *inp_arg, XJSMemCB mem_cb, const char **errpos)
+{ IXJSCtx c; IXJSFrame stk[IXJS_MEM_STACK_SIZE]; 
+  i_ctx_init(&c, NULL, node_cb, node_arg, mem_cb, stk, IXJS_MEM_STACK_SIZE); c.inp_cb=inp_cb; c.inp_arg=inp_arg;
+  return i_parse_local(&c, json, len, errpos);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_parse_desc(const char *json, XJSSize len, XJSNodeDescCB node_cb, void *node_arg, XJSInputNCB inp_cb, void *inp_arg, XJSMemCB mem_cb, const char **errpos)
+{ IXJSCtx c; IXJSFrame stk[IXJS_MEM_STACK_SIZE]; 
+  i_ctx_init(&c, NULL, NULL, node_arg, mem_cb, stk, IXJS_MEM_STACK_SIZE); c.inp_cb=inp_cb; c.inp_arg=inp_arg;
+  c.desc_cb=node_cb; c.views=1;
+  return i_parse_local(&c, json, len, errpos);
+}
+
+/* ---------------------------------------------------------------------------
+** Create a push parser with one of the node callbacks.
+** ---------------------------------------------------------------------------
+*/
+static XJSParser *i_parser_new(XJSNodeCB node_cb, XJSNodeViewCB view_cb, void *node_arg, XJSMemCB mem_cb)
+{ XJSSize actsz=0; XJSParser *p; XJSMemCB m=(mem_cb)?mem_cb:i_mem_fallback;
+  if (m==NULL) return NULL;
+  p=(XJSParser*)m(XJS_alloc, XJS_parser, NULL, sizeof(XJSParser), &actsz);
+  if (p==NULL) return NULL;
+  if (actsz<sizeof(XJSParser)) { m(XJS_free, XJS_parser, p, 0, NULL); return NULL; }
+  i_ctx_init(&p->c, node_cb, view_cb, node_arg, m, p->stk, IXJS_MEM_STACK_SIZE); p->c.more=1;
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+  i_arena_init(&p->a, NULL, 0);
+  if (mem_cb==NULL) p->c.arena=&p->a; // the parser itself is from libc
+#endif
+  return p;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns a push parser or NULL
+** ---------------------------------------------------------------------------
+*/
+XJSParser *xjs_parser_new(XJSNodeCB node_cb, void *node_arg, XJSMemCB mem_cb)
+{ return i_parser_new(node_cb, NULL, node_arg, mem_cb);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns a push parser or NULL
+** ---------------------------------------------------------------------------
+*/
+XJSParser *xjs_parser_new_view(XJSNodeViewCB node_cb, void *node_arg, XJSMemCB mem_cb)
+{ return i_parser_new(NULL, node_cb, node_arg, mem_cb);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns a push parser or NULL
+** ---------------------------------------------------------------------------
+*/
+XJSParser *xjs_parser_new_desc(XJSNodeDescCB node_cb, void *node_arg, XJSMemCB mem_cb)
+{ XJSParser *p=i_parser_new(NULL, NULL, node_arg, mem_cb);
+  if (p) { p->c.desc_cb=node_cb; p->c.views=1; }
+  return p;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or XJS_ERR_USAGE once the parse has started
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_limit(XJSParser *parser, int max_depth, void *stack, XJSSize stack_size)
+{ IXJSCtx *c=&parser->c; int n=(int)(stack_size/sizeof(IXJSFrame));
+  if ((c->fed)||(c->err)) return XJS_ERR_USAGE;
+  if (stack)
+  { if (n<2) return XJS_ERR_USAGE; // the document and one container
+    memcpy(stack, c->stk, sizeof(IXJSFrame)); // the document frame
+    if (c->stkmem) i_mem(c, XJS_free, XJS_parser, c->stk, 0, NULL);
+    c->stk=(IXJSFrame*)stack; c->stksz=n; c->stkmem=0; c->stkfix=1;
+  }
+  c->mxdepth=(max_depth>0)?max_depth:IXJS_MAX_DEPTH;
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns the bytes of stack for xjs_parser_limit
+** ---------------------------------------------------------------------------
+*/
+XJSSize xjs_stack_size(int max_depth)
+{ return (XJSSize)((max_depth>0)?max_depth+1:1)*sizeof(IXJSFrame);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or XJS_ERR_USAGE once the parse has started
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_options(XJSParser *parser, int options)
+{ IXJSCtx *c=&parser->c; 
+  if ((c->fed)||(c->err)||(options&~IXJS_OPT_ALL)||((c->elem)&&(options&XJS_OPT_SEQ))) return XJS_ERR_USAGE;
+  c->opts=options; return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or XJS_ERR_USAGE once the parse has started
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_numbers(XJSParser *parser, XJSNumberCB num_cb)
+{ IXJSCtx *c=&parser->c; 
+  if ((c->fed)||(c->err)) return XJS_ERR_USAGE;
+  c->num_cb=num_cb; return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or XJS_ERR_USAGE once the parse has started
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_batch(XJSParser *parser, XJSEvent *events, int size, XJSBatchCB batch_cb)
+{ IXJSCtx *c=&parser->c; 
+  if ((c->fed)||(c->err)||((batch_cb)&&((events==NULL)||(size<1)))) return XJS_ERR_USAGE;
+  c->bat.cb=batch_cb; c->bat.ev=events; c->bat.size=size; 
+  c->views=(batch_cb)||(c->view_cb)||(c->desc_cb);
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_number(const char *text, XJSSize len, XJSNumber *num)
+{ if ((text==NULL)||(num==NULL)) return XJS_ERR_USAGE;
+  return i_num_decode(text, text+len, num);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_filter_new(XJSFilter **filter, const char *const *paths, int npaths, int flags, XJSMemCB mem_cb)
+{ XJSFilter *x; IXJSFSeg *g; char *t; const char *q; XJSMemCB m=(mem_cb)?mem_cb:i_mem_fallback; 
+  XJSSize nseg=0, ntxt=0, sz, actsz=0; int i, doc=0;
+  if (filter==NULL) return XJS_ERR_USAGE;
+  *filter=NULL;
+  if ((paths==NULL)||(npaths<1)||(npaths>IXJS_FILTER_MAX)||(flags&~XJS_FILTER_STOP)) return XJS_ERR_USAGE;
+  if (m==NULL) return XJS_ERR_MEM_MISSING;
+  for (i=0;i<npaths;i++) // JSON Pointers: "" or "/name/...", ~0 is ~ and ~1 is /
+  { if ((q=paths[i])==NULL) return XJS_ERR_USAGE;
+    if ((*q)&&((*q)!='/')) return XJS_ERR_USAGE;
+    for (;*q;q++,ntxt++) 
+    { if ((*q)=='/') nseg++;
+      else if (((*q)=='~')&&(q[1]!='0')&&(q[1]!='1')) return XJS_ERR_USAGE;
+    }
+  }
+  sz=sizeof(XJSFilter)+(XJSSize)npaths*sizeof(IXJSFPath)+nseg*sizeof(IXJSFSeg)+ntxt;
+  if ((x=(XJSFilter*)m(XJS_alloc, XJS_filter, NULL, sz, &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+  x->mem_cb=m; x->n=npaths; x->flags=flags; x->all=x->need=0;
+  x->path=(IXJSFPath*)(x+1); g=(IXJSFSeg*)(x->path+npaths); t=(char*)(g+nseg);
+  for (i=0;i<npaths;i++)
+  { IXJSU64 b=1ULL<<i; int wild=0;
+    x->path[i].seg=g; x->path[i].nseg=0;
+    for (q=paths[i];*q;)
+    { g->s=t; g->n=0; q++; // the slash
+      for (;(*q)&&((*q)!='/');q++) { *t++=((*q)=='~')?((*++q=='0')?'~':'/'):*q; g->n++; }
+      g->idx=(XJSSize)-1; 
+      if ((g->n)&&(g->n<20)&&((g->s[0]!='0')||(g->n==1))) // an array index is decimal without leading zeros
+      { XJSSize k, v=0; 
+        for (k=0;(k<g->n)&&(IXJS_DIGIT(g->s[k]));k++) v=v*10+(XJSSize)(g->s[k]-'0'); 
+        if (k==g->n) g->idx=v;
+      }
+      if ((g->n==1)&&(g->s[0]=='*')) { g->s=NULL; wild=1; }
+      x->path[i].nseg++; g++;
+    }
+    if (x->path[i].nseg==0) doc=1; // the whole document
+    else { x->all|=b; if (!wild) x->need|=b; }
+  }
+  if (doc) x->all=0;
+  *filter=x;
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_filter_free(XJSFilter *filter)
+{ if (filter) filter->mem_cb(XJS_free, XJS_filter, filter, 0, NULL);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or XJS_ERR_USAGE once the parse has started
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_filter(XJSParser *parser, const XJSFilter *filter)
+{ IXJSCtx *c=&parser->c; 
+  if ((c->fed)||(c->err)) return XJS_ERR_USAGE;
+  c->filt=filter; c->stk[0].fl=(filter)?filter->all:0; 
+  if (c->elem) c->stk[1].fl=c->stk[0].fl; // the array is on every path
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_keys_new(XJSKeys **keys, const char *const *names, int nnames, XJSMemCB mem_cb)
+{ XJSKeys *k; XJSMemCB m=(mem_cb)?mem_cb:i_mem_fallback; IXJSU64 *h=NULL; int *order, *first;
+  XJSSize ntxt=0, sz, actsz=0, len; char *t; int i, j, nb, ns, round, r=XJS_ERR_USAGE;
+  if (keys==NULL) return XJS_ERR_USAGE;
+  *keys=NULL;
+  if ((names==NULL)||(nnames<1)||(nnames>0x10000000)) return XJS_ERR_USAGE;
+  if (m==NULL) return XJS_ERR_MEM_MISSING;
+  for (i=0;i<nnames;i++) { if (names[i]==NULL) return XJS_ERR_USAGE; ntxt+=sizeof(int)+i_strlen(names[i])+1; }
+  for (ns=8;ns<nnames*2;ns*=2); // slots, half used
+  nb=(ns/4>nnames)?nnames:ns/4; for (j=1;j<nb;j*=2); nb=j; // buckets of about 2 keys
+  sz=sizeof(XJSKeys)+(XJSSize)nnames*sizeof(IXJSKey)+(XJSSize)nb*sizeof(unsigned)+(XJSSize)ns*sizeof(int)+ntxt;
+  if ((k=(XJSKeys*)m(XJS_alloc, XJS_keys, NULL, sz, &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+  k->mem_cb=m; k->n=nnames; k->bmask=nb-1; 
+  for (k->sbits=0;(1<<k->sbits)<ns;k->sbits++);
+  k->key=(IXJSKey*)(k+1); k->disp=(unsigned*)(k->key+nnames); k->slot=(int*)(k->disp+nb);
+  k->text=t=(char*)(k->slot+ns); k->tend=t+ntxt;
+  for (i=0;i<nnames;i++)
+  { len=i_strlen(names[i]); memcpy(t, &i, sizeof(int)); t+=sizeof(int);
+    memcpy(t, names[i], len+1); k->key[i].s=t; k->key[i].n=len; t+=len+1;
+  }
+  sz=(XJSSize)nnames*sizeof(IXJSU64)+(XJSSize)(nnames+nb+1)*sizeof(int); // the hashes, and the keys by bucket
+  if ((h=(IXJSU64*)m(XJS_alloc, XJS_keys, NULL, sz, &actsz))==NULL) { xjs_keys_free(k); return XJS_ERR_MEM_ALLOC; }
+  order=(int*)(h+nnames); first=order+nnames;
+  for (round=0;round<64;round++) // another seed now and then if a bucket can't be placed
+  { k->seed=0x9E3779B97F4A7C15ULL*(IXJSU64)(round+1);
+    for (i=0;i<=nb;i++) first[i]=0;
+    for (i=0;i<nnames;i++) { h[i]=i_key_hash(k->seed, k->key[i].s, k->key[i].n); first[(h[i]&(IXJSU64)k->bmask)+1]++; }
+    for (i=0;i<nb;i++) first[i+1]+=first[i];
+    for (i=0;i<nnames;i++) order[first[h[i]&(IXJSU64)k->bmask]++]=i;
+    for (i=nb;i>0;i--) first[i]=first[i-1]; 
+    first[0]=0;
+    if ((r=i_key_place(k, h, order, first))!=XJS_NOPE) break;
+  }
+  m(XJS_free, XJS_keys, h, 0, NULL);
+  if (r!=XJS_OK) { xjs_keys_free(k); return (r==XJS_NOPE)?XJS_ERR:r; }
+  *keys=k;
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_keys_free(XJSKeys *keys)
+{ if (keys) keys->mem_cb(XJS_free, XJS_keys, keys, 0, NULL);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns the id of a name the parser passed, or XJS_KEY_UNKNOWN
+** ---------------------------------------------------------------------------
+*/
+int xjs_key(const XJSKeys *keys, const char *name)
+{ int id;
+  if ((keys==NULL)||(name==NULL)||(name<keys->text)||(name>=keys->tend)) return XJS_KEY_UNKNOWN;
+  memcpy(&id, name-sizeof(int), sizeof(int));
+  return id;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or XJS_ERR_USAGE once the parse has started
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_keys(XJSParser *parser, const XJSKeys *keys)
+{ IXJSCtx *c=&parser->c; 
+  if ((c->fed)||(c->err)) return XJS_ERR_USAGE;
+  c->keys=keys; return XJS_OK;
+}
+
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or XJS_ERR_USAGE once the parse has started
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_columns(XJSParser *parser, XJSColumnCB col_cb, int rows)
+{ IXJSCtx *c=&parser->c; 
+  if ((c->fed)||(c->err)||(rows<0)) return XJS_ERR_USAGE;
+  c->cols.cb=col_cb; c->cols.rows=(rows)?rows:IXJS_COL_ROWS; 
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_block_index_new(XJSBlockIndex **bi, const char *json, XJSSize len, XJSInputNCB inp_cb, void *inp_arg, XJSSize every, XJSMemCB mem_cb, const char **errpos)
+{ IXJSCtx c; IXJSFrame stk[IXJS_MEM_STACK_SIZE]; IXJSBix b; XJSMemCB m=(mem_cb)?mem_cb:i_mem_fallback; int r, i; const char *t;
+  *errpos=NULL;
+  if (bi==NULL) return XJS_ERR_USAGE;
+  *bi=NULL;
+  if (m==NULL) return XJS_ERR_MEM_MISSING;
+  memset(&b, 0, sizeof(b)); b.c=&c; b.m=m; b.every=(every)?every:IXJS_BIX_EVERY;
+  i_ctx_init(&c, NULL, i_bix_node, &b, mem_cb, stk, IXJS_MEM_STACK_SIZE); c.inp_cb=inp_cb; c.inp_arg=inp_arg; c.bix=&b;
+  r=i_parse_local(&c, json, len, errpos);
+  if ((r==XJS_OK)&&(!b.in)) r=XJS_ERR_NO_INPUT;
+  if ((r==XJS_OK)&&((r=i_bix_make(bi, m, b.text, b.ntext, b.ncol))==XJS_OK))
+  { (*bi)->every=b.every; (*bi)->nrec=b.nrec; (*bi)->nmark=b.nmark; (*bi)->end=b.end;
+    (*bi)->mark=b.mark; b.mark=NULL; // the index keeps the marks
+    for (i=0,t=(*bi)->text;i<b.ncol;i++,t+=i_strlen(t)+1) (*bi)->name[i]=t;
+  }
+  if (b.mark) m(XJS_free, XJS_index, b.mark, 0, NULL);
+  if (b.text) m(XJS_free, XJS_index, b.text, 0, NULL);
+  return r;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_block_index_free(XJSBlockIndex *bi)
+{ if (bi==NULL) return;
+  if (bi->mark) bi->mem_cb(XJS_free, XJS_index, bi->mark, 0, NULL);
+  bi->mem_cb(XJS_free, XJS_index, bi, 0, NULL);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns the number of records in the indexed block
+** ---------------------------------------------------------------------------
+*/
+XJSSize xjs_block_index_records(const XJSBlockIndex *bi)
+{ return (bi)?bi->nrec:0;
+}
+
+/*
+** The saved form of an index, every number is 8 bytes little endian:
+** IXJS_BIX_MAGIC, every, nrec, nmark, end, ncol, ntext, the marks, then
+** the header names (null terminated).
+*/
+#define IXJS_BIX_MAGIC  "xjsbix1\n"
+#define IXJS_BIX_HEAD   (8+6*8)
+
+static void i_put64(unsigned char *p, IXJSU64 v) { int i; for (i=0;i<8;i++,v>>=8) p[i]=(unsigned char)v; }
+static IXJSU64 i_get64(const unsigned char *p) { IXJSU64 v=0; int i; for (i=7;i>=0;i--) v=(v<<8)|p[i]; return v; }
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns the bytes of the saved index, written to buf if size is enough
+** ---------------------------------------------------------------------------
+*/
+XJSSize xjs_block_index_save(const XJSBlockIndex *bi, void *buf, XJSSize size)
+{ unsigned char *p=(unsigned char*)buf; XJSSize need, k;
+  if (bi==NULL) return 0;
+  need=IXJS_BIX_HEAD+bi->nmark*8+bi->ntext;
+  if ((p==NULL)||(size<need)) return need;
+  memcpy(p, IXJS_BIX_MAGIC, 8); p+=8;
+  i_put64(p, bi->every); i_put64(p+8, bi->nrec); i_put64(p+16, bi->nmark); 
+  i_put64(p+24, bi->end); i_put64(p+32, (IXJSU64)bi->ncol); i_put64(p+40, bi->ntext); p+=48;
+  for (k=0;k<bi->nmark;k++,p+=8) i_put64(p, bi->mark[k]);
+  if (bi->ntext) memcpy(p, bi->text, bi->ntext);
+  return need;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_block_index_load(XJSBlockIndex **bi, const void *buf, XJSSize len, XJSMemCB mem_cb)
+{ const unsigned char *p=(const unsigned char*)buf; XJSMemCB m=(mem_cb)?mem_cb:i_mem_fallback; 
+  IXJSU64 v[6]; XJSSize k, actsz=0, n=0; XJSBlockIndex *x; const char *t, *e; int i, r;
+  if (bi==NULL) return XJS_ERR_USAGE;
+  *bi=NULL;
+  if ((p==NULL)||(len<IXJS_BIX_HEAD)||(memcmp(p, IXJS_BIX_MAGIC, 8)!=0)) return XJS_ERR_BAD_INPUT;
+  if (m==NULL) return XJS_ERR_MEM_MISSING;
+  for (i=0;i<6;i++) { v[i]=i_get64(p+8+i*8); if ((IXJSU64)(XJSSize)v[i]!=v[i]) return XJS_ERR_BAD_INPUT; } // fits this platform
+  if ((v[0]==0)||(v[2]!=(v[1]+v[0]-1)/v[0])||(v[4]>0x10000000)||(v[2]>(len-IXJS_BIX_HEAD)/8)||(len!=IXJS_BIX_HEAD+v[2]*8+v[5])) return XJS_ERR_BAD_INPUT;
+  t=(const char*)p+IXJS_BIX_HEAD+v[2]*8; e=t+v[5];
+  for (k=0;k<v[5];k++) if (t[k]==0) n++;
+  if ((n!=v[4])||((v[5])&&(e[-1]!=0))) return XJS_ERR_BAD_INPUT; // ncol names, null terminated
+  if ((r=i_bix_make(&x, m, t, (XJSSize)v[5], (int)v[4]))!=XJS_OK) return r;
+  x->every=(XJSSize)v[0]; x->nrec=(XJSSize)v[1]; x->nmark=(XJSSize)v[2]; x->end=(XJSSize)v[3];
+  if ((x->nmark)&&((x->mark=(XJSSize*)m(XJS_alloc, XJS_index, NULL, x->nmark*sizeof(XJSSize), &actsz))==NULL)) { xjs_block_index_free(x); return XJS_ERR_MEM_ALLOC; }
+  for (k=0;k<x->nmark;k++) x->mark[k]=(XJSSize)i_get64(p+IXJS_BIX_HEAD+k*8);
+  for (i=0,t=x->text;i<x->ncol;i++,t+=i_strlen(t)+1) x->name[i]=t;
+  *bi=x;
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or XJS_ERR_USAGE once the parse has started
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_block(XJSParser *parser, const XJSBlockIndex *bi, XJSSize rec, XJSSize count, void *parent, XJSSize *offset)
+{ IXJSCtx *c=&parser->c; IXJSFrame *b; IXJSStr s; XJSSize k; int i, r;
+  if ((c->fed)||(c->err)||(c->depth)||(c->st!=IXJS_S_VALUE)||(bi==NULL)||(rec>bi->nrec)||(offset==NULL)||(c->stksz<2)) return XJS_ERR_USAGE;
+  if (rec<bi->nrec) { k=rec/bi->every; *offset=bi->mark[k]; c->bskip=rec-k*bi->every; c->st=IXJS_S_REC; }
+  else { *offset=bi->end; c->bskip=0; c->st=IXJS_S_NEXT; } // only the end of the block
+  c->brem=count;
+  b=c->stk+1; i_frame_init(b, XJS_block, parent); c->depth=1;
+  b->cnt=1+rec-c->bskip; b->hcnt=bi->ncol; // the header and the records before the mark
+  for (i=0;i<bi->ncol;i++) // the header as the block's own header would be kept
+  { i_str_init(&s, XJS_name, NULL, 0); 
+    if ((r=i_str_append(c, &s, bi->name[i], i_strlen(bi->name[i])))!=XJS_OK) { i_str_free(c, &s); return r; }
+    i_hdr_add(c, b, &s);
+  }
+  if ((c->cols.cb)&&((r=i_col_begin(c, b))!=XJS_OK)) return r;
+  c->cols.first=rec;
+  return XJS_OK;
+}
+#endif
+
+#ifdef XJS_CFLAG_ENABLE_STATS
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_stats(XJSParser *parser, XJSStats *stats)
+{ if (stats) memset(stats, 0, sizeof(XJSStats));
+  parser->c.stats=stats;
+  return XJS_OK;
+}
+#endif
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_elements(XJSParser *parser, XJSSize first)
+{ IXJSCtx *c=&parser->c; IXJSFrame *f; int r;
+  if ((c->fed)||(c->err)||(c->depth)||(c->st!=IXJS_S_VALUE)||(c->opts&XJS_OPT_SEQ)) return XJS_ERR_USAGE;
+  if ((r=i_stack_grow(c))!=XJS_OK) return r;
+  f=c->stk+1; i_frame_init(f, XJS_array, NULL); c->depth=1; c->elem=1;
+  f->cnt=first; f->fl=c->stk[0].fl;
+  c->st=(first)?IXJS_S_VALUE:IXJS_S_FIRST; // after a comma there must be an element
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_parse(XJSParser *parser, const char *json, XJSSize len, XJSInputNCB inp_cb, void *inp_arg, const char **errpos)
+{ IXJSCtx *c=&parser->c; int r;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  unsigned long long t=(c->stats)?i_ticks():0, cb=(c->stats)?c->stats->cb_ticks:0;
+#endif
+  *errpos=NULL;
+  if (c->err) return c->err;
+  if (c->fed) return XJS_ERR_USAGE; // the input is being pushed
+  c->inp_cb=inp_cb; c->inp_arg=inp_arg; c->more=0;
+  if ((c->opts&XJS_OPT_INDEX)&&(inp_cb==NULL)&&(json)&&(len)) i_index(c, json, len); // without it if it fails
+  r=i_parse_pull(c, json, len, errpos);
+  i_index_free(c);
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if (c->stats) i_stats_done(c, t, cb);
+#endif
+  c->err=(r==XJS_OK)?XJS_ERR_USAGE:r; // nothing more to parse
+  return r;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_MORE, XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_feed(XJSParser *parser, const char *json, XJSSize len, const char **errpos)
+{ IXJSCtx *c=&parser->c; int r;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  unsigned long long t=(c->stats)?i_ticks():0, cb=(c->stats)?c->stats->cb_ticks:0;
+#endif
+  if (errpos) *errpos=NULL;
+  if (c->err) return c->err;
+  if (len==0) return ((c->st==IXJS_S_DONE)||(c->st==IXJS_S_STOP)||(i_run_between(c)))?XJS_OK:XJS_MORE;
+  if (json==NULL) return XJS_ERR_USAGE;
+  if (c->end!=i_eof) c->bufpos+=(XJSSize)(c->end-c->buf); // the last piece was not used up
+  c->fed=1; c->cur=c->buf=json; c->end=json+len; 
+  if (c->tok) c->tok->seg=json; // the token continues in this buffer
+  r=i_run(c);
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if (c->stats) i_stats_done(c, t, cb);
+#endif
+  if ((r!=XJS_OK)&&(r!=XJS_MORE)) 
+  { c->err=r; 
+    if (errpos) *errpos=(c->end==i_eof)?c->eofpos:c->cur;
+  }
+  return r;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_finish(XJSParser *parser, const char **errpos)
+{ IXJSCtx *c=&parser->c; int r;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  unsigned long long t=(c->stats)?i_ticks():0, cb=(c->stats)?c->stats->cb_ticks:0;
+#endif
+  if (errpos) *errpos=NULL;
+  if (c->err) return c->err;
+  c->more=0; c->cur=c->end=i_eof; // the engine sees the end of the input
+  r=(c->fed)?i_run(c):XJS_ERR_NO_INPUT;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if (c->stats) i_stats_done(c, t, cb);
+#endif
+  if ((r!=XJS_OK)&&(errpos)) *errpos=c->eofpos;
+  c->err=(r==XJS_OK)?XJS_ERR_USAGE:r; // nothing more to parse
+  return r;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_parser_free(XJSParser *parser)
+{ IXJSCtx *c;
+  if (parser==NULL) return;
+  c=&parser->c; 
+  i_stack_free(c); i_index_free(c);
+  if (c->stkmem) i_mem(c, XJS_free, XJS_parser, c->stk, 0, NULL);
+  if (c->bat.text) i_mem(c, XJS_free, XJS_parser, c->bat.text, 0, NULL);
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+  i_arena_release(&parser->a); // a caller's arena is left as it is
+#endif
+  c->mem_cb(XJS_free, XJS_parser, parser, 0, NULL);
+}
+
+/* ---------------------------------------------------------------------------
+** Set up a context for one parse, stk is the initial stack (or NULL).
+** ---------------------------------------------------------------------------
+*/
+static void i_ctx_init(IXJSCtx *c, XJSNodeCB node_cb, XJSNodeViewCB view_cb, void *node_arg, XJSMemCB mem_cb, IXJSFrame *stk, int stksz)
+{ memset(c, 0, sizeof(IXJSCtx));
+  c->node_cb=node_cb; c->view_cb=view_cb; c->node_arg=node_arg; c->mem_cb=mem_cb; c->views=(view_cb!=NULL);
+  c->cur=c->end=c->eofpos=i_eof; c->st=IXJS_S_VALUE; c->mxdepth=IXJS_MAX_DEPTH;
+  c->stk=stk; c->stksz=stksz;
+  if (stk) i_frame_init(stk, XJS_unknown, NULL);
+  i_str_init(&c->val, XJS_unknown, NULL, 0);
+}
+
+/* ---------------------------------------------------------------------------
+** Parse a whole document, asking the input callback for the input after
+** json. Everything the open containers hold is released before returning.
+** ---------------------------------------------------------------------------
+*/
+static int i_parse_pull(IXJSCtx *c, const char *json, XJSSize len, const char **errpos)
+{ int r; *errpos=NULL; 
+  if ((c->mem_cb==NULL)&&(c->arena==NULL)) return XJS_ERR_MEM_MISSING;
+  if ((json==NULL)||(len==0)) { if (c->inp_cb==NULL) return XJS_ERR_NO_INPUT; } // the first refill asks for it
+  else { c->cur=c->buf=json; c->end=json+len; }
+  c->eofpos=json;
+  r=i_run(c);
+  *errpos=(c->end==i_eof)?c->eofpos:c->cur; 
+  i_stack_free(c);
+  return r;
+}
+
+/*
+** i_parse_pull for xjs_parse and friends, the context is on the C stack. With
+** no memory manager callback the storage is from an arena whose first chunk
+** is on the C stack too, so small documents are parsed without allocating.
+*/
+static int i_parse_local(IXJSCtx *c, const char *json, XJSSize len, const char **errpos)
+{ int r; 
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+  XJSArena a; IXJSU64 buf[IXJS_MEM_ARENA_LOCAL/sizeof(IXJSU64)];
+  if (c->mem_cb==NULL) { i_arena_init(&a, buf, sizeof(buf)); c->arena=&a; }
+#endif
+  r=i_parse_pull(c, json, len, errpos);
+  if (c->stkmem) i_mem(c, XJS_free, XJS_parser, c->stk, 0, NULL); // it grew out of stk
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+  if (c->mem_cb==NULL) i_arena_release(&a);
+#endif
+  return r;
+}
+
+/* ---------------------------------------------------------------------------
+** The parse engine. A loop driven state machine instead of recursion: the
+** open containers are frames on c->stk, the state between tokens is in
+** c->st and the state inside a token in c->sub (see IXJS_S_* and IXJS_T_*).
+**
+** <white> '{' <white> (',' <white> <string> <white> ':' <white> <any> <white>)* '}'
+** <white> '[' <white> (',' <white> <any> <white>)* ']' 
+** <white> '(' <white> (',' <white> <array> <white>)* ')'  (blocks, the first array is the header)
+**
+** A token can be left in the middle when a buffer runs out. For pulled
+** input i_refill gets the next buffer and the scan goes on. For pushed input
+** it copies what is still needed out of the buffer and returns XJS_MORE,
+** the next xjs_feed continues from there.
+** ---------------------------------------------------------------------------
+*/
+static int i_run(IXJSCtx *c)
+{ int r; IXJSFrame *f; char ch;
+  for (;;)
+  { f=c->stk+c->depth;
+    if (c->st>=IXJS_S_STR) // continue the token
+    { if (c->st==IXJS_S_STOP) return i_run_stop(c, XJS_OK);
+      if (c->st==IXJS_S_STR) { if ((r=i_run_string(c))==XJS_OK) r=i_run_strend(c, f); }
+      else if (c->st==IXJS_S_NUM) { if ((r=i_run_number(c))==XJS_OK) if ((r=i_tok_end(c, &c->val))==XJS_OK) r=i_run_value(c, f, XJS_number, &c->val); }
+      else if (c->st==IXJS_S_SKIP) // the close bracket is at the cursor
+      { if ((r=i_run_skip(c))==XJS_OK) 
+        { if (c->drop) r=i_run_undrop(c, f); 
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+          else if (c->tok) r=i_col_rawend(c, f); // a container in a cell, kept as text
+#endif
+          else c->st=IXJS_S_NEXT; 
+        } 
+      }
+      else if ((r=i_run_literal(c))==XJS_OK) r=i_run_value(c, f, c->vkind, NULL);
+      if (r!=XJS_OK) return i_run_stop(c, r);
+      continue;
+    }
+    if ((r=i_eatwhite(c))!=XJS_OK) return i_run_stop(c, r);
+    ch=*c->cur;
+    switch (c->st)
+    { case IXJS_S_FIRST: 
+        if (ch==']') { r=i_run_close(c, f); break; }
+        c->st=IXJS_S_VALUE; // fall through
+      case IXJS_S_VALUE: 
+        r=i_run_begin(c, f, ch); break;
+      case IXJS_S_KEY0: 
+        if (ch=='}') { r=i_run_close(c, f); break; } // fall through
+      case IXJS_S_KEY: 
+        if (ch!='"') { r=XJS_ERR_EXP_END_STRING; break; }
+        c->cur++; c->sub=0; c->vkind=XJS_name; c->st=IXJS_S_STR;
+        i_str_init(&f->key, XJS_name, NULL, 0); i_tok_begin(c, &f->key);
+        break;
+      case IXJS_S_COLON: 
+        if (ch!=':') { r=XJS_ERR_EXP_COLON; break; }
+        c->cur++; c->st=IXJS_S_VALUE; break;
+      case IXJS_S_NEXT: 
+        if (ch==',') 
+        { c->cur++; c->st=(f->kind==XJS_object)?IXJS_S_KEY:IXJS_S_VALUE; 
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+          if (f->kind==XJS_block) c->st=IXJS_S_REC;
+#endif
+          break;
+        }
+        if (ch==((f->kind==XJS_object)?'}':']')) { r=i_run_close(c, f); break; }
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+        if ((ch==')')&&(f->kind==XJS_block)) { r=i_run_close(c, f); break; }
+#endif
+        r=XJS_ERR_EXP_COMMA; break;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+      case IXJS_S_HDR: 
+        if (ch==')') { r=i_run_close(c, f); break; } // fall through
+      case IXJS_S_REC: 
+        if (ch!='[') { r=XJS_ERR_BAD_INPUT; break; }
+        r=i_run_open(c, (c->st==IXJS_S_HDR)?XJS_block_header:XJS_block_array); break;
+#endif
+      default: // IXJS_S_DONE
+        r=XJS_ERR_MORE_INPUT; break;
+    }
+    if (r!=XJS_OK) return i_run_stop(c, r);
+  }
+}
+
+/*
+** The engine stops at the end of the input (XJS_MORE or XJS_END) or on an
+** error. The end of the input is only an error inside the document.
+*/
+static int i_run_stop(IXJSCtx *c, int r)
+{ int b;
+  if ((c->bat.n)&&((b=i_batch_flush(c))!=XJS_OK)&&((r==XJS_OK)||(r==XJS_MORE)||(r==XJS_END))) return b; // events may view the input, they are passed on before the engine returns
+  if ((r==XJS_MORE)&&((c->st==IXJS_S_DONE)||(i_run_between(c)))) return XJS_OK;
+  if (r!=XJS_END) return r;
+  if ((c->st==IXJS_S_DONE)||((c->st==IXJS_S_VALUE)&&(c->depth==0))||(i_run_between(c))) return XJS_OK; // complete, or only white space
+  return ((c->st==IXJS_S_STR)||((c->st==IXJS_S_SKIP)&&(c->sub)))?XJS_ERR_EXP_END_STRING:XJS_ERR_BAD_INPUT;
+}
+
+/*
+** The input may end here without a complete document: between two
+** documents (XJS_OPT_SEQ), or between two elements (xjs_parser_elements).
+*/
+static int i_run_between(IXJSCtx *c)
+{ if (c->opts&XJS_OPT_SEQ) return (c->st==IXJS_S_VALUE)&&(c->depth==0);
+  return (c->elem)&&(c->depth==1)&&((c->st==IXJS_S_NEXT)||(c->st==IXJS_S_FIRST));
+}
+
+/*
+** Start the value at the cursor: open a container or begin a token.
+*/
+static int i_run_begin(IXJSCtx *c, IXJSFrame *f, char ch)
+{ XJSType context=XJS_string; int r;
+  if ((f->fl)&&((r=i_filter(c, f, ch))!=XJS_OK))
+  { if (r!=XJS_NOPE) return r;
+    if (ch=='{') return i_run_drop(c, XJS_object);
+    if (ch=='[') return i_run_drop(c, XJS_array);
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    if (ch=='(') return i_run_drop(c, XJS_block);
+#endif
+    c->drop=1; // a scalar is still checked
+  }
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if (f->kind==XJS_block_header) { if (ch!='"') return XJS_ERR_EXP_END_STRING; context=XJS_name; } // header fields are names
+  if ((c->cols.on)&&(f->kind==XJS_block_array)&&((ch=='{')||(ch=='[')||(ch=='('))) return i_col_raw(c, ch);
+  if (ch=='(') return i_run_open(c, XJS_block);
+#endif
+  if (ch=='{') return i_run_open(c, XJS_object);
+  if (ch=='[') return i_run_open(c, XJS_array);
+  if ((c->depth==0)&&(!(c->opts&XJS_OPT_SEQ))) return XJS_ERR_BAD_INPUT; // can only be a container at the top level
+  c->vpos=c->bufpos+(XJSSize)(c->cur-c->buf);
+  c->sub=0; c->vkind=XJS_string; c->st=IXJS_S_NUM;
+  if (ch=='"') { c->cur++; c->st=IXJS_S_STR; }
+  else if (ch=='-') c->sub=IXJS_T_SIGN;
+  else if (ch=='0') c->sub=IXJS_T_ZERO;
+  else if (IXJS_DIGIT(ch)) c->sub=IXJS_T_INT;
+  else
+  { c->st=IXJS_S_LIT;
+    if (ch=='t') { c->lit="rue"; c->vkind=XJS_true; }
+    else if (ch=='f') { c->lit="alse"; c->vkind=XJS_false; }
+    else if (ch=='n') { c->lit="ull"; c->vkind=XJS_null; }
+    else return XJS_ERR_BAD_INPUT;
+    c->cur++; 
+    return XJS_OK;
+  }
+  if (c->st==IXJS_S_NUM) context=XJS_number;
+  i_str_init(&c->val, context, NULL, 0); i_tok_begin(c, &c->val);
+  if (c->st==IXJS_S_NUM) c->cur++; // the number token starts with this character
+  return XJS_OK;
+}
+
+/*
+** Open a container at the cursor, signal it and push its frame.
+*/
+static int i_run_open(IXJSCtx *c, XJSType kind)
+{ IXJSFrame *f, *n; int r;
+  if (c->depth>=c->mxdepth) return XJS_ERR_DEPTH;
+  if ((r=i_stack_grow(c))!=XJS_OK) return r;
+  f=c->stk+c->depth; n=f+1; c->depth++;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if ((c->stats)&&(c->depth>c->stats->max_depth)) c->stats->max_depth=c->depth;
+#endif
+  i_frame_init(n, kind, f->np);
+  if (f->fl) n->fl=c->fl;
+  c->st=(kind==XJS_object)?IXJS_S_KEY0:IXJS_S_FIRST;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if (kind==XJS_block) c->st=IXJS_S_HDR;
+#endif
+  c->cur++;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if ((kind==XJS_block_array)&&((c->bix)||(c->bskip))) return i_bix_rec(c, n); // passed over
+  if ((kind==XJS_block_array)&&(c->cols.on)) return XJS_OK; // the record goes to the columns
+#endif
+  r=i_emit(c, f, &n->np, kind, i_slot(c, f), NULL);
+  if (r!=XJS_SKIP) return r;
+  if ((kind==XJS_array)||(kind==XJS_object)
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+      ||(kind==XJS_block)
+#endif
+     ) { c->st=IXJS_S_SKIP; c->sub=0; c->subn=1; }
+  return XJS_OK;
+}
+
+static void i_frame_init(IXJSFrame *f, XJSType kind, void *np)
+{ f->kind=kind; f->np=np; f->ev=-1; f->cnt=0; f->fl=0; i_str_init(&f->key, XJS_name, NULL, 0);
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  f->hdr=NULL; f->hn=f->tcnt=f->hcnt=0;
+#endif
+}
+
+/*
+** Close the innermost container at the cursor, signal it and pop its frame.
+*/
+static int i_run_close(IXJSCtx *c, IXJSFrame *f)
+{ int r; XJSType kind=f->kind, end=XJS_array_end;
+  if ((c->elem)&&(c->depth==1)) return XJS_ERR_BAD_INPUT; // the close bracket is not part of the elements
+  if (kind==XJS_object) end=XJS_object_end;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  else if (kind==XJS_block) 
+  { end=XJS_block_end; 
+    if ((c->cols.on)&&((r=i_col_flush(c, f))!=XJS_OK)) return r; // the last batch
+    i_col_free(c); i_hdr_free(c, f); 
+  }
+  else if (kind==XJS_block_header) end=XJS_block_header_end;
+  else if (kind==XJS_block_array) end=XJS_block_array_end;
+#endif
+  c->cur++;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if ((kind==XJS_block_array)&&((c->cols.on)||(f->hcnt<0))) r=XJS_OK; else
+#endif
+  r=i_emit(c, f-1, &f->np, end, i_slot(c, f-1), NULL);
+  i_str_free(c, &f->key); c->depth--;
+  if ((r!=XJS_OK)&&(r!=XJS_SKIP)) return r;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if (kind==XJS_block_header) 
+  { (f-1)->hcnt=(int)f->cnt;
+    if ((c->cols.cb)&&((r=i_col_begin(c, f-1))!=XJS_OK)) return r;
+  }
+  else if ((kind==XJS_block_array)&&(f->hcnt>=0)) // a record that was parsed
+  { if (f->cnt!=(XJSSize)(f-1)->hcnt) return XJS_ERR_BLOCK_ARRAY_SIZE;
+    if ((c->cols.on)&&((++c->cols.n)>=c->cols.rows)&&((r=i_col_flush(c, f-1))!=XJS_OK)) return r;
+    if ((c->brem)&&((--c->brem)==0)) // the last one asked for (xjs_parser_block)
+    { if ((c->cols.on)&&((r=i_col_flush(c, f-1))!=XJS_OK)) return r;
+      i_run_done(c, f-1); c->st=IXJS_S_STOP; 
+      return XJS_OK;
+    }
+  }
+#endif
+  return i_run_done(c, f-1);
+}
+
+/*
+** A value of the container f is complete. With XJS_OPT_SEQ a top level
+** value ends a document and the engine waits for the next one.
+*/
+static int i_run_done(IXJSCtx *c, IXJSFrame *f)
+{ void *np=NULL; int r;
+  f->cnt++;
+  if (f->kind==XJS_object) i_str_free(c, &f->key);
+  c->st=(c->depth)?IXJS_S_NEXT:IXJS_S_DONE;
+  if ((c->depth==0)&&(c->opts&XJS_OPT_SEQ))
+  { c->st=IXJS_S_VALUE;
+    r=i_emit(c, f, &np, XJS_document_end, NULL, NULL);
+    return (r==XJS_SKIP)?XJS_OK:r;
+  }
+  if ((c->fend)&&(c->depth<c->fend)) c->st=IXJS_S_STOP; // the last path the filter needed is complete
+  return XJS_OK;
+}
+
+/*
+** Signal a scalar value of the container f, and release it.
+*/
+static int i_run_value(IXJSCtx *c, IXJSFrame *f, XJSType kind, IXJSStr *value)
+{ void *np=f->np; int r;
+  if (c->drop) { c->drop=0; return i_run_done(c, f); } // filtered out
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if ((c->cols.on)&&(f->kind==XJS_block_array)) r=i_col_put(c, f, kind, value); else
+#endif
+  if ((kind==XJS_number)&&(c->num_cb)&&(c->bat.cb==NULL)) r=i_emit_num(c, &np, i_slot(c, f), value);
+  else r=i_emit(c, f, &np, kind, i_slot(c, f), value);
+  if (value) i_str_free(c, value);
+  if ((r!=XJS_OK)&&(r!=XJS_SKIP)) return r; // nothing to skip
+  return i_run_done(c, f);
+}
+
+/*
+** The string at the cursor is complete (the close quote is at the cursor).
+*/
+static int i_run_strend(IXJSCtx *c, IXJSFrame *f)
+{ IXJSStr *s=c->tok; int r;
+  if ((r=i_tok_end(c, s))!=XJS_OK) return r;
+  c->cur++; // the close quote, the buffer is only refilled by the next state
+  if (c->vkind==XJS_name) { c->st=IXJS_S_COLON; return XJS_OK; }
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if (f->kind==XJS_block_header) 
+  { if ((r=i_str_copy(c, s))==XJS_OK) r=i_emit(c, f, &f->np, XJS_name, i_slot(c, f), s); // header names outlive the input buffer
+    i_hdr_add(c, f-1, s);
+    if ((r!=XJS_OK)&&(r!=XJS_SKIP)) return r;
+    return i_run_done(c, f);
+  }
+#endif
+  return i_run_value(c, f, XJS_string, s);
+}
+
+/*
+** Scan a string up to its close quote. JSON strings are surrounded by
+** double quotes, runs of plain characters are found by the i_scan_str
+** kernel within the current buffer. Escapes and multi-byte UTF-8 sequences
+** are checked a byte at a time (i_run_seq) so they can continue in the next
+** buffer, they stay in the string as they are in the input.
+*/
+static int i_run_string(IXJSCtx *c)
+{ int r; const char *p; 
+  if ((c->ixq)&&(c->cur==c->ixs)) { c->cur=c->ixq; c->ixq=NULL; return XJS_OK; } // known from the index
+  for (;;)
+  { if (c->cur>=c->end) { if ((r=i_refill(c))!=XJS_OK) return r; continue; }
+    if (c->sub) { if ((r=i_run_seq(c))!=XJS_OK) return r; continue; }
+    c->cur=p=i_scan_str(c->cur, c->end);
+    if (p>=c->end) continue;
+    if ((*p)=='"') return XJS_OK;
+    if ((*p)=='\\') 
+    { c->sub=IXJS_T_ESC; c->cur++; 
+      if ((c->opts&XJS_OPT_DECODE)&&(!c->drop)) if ((r=i_esc_begin(c, p))!=XJS_OK) return r;
+      continue; 
+    }
+#ifndef XJS_CFLAG_DISABLE_UTF8_CHECK
+    if (((unsigned char)*p)>=0x80) 
+    { unsigned char u=(unsigned char)*p; c->lo=0x80; c->hi=0xBF; 
+      if (u<0xC2) return XJS_ERR_BAD_UTF8;
+      else if (u<0xE0) c->subn=1;
+      else if (u<0xF0) { c->subn=2; if (u==0xE0) c->lo=0xA0; else if (u==0xED) c->hi=0x9F; }
+      else if (u<0xF5) { c->subn=3; if (u==0xF0) c->lo=0x90; else if (u==0xF4) c->hi=0x8F; }
+      else return XJS_ERR_BAD_UTF8;
+      c->sub=IXJS_T_UTF8; c->cur++; 
+      continue;
+    }
+#endif
+    return XJS_ERR_CONTROL_CHAR;
+  }
+}
+
+/*
+** Check the bytes of an escape or a UTF-8 sequence, as far as the buffer
+** goes. c->sub is 0 when the sequence is complete. When decoding, the
+** escape is replaced by its UTF-8 in the token, which continues after it.
+*/
+static int i_run_seq(IXJSCtx *c)
+{ unsigned char ch; int r=XJS_OK, dec=((c->opts&XJS_OPT_DECODE)&&(!c->drop)), esc;
+  while ((c->sub)&&(c->cur<c->end))
+  { ch=(unsigned char)*c->cur; esc=(c->sub!=IXJS_T_UTF8);
+    if (c->sub==IXJS_T_ESC)
+    { if (ch=='u') { c->sub=IXJS_T_HEX; c->subn=4; c->cp=0; }
+      else if ((ch=='"')||(ch=='\\')||(ch=='/')) { c->sub=0; if (dec) r=i_esc_put(c, ch); }
+      else if ((ch=='b')||(ch=='f')||(ch=='n')||(ch=='r')||(ch=='t')) 
+      { c->sub=0; 
+        if (dec) r=i_esc_put(c, (ch=='b')?'\b':(ch=='f')?'\f':(ch=='n')?'\n':(ch=='r')?'\r':'\t');
+      }
+      else return XJS_ERR_EXP_ESCAPE;
+    }
+    else if (c->sub==IXJS_T_HEX)
+    { if (!IXJS_CC(ch, IXJS_CC_HEX)) return XJS_ERR_EXP_ESCAPE_HEX;
+      c->cp=(c->cp<<4)|(unsigned)((ch<='9')?ch-'0':(ch|0x20)-'a'+10);
+      if ((--c->subn)==0) { c->sub=0; if (dec) r=i_esc_unit(c); }
+    }
+    else if (c->sub==IXJS_T_LOW) { if (ch!='\\') return XJS_ERR_BAD_SURROGATE; c->sub=IXJS_T_LOWU; }
+    else if (c->sub==IXJS_T_LOWU) { if (ch!='u') return XJS_ERR_BAD_SURROGATE; c->sub=IXJS_T_HEX; c->subn=4; c->cp=0; }
+    else 
+    { if ((ch<c->lo)||(ch>c->hi)) return XJS_ERR_BAD_UTF8;
+      c->lo=0x80; c->hi=0xBF;
+      if ((--c->subn)==0) c->sub=0;
+    }
+    if (r!=XJS_OK) return r;
+    c->cur++;
+    if ((dec)&&(esc)) c->tok->seg=c->cur; // the escape itself is not kept
+  }
+  return XJS_OK;
+}
+
+/*
+** Decoding: the string up to the backslash at p goes to the token storage,
+** from here on the token is collected there.
+*/
+static int i_esc_begin(IXJSCtx *c, const char *p)
+{ IXJSStr *s=c->tok; int r;
+  if ((r=i_str_append(c, s, s->seg, (XJSSize)(p-s->seg)))!=XJS_OK) return r;
+  s->copied=1; s->seg=p+1;
+  return XJS_OK;
+}
+
+/*
+** Decoding: a \u code unit is complete, pair up surrogates.
+*/
+static int i_esc_unit(IXJSCtx *c)
+{ unsigned u=c->cp;
+  if (c->hs) 
+  { if ((u<0xDC00)||(u>0xDFFF)) return XJS_ERR_BAD_SURROGATE;
+    u=0x10000+((c->hs-0xD800)<<10)+(u-0xDC00); c->hs=0;
+  }
+  else if ((u>=0xD800)&&(u<=0xDBFF)) { c->hs=u; c->sub=IXJS_T_LOW; return XJS_OK; }
+  else if ((u>=0xDC00)&&(u<=0xDFFF)) return XJS_ERR_BAD_SURROGATE;
+  return i_esc_put(c, u);
+}
+
+/*
+** Decoding: append the code point u as UTF-8.
+*/
+static int i_esc_put(IXJSCtx *c, unsigned u)
+{ char b[4]; XJSSize n;
+  if (u<0x80) { b[0]=(char)u; n=1; }
+  else if (u<0x800) { b[0]=(char)(0xC0|(u>>6)); b[1]=(char)(0x80|(u&0x3F)); n=2; }
+  else if (u<0x10000) { b[0]=(char)(0xE0|(u>>12)); b[1]=(char)(0x80|((u>>6)&0x3F)); b[2]=(char)(0x80|(u&0x3F)); n=3; }
+  else { b[0]=(char)(0xF0|(u>>18)); b[1]=(char)(0x80|((u>>12)&0x3F)); b[2]=(char)(0x80|((u>>6)&0x3F)); b[3]=(char)(0x80|(u&0x3F)); n=4; }
+  return i_str_append(c, c->tok, b, n);
+}
+
+/*
+** Scan a JSON number up to the first character after it.
+*/
+static int i_run_number(IXJSCtx *c)
+{ int r; const char *p=c->cur, *e=c->end;
+  for (;;)
+  { if (p>=e) 
+    { c->cur=p; 
+      if ((r=i_refill(c))!=XJS_OK) return ((r==XJS_END)&&((c->sub==IXJS_T_INT)||(c->sub==IXJS_T_ZERO)||(c->sub==IXJS_T_FRAC)||(c->sub==IXJS_T_EXPD)))?XJS_OK:r; // a top level number can end the input
+      p=c->cur; e=c->end; continue; 
+    }
+    switch (c->sub)
+    { case IXJS_T_SIGN: 
+        if (!IXJS_DIGIT(*p)) { c->cur=p; return XJS_ERR_EXP_DIGIT; }
+        c->sub=((*p++)=='0')?IXJS_T_ZERO:IXJS_T_INT; continue;
+      case IXJS_T_INT: 
+        while ((p<e)&&(IXJS_DIGIT(*p))) p++;
+        if (p>=e) continue; // fall through
+      case IXJS_T_ZERO: 
+        if ((*p)=='.') { c->sub=IXJS_T_DOT; p++; continue; }
+        if (((*p)=='e')||((*p)=='E')) { c->sub=IXJS_T_EXP; p++; continue; }
+        break;
+      case IXJS_T_DOT:
+        if (!IXJS_DIGIT(*p)) { c->cur=p; return XJS_ERR_EXP_DIGIT; }
+        c->sub=IXJS_T_FRAC; p++; continue;
+      case IXJS_T_FRAC: 
+        while ((p<e)&&(IXJS_DIGIT(*p))) p++;
+        if (p>=e) continue;
+        if (((*p)=='e')||((*p)=='E')) { c->sub=IXJS_T_EXP; p++; continue; }
+        break;
+      case IXJS_T_EXP: 
+        if (((*p)=='+')||((*p)=='-')) { c->sub=IXJS_T_ESIGN; p++; continue; } // fall through
+      case IXJS_T_ESIGN:
+        if (!IXJS_DIGIT(*p)) { c->cur=p; return XJS_ERR_EXP_DIGIT; }
+        c->sub=IXJS_T_EXPD; p++; continue;
+      default: // IXJS_T_EXPD
+        while ((p<e)&&(IXJS_DIGIT(*p))) p++;
+        if (p>=e) continue;
+        break;
+    }
+    c->cur=p; 
+    return XJS_OK;
+  }
+}
+
+/*
+** Match the rest of a literal, it must not run into more letters or digits.
+*/
+static int i_run_literal(IXJSCtx *c)
+{ int r; 
+  for (;;)
+  { if (c->cur>=c->end) { if ((r=i_refill(c))!=XJS_OK) return ((r==XJS_END)&&((*c->lit)==0))?XJS_OK:r; continue; }
+    if ((*c->lit)==0) return (IXJS_CC(*c->cur, IXJS_CC_ALNUM))?XJS_ERR_BAD_LITERAL:XJS_OK;
+    if ((*c->cur)!=(*c->lit)) return XJS_ERR_BAD_LITERAL;
+    c->cur++; c->lit++;
+  }
+}
+
+/*
+** Pass over the contents of a container the callback skipped, up to its
+** close bracket. Nothing is signaled, copied or checked but the brackets,
+** and the strings so brackets in them are not counted. The engine checks
+** the close bracket (IXJS_S_NEXT) once the cursor is on it.
+*/
+static int i_run_skip(IXJSCtx *c)
+{ int r; const char *p; char ch;
+  if ((c->ix)&&(i_run_skip_ix(c)==XJS_OK)) return XJS_OK;
+  for (;;)
+  { if (c->cur>=c->end) { if ((r=i_refill(c))!=XJS_OK) return r; continue; }
+    if (c->sub==IXJS_T_QESC) { c->sub=IXJS_T_QUOTE; c->cur++; continue; }
+    c->cur=p=i_scan_skip(c->cur, c->end);
+    if (p>=c->end) continue;
+    ch=*p;
+    if (c->sub) { if (ch=='"') c->sub=0; else if (ch=='\\') c->sub=IXJS_T_QESC; }
+    else if (ch=='"') c->sub=IXJS_T_QUOTE;
+    else if ((ch=='[')||(ch=='{')) c->subn++;
+    else if ((ch==']')||(ch=='}')) { if ((--c->subn)==0) return XJS_OK; }
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    else if (ch=='(') c->subn++;
+    else if (ch==')') { if ((--c->subn)==0) return XJS_OK; }
+#endif
+    c->cur++;
+  }
+}
+
+/*
+** Index mode: the brackets outside strings are entries, count them. If the
+** document ends first, returns XJS_NOPE and the scan above finds the error.
+*/
+static int i_run_skip_ix(IXJSCtx *c)
+{ XJSSize k=c->ixk; const char *q; char ch; int n=c->subn;
+  for (;k<c->ixn;k++)
+  { q=c->ixb+(c->ix[k]&IXJS_IX_OFF);
+    if (q<c->cur) continue;
+    ch=*q;
+    if ((ch=='[')||(ch=='{')) n++;
+    else if ((ch==']')||(ch=='}')) { if ((--n)==0) break; }
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    else if (ch=='(') n++;
+    else if (ch==')') { if ((--n)==0) break; }
+#endif
+  }
+  if (k>=c->ixn) return XJS_NOPE;
+  c->ixk=k; c->ixq=NULL; c->subn=0; c->cur=q;
+  return XJS_OK;
+}
+
+/*
+** A container the filter dropped is skipped like XJS_SKIP, but without a
+** frame or any event. vkind remembers its kind for the close bracket.
+*/
+static int i_run_drop(IXJSCtx *c, XJSType kind)
+{ c->cur++; c->vkind=kind; c->drop=1; 
+  c->st=IXJS_S_SKIP; c->sub=0; c->subn=1;
+  return XJS_OK;
+}
+
+static int i_run_undrop(IXJSCtx *c, IXJSFrame *f)
+{ char e=(c->vkind==XJS_object)?'}':']';
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if (c->vkind==XJS_block) e=')';
+#endif
+  if ((*c->cur)!=e) return XJS_ERR_EXP_COMMA;
+  c->cur++; c->drop=0;
+  return i_run_done(c, f);
+}
+
+/*
+** Match the value starting with ch in the container f against the paths f
+** is on. Returns XJS_OK if it is signaled, with c->fl the paths for the
+** container it opens (0 if a path ends at it, then all of it is signaled),
+** or XJS_NOPE if it is dropped. Paths don't lead into blocks, a block is
+** only kept whole.
+*/
+static int i_filter(IXJSCtx *c, IXJSFrame *f, char ch)
+{ const XJSFilter *x=c->filt; const IXJSFSeg *g; IXJSU64 l=f->fl, m=0, end=0, b; 
+  int p, d=c->depth, box=(ch=='{')||(ch=='[');
+  if (d==0) { c->fl=l; return (box)?XJS_OK:XJS_NOPE; } // the document is on every path
+  for (;l;l&=l-1)
+  { p=i_ctz64(l); b=l&(~l+1); g=x->path[p].seg+d-1;
+    if ((g->s)&&((f->kind==XJS_object)?((g->n!=f->key.n)||((g->n)&&(memcmp(g->s, f->key.p, g->n)!=0))):(g->idx!=f->cnt))) continue;
+    if (x->path[p].nseg==d) end|=b; else m|=b;
+  }
+  if (end) 
+  { c->fl=0; c->fseen|=end;
+    if ((x->flags&XJS_FILTER_STOP)&&(!(c->opts&XJS_OPT_SEQ))&&(x->need)&&((c->fseen&x->need)==x->need)&&(c->fend==0)) c->fend=d+1;
+  }
+  else if ((m)&&(box)) c->fl=m;
+  else return XJS_NOPE;
+  if ((!c->views)&&(f->kind==XJS_object)) // XJSNodeCB gets a copy of the name, NULL if empty
+  { if (f->key.n) return i_str_copy(c, &f->key);
+    f->key.p=NULL; f->key.copied=1;
+  }
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** Key dictionary. i_key_hash mixes a name 8 bytes at a time. The low bits
+** pick the bucket, the high ones h1 and h2 (odd) for the slot.
+** ---------------------------------------------------------------------------
+*/
+#define IXJS_KEY_SLOT(k, h, d) ((int)((((h)>>32)+(IXJSU64)(d)*(((h)>>16)|1))&((1ULL<<(k)->sbits)-1)))
+
+static IXJSU64 i_key_hash(IXJSU64 seed, const char *p, XJSSize n)
+{ IXJSU64 h=seed^((IXJSU64)n*0xC2B2AE3D27D4EB4FULL), w;
+  for (;n>=8;n-=8,p+=8) { memcpy(&w, p, 8); h=(h^w)*0xFF51AFD7ED558CCDULL; h^=h>>32; }
+  if (n) { w=0; memcpy(&w, p, n); h=(h^w)*0xFF51AFD7ED558CCDULL; h^=h>>32; }
+  h*=0xC4CEB9FE1A85EC53ULL;
+  return h^(h>>29);
+}
+
+/*
+** Give every bucket a displacement that puts its keys in free slots, the
+** biggest buckets first. Returns XJS_NOPE to try another seed, or
+** XJS_ERR_USAGE if two names are the same.
+*/
+static int i_key_place(XJSKeys *k, const IXJSU64 *h, int *order, const int *first)
+{ int ns=1<<k->sbits, nb=k->bmask+1, big=0, sz, b, i, j, s[8]; unsigned d;
+  for (i=0;i<ns;i++) k->slot[i]=-1;
+  for (b=0;b<nb;b++) { k->disp[b]=0; if ((first[b+1]-first[b])>big) big=first[b+1]-first[b]; }
+  if (big>8) return XJS_NOPE; // an unlucky seed
+  for (sz=big;sz>0;sz--) for (b=0;b<nb;b++) 
+  { const int *o=order+first[b];
+    if ((first[b+1]-first[b])!=sz) continue;
+    for (i=0;i<sz;i++) for (j=0;j<i;j++) 
+      if ((h[o[i]]==h[o[j]])&&(k->key[o[i]].n==k->key[o[j]].n)&&(memcmp(k->key[o[i]].s, k->key[o[j]].s, k->key[o[i]].n)==0)) return XJS_ERR_USAGE;
+    for (d=0;d<(unsigned)ns*4;d++)
+    { for (i=0;i<sz;i++) 
+      { s[i]=IXJS_KEY_SLOT(k, h[o[i]], d);
+        if (k->slot[s[i]]>=0) break;
+        for (j=0;(j<i)&&(s[j]!=s[i]);j++);
+        if (j<i) break;
+      }
+      if (i==sz) break;
+    }
+    if (i<sz) return XJS_NOPE;
+    for (i=0;i<sz;i++) k->slot[s[i]]=o[i];
+    k->disp[b]=d;
+  }
+  return XJS_OK;
+}
+
+/* The dictionary's copy of the name [p,p+n), or NULL if it is not in it. */
+static const char *i_key_find(const XJSKeys *k, const char *p, XJSSize n)
+{ IXJSU64 h=i_key_hash(k->seed, p, n); int id=k->slot[IXJS_KEY_SLOT(k, h, k->disp[h&(IXJSU64)k->bmask])];
+  if ((id<0)||(k->key[id].n!=n)||((n)&&(memcmp(k->key[id].s, p, n)!=0))) return NULL;
+  return k->key[id].s;
+}
+
+/*
+** The name for the value being parsed in the container f: the member name,
+** the position of an array element (as text, unless the callback gets it
+** as a number), or the header field of a block record.
+*/
+static const IXJSStr *i_slot(IXJSCtx *c, IXJSFrame *f)
+{ switch (f->kind)
+  { case XJS_object: return &f->key;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    case XJS_block_array: 
+      if (f->cnt<(XJSSize)(f-1)->hn) 
+      { const char *h=(f-1)->hdr[f->cnt]; // cells are named by the header
+        i_str_init(&c->slot, XJS_name, h, (h)?i_strlen(h):0); 
+        return &c->slot;
+      } // fall through
+    case XJS_block_header:
+#endif
+    case XJS_array:
+      if ((c->desc_cb)||(c->bat.cb)) return NULL;
+#ifndef XJS_CFLAG_DISABLE_ARRAY_POS_AS_NAME  
+      i_str_init(&c->slot, XJS_name, c->pos, i_utoa(c->pos, f->cnt+1));
+#else
+      i_str_init(&c->slot, XJS_name, NULL, 0);
+#endif
+      return &c->slot;
+    default: return NULL;
+  }
+}
+
+#ifndef XJS_CFLAG_DISABLE_ARRAY_POS_AS_NAME
+/*
+** Decimal text of v in b (null terminated), returns its length. Two digits
+** at a time, array positions are named for every element.
+*/
+static XJSSize i_utoa(char *b, XJSSize v)
+{ static const char d2[]="00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                         "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                         "8081828384858687888990919293949596979899";
+  char t[20]; int k=20; XJSSize n;
+  while (v>=100) { unsigned i=(unsigned)(v%100)*2; v/=100; t[--k]=d2[i+1]; t[--k]=d2[i]; }
+  if (v>=10) { t[--k]=d2[v*2+1]; t[--k]=d2[v*2]; } else t[--k]=(char)('0'+v);
+  n=(XJSSize)(20-k); memcpy(b, t+k, n); b[n]=0;
+  return n;
+}
+#endif
+
+/*
+** Make room for one more frame on the stack. A stack on the C stack (or a
+** push parser's first one) moves to storage from the memory manager, a
+** stack from the caller can't grow.
+*/
+static int i_stack_grow(IXJSCtx *c)
+{ XJSSize actsz=0, need=(XJSSize)(c->depth+2)*sizeof(IXJSFrame); IXJSFrame *s;
+  if ((c->depth+1)<c->stksz) return XJS_OK;
+  if (c->stkfix) return XJS_ERR_DEPTH;
+  s=(IXJSFrame*)i_mem(c, XJS_alloc, XJS_parser, (c->stkmem)?c->stk:NULL, (XJSSize)(c->stksz*2+IXJS_MEM_STACK_SIZE)*sizeof(IXJSFrame), &actsz);
+  if (s==NULL) return XJS_ERR_MEM_ALLOC;
+  if ((!c->stkmem)&&(actsz<need)) { i_mem(c, XJS_free, XJS_parser, s, 0, NULL); return XJS_ERR_MEM_ALLOC; }
+  if ((!c->stkmem)&&(c->stk)) memcpy(s, c->stk, (XJSSize)(c->depth+1)*sizeof(IXJSFrame));
+  c->stk=s; c->stkmem=1; c->stksz=(int)(actsz/sizeof(IXJSFrame));
+  return ((c->depth+1)<c->stksz)?XJS_OK:XJS_ERR_MEM_ALLOC;
+}
+
+/*
+** Release everything the open frames and the current token hold.
+*/
+static void i_stack_free(IXJSCtx *c)
+{ c->tok=NULL; 
+  for (;c->depth>0;c->depth--)
+  { i_str_free(c, &c->stk[c->depth].key);
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    i_hdr_free(c, &c->stk[c->depth]);
+#endif
+  }
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  i_col_free(c);
+#endif
+  i_str_free(c, &c->val); 
+}
+
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+/*
+** Keep a header name (a copy) in the block frame b for the records. The
+** name storage is taken from s.
+*/
+static void i_hdr_add(IXJSCtx *c, IXJSFrame *b, IXJSStr *s)
+{ XJSSize actsz=0; char **h;
+  if ((b->tcnt>=0)&&((b->hn+1)>=b->tcnt))
+  { h=(char**)i_mem(c, XJS_alloc, XJS_block_header, (void*)b->hdr, (b->hn+IXJS_MEM_HEADER_BLOCK_SIZE)*sizeof(char*), &actsz);
+    if (h) { b->hdr=h; b->tcnt=(int)(actsz/(sizeof(char*))); } 
+    else { i_hdr_free(c, b); b->tcnt=-1; } // no more header storage requests, the records are named by position
+  }
+  if ((b->hdr)&&(b->tcnt>b->hn)) { b->hdr[b->hn++]=s->mem; s->mem=NULL; }  // remember the name
+  i_str_free(c, s);
+}
+
+static void i_hdr_free(IXJSCtx *c, IXJSFrame *b)
+{ int i; 
+  if (b->hdr==NULL) return;
+  for (i=0;i<b->hn;i++) if (b->hdr[i]) i_mem(c, XJS_free, XJS_name, b->hdr[i], 0, NULL); 
+  i_mem(c, XJS_free, XJS_block_header, b->hdr, 0, NULL);
+  b->hdr=NULL; b->hn=0;
+}
+
+/*
+** Block columns. Once the header of the block b is complete the vectors of
+** its columns are laid out in one allocation, per column: i, d, off, kind
+** and the three bitmaps (every column starts 8 byte aligned).
+*/
+#define IXJS_COL_UP(n) (((n)+7)&~(XJSSize)7)
+
+static int i_col_begin(IXJSCtx *c, IXJSFrame *b)
+{ IXJSCols *k=&c->cols; XJSColumn *col; XJSSize rows=(XJSSize)k->rows, bm=(rows+7)/8, per, sz, actsz=0; char *m=NULL; int j, n=b->hcnt;
+  if (k->on) return XJS_OK; // a block is already collected
+  per=IXJS_COL_UP(rows*(sizeof(long long)+sizeof(double))+(rows+1)*sizeof(XJSSize)+rows+3*bm);
+  sz=IXJS_COL_UP((XJSSize)n*sizeof(XJSColumn))+IXJS_COL_UP((XJSSize)n*sizeof(XJSSize))+(XJSSize)n*per;
+  if (n)
+  { if ((m=(char*)i_mem(c, XJS_alloc, XJS_block_array, NULL, sz, &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+    if (actsz<sz) { i_mem(c, XJS_free, XJS_block_array, m, 0, NULL); return XJS_ERR_MEM_ALLOC; }
+  }
+  k->mem=m; k->col=(XJSColumn*)m; k->ncol=n;
+  if (n) { m+=IXJS_COL_UP((XJSSize)n*sizeof(XJSColumn)); k->tsz=(XJSSize*)m; m+=IXJS_COL_UP((XJSSize)n*sizeof(XJSSize)); }
+  for (j=0;j<n;j++,m+=per)
+  { col=k->col+j; col->name=(j<b->hn)?b->hdr[j]:NULL;
+    col->i=(long long*)m; col->d=(double*)(col->i+rows); col->off=(XJSSize*)(col->d+rows);
+    col->kind=(unsigned char*)(col->off+rows+1); col->ints=col->kind+rows; col->bools=col->ints+bm; col->nulls=col->bools+bm;
+    col->text=NULL; k->tsz[j]=0; col->off[0]=0; memset(col->ints, 0, 3*bm);
+  }
+  k->on=1; k->n=0; k->first=0;
+  return XJS_OK;
+}
+
+/*
+** A container in a cell is kept as its JSON text: it is passed over like
+** XJS_SKIP, collected as a token (val) from its open bracket on, and put in
+** the column at its close bracket (i_col_rawend). vkind is its kind.
+*/
+static int i_col_raw(IXJSCtx *c, char ch)
+{ c->vkind=(ch=='{')?XJS_object:(ch=='[')?XJS_array:XJS_block;
+  i_str_init(&c->val, XJS_string, NULL, 0); i_tok_begin(c, &c->val);
+  c->cur++; c->st=IXJS_S_SKIP; c->sub=0; c->subn=1;
+  return XJS_OK;
+}
+
+static int i_col_rawend(IXJSCtx *c, IXJSFrame *f)
+{ char e=(c->vkind==XJS_object)?'}':(c->vkind==XJS_array)?']':')'; int r;
+  if ((*c->cur)!=e) return XJS_ERR_EXP_COMMA;
+  c->cur++;
+  if ((r=i_tok_end(c, &c->val))!=XJS_OK) return r;
+  return i_run_value(c, f, c->vkind, &c->val);
+}
+
+/*
+** Put the cell of the record f, the next one in its column, in the current
+** row. Numbers are decoded, text is appended to the column's text.
+*/
+static int i_col_put(IXJSCtx *c, IXJSFrame *f, XJSType kind, const IXJSStr *v)
+{ IXJSCols *k=&c->cols; XJSColumn *col; XJSNumber num; XJSSize o, need, sz, actsz=0; char *t;
+  int r=k->n; XJSSize j=f->cnt; unsigned char bit=(unsigned char)(1u<<(r&7));
+  if (j>=(XJSSize)k->ncol) return XJS_ERR_BLOCK_ARRAY_SIZE;
+  col=k->col+j; o=col->off[r];
+  col->kind[r]=(unsigned char)kind; col->i[r]=0; col->d[r]=0;
+  if (kind==XJS_number)
+  { i_num_decode(v->p, v->p+v->n, &num); // the grammar was checked by the scanner
+    col->d[r]=num.d;
+    if (num.kind==XJS_NUM_INT) { col->i[r]=num.i; col->ints[r>>3]|=bit; }
+  }
+  else if (kind==XJS_true) col->bools[r>>3]|=bit;
+  else if (kind==XJS_null) col->nulls[r>>3]|=bit;
+  else if ((kind!=XJS_false)&&(v)&&(v->n)) // a string or a container
+  { need=o+v->n;
+    if (need>k->tsz[j])
+    { sz=(k->tsz[j])?k->tsz[j]*2:IXJS_MEM_STR_BLOCK_SIZE; while (sz<need) sz*=2; // doubles like strings
+      if ((t=(char*)i_mem(c, XJS_alloc, XJS_block_array, col->text, sz, &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+      col->text=t; k->tsz[j]=actsz;
+      if (actsz<need) return XJS_ERR_MEM_ALLOC;
+    }
+    memcpy(col->text+o, v->p, v->n); o=need;
+  }
+  col->off[r+1]=o;
+  return XJS_OK;
+}
+
+/*
+** Pass the records collected so far to the column callback with the parent
+** of the block b, and start the next batch.
+*/
+static int i_col_flush(IXJSCtx *c, IXJSFrame *b)
+{ IXJSCols *k=&c->cols; XJSColumns batch; XJSSize bm=((XJSSize)k->rows+7)/8; int j, r;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  unsigned long long t=(c->stats)?i_ticks():0;
+#endif
+  if (k->n==0) return XJS_OK;
+  if ((c->bat.n)&&((r=i_batch_flush(c))!=XJS_OK)) return r; // the events before the records
+  batch.rows=k->n; batch.first=k->first; batch.ncols=k->ncol; batch.col=k->col;
+  r=k->cb(&b->np, &batch, c->node_arg);
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if (c->stats) c->stats->cb_ticks+=i_ticks()-t;
+#endif
+  k->first+=(XJSSize)k->n; k->n=0;
+  for (j=0;j<k->ncol;j++) memset(k->col[j].ints, 0, 3*bm);
+  return r;
+}
+
+static void i_col_free(IXJSCtx *c)
+{ IXJSCols *k=&c->cols; int j;
+  for (j=k->ncol-1;j>=0;j--) if (k->col[j].text) i_mem(c, XJS_free, XJS_block_array, k->col[j].text, 0, NULL);
+  if (k->mem) i_mem(c, XJS_free, XJS_block_array, k->mem, 0, NULL);
+  k->on=k->n=k->ncol=0; k->first=0; k->col=NULL; k->tsz=NULL; k->mem=NULL;
+}
+
+/*
+** Block index. While one is built (c->bix), or a seek passes over the
+** records before the one asked for (c->bskip), the record n just opened is
+** passed over like XJS_SKIP: nothing in it is signaled or checked but the
+** brackets, and its end is not signaled. Every every-th record is marked
+** with the offset of its open bracket.
+*/
+static int i_bix_rec(IXJSCtx *c, IXJSFrame *n)
+{ IXJSBix *b=c->bix; XJSSize actsz=0, *m;
+  n->hcnt=-1; c->st=IXJS_S_SKIP; c->sub=0; c->subn=1;
+  if (b==NULL) { c->bskip--; return XJS_OK; }
+  if ((b->nrec%b->every)==0)
+  { if (b->nmark>=b->msz)
+    { if ((m=(XJSSize*)b->m(XJS_alloc, XJS_index, b->mark, ((b->msz)?b->msz*2:IXJS_MEM_HEADER_BLOCK_SIZE)*sizeof(XJSSize), &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+      b->mark=m; b->msz=actsz/sizeof(XJSSize);
+      if (b->nmark>=b->msz) return XJS_ERR_MEM_ALLOC;
+    }
+    b->mark[b->nmark++]=c->bufpos+(XJSSize)(c->cur-1-c->buf); // the open bracket is behind the cursor
+  }
+  b->nrec++;
+  return XJS_OK;
+}
+
+/*
+** The node callback while an index is built: the document must be a block,
+** its header names are collected, and the offset of its end is kept.
+*/
+static int i_bix_node(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *node_arg)
+{ IXJSBix *b=(IXJSBix*)node_arg; XJSSize need=b->ntext+value_len+1, actsz=0, sz; char *t;
+  if (!b->in) { if (kind!=XJS_block) return XJS_ERR_BAD_INPUT; b->in=1; return XJS_OK; }
+  if (kind==XJS_block_end) b->end=b->c->bufpos+(XJSSize)(b->c->cur-1-b->c->buf);
+  if (kind!=XJS_name) return XJS_OK;
+  if (need>b->tsz)
+  { sz=(b->tsz)?b->tsz*2:IXJS_MEM_STR_BLOCK_SIZE; while (sz<need) sz*=2;
+    if ((t=(char*)b->m(XJS_alloc, XJS_index, b->text, sz, &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+    b->text=t; b->tsz=actsz;
+    if (actsz<need) return XJS_ERR_MEM_ALLOC;
+  }
+  if (value_len) memcpy(b->text+b->ntext, value, value_len);
+  b->text[need-1]=0; b->ntext=need; b->ncol++;
+  return XJS_OK;
+}
+
+/* A new index with a copy of the header names (one allocation), the names are not set. */
+static int i_bix_make(XJSBlockIndex **bi, XJSMemCB m, const char *text, XJSSize ntext, int ncol)
+{ XJSBlockIndex *x; XJSSize sz=sizeof(XJSBlockIndex)+(XJSSize)ncol*sizeof(char*)+ntext, actsz=0; char *t;
+  if ((x=(XJSBlockIndex*)m(XJS_alloc, XJS_index, NULL, sz, &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+  if (actsz<sz) { m(XJS_free, XJS_index, x, 0, NULL); return XJS_ERR_MEM_ALLOC; }
+  memset(x, 0, sizeof(XJSBlockIndex));
+  x->mem_cb=m; x->ncol=ncol; x->name=(const char**)(x+1); 
+  t=(char*)(x->name+ncol); if (ntext) memcpy(t, text, ntext);
+  x->text=t; x->ntext=ntext;
+  *bi=x;
+  return XJS_OK;
+}
+#endif
+
+/* ---------------------------------------------------------------------------
+** Consume the white space in the input stream. Runs of white space are
+** skipped within the current buffer, refills only happen at its end.
+** ---------------------------------------------------------------------------
+*/
+static int i_eatwhite(IXJSCtx *c)
+{ int r; 
+  if (c->ix) return i_eatwhite_ix(c);
+  for (;;)
+  { const char *p=c->cur, *e=c->end;
+    if ((p<e)&&(!IXJS_CC(*p, IXJS_CC_WHITE))) return XJS_OK; // usually there is none
+    c->cur=p=i_scan_white(p, e); 
+    if (p<e) return XJS_OK;
+    if ((r=i_refill(c))!=XJS_OK) return r; 
+  }
+}
+
+/*
+** Index mode: move to the next entry. Entries behind the cursor (the close
+** quote of a string just scanned) are passed over. Only the rest of a
+** scalar can be between the cursor and the next entry that is not white
+** space, the engine stops there and reports it. A scalar at the end of
+** the input leaves the cursor on i_eof, where no entry can be.
+*/
+static int i_eatwhite_ix(IXJSCtx *c)
+{ XJSSize k=c->ixk; const char *q=c->end;
+  if (c->end==i_eof) return i_refill(c);
+  while ((k<c->ixn)&&((c->ixb+(c->ix[k]&IXJS_IX_OFF))<c->cur)) k++;
+  c->ixk=k;
+  if (k<c->ixn) q=c->ixb+(c->ix[k]&IXJS_IX_OFF);
+  if ((c->cur<q)&&(!IXJS_CC(*c->cur, IXJS_CC_WHITE))) return XJS_OK; 
+  c->cur=q;
+  if (k>=c->ixn) return i_refill(c); // only white space is left
+  if (((*q)=='"')&&(!(c->ix[k]&IXJS_IX_SLOW))&&((k+1)<c->ixn)) { c->ixs=q+1; c->ixq=c->ixb+(c->ix[k+1]&IXJS_IX_OFF); }
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** The current buffer is used up, ask the input callback for the next one.
+** The token being scanned and the member names on the stack are copied out
+** of the buffer first. Returns XJS_END (and parks the cursor on i_eof) when the input is
+** done.
+** ---------------------------------------------------------------------------
+*/
+static int i_refill(IXJSCtx *c)
+{ int r=XJS_END, i; const char *b=NULL; XJSSize n=0; 
+  if (c->end!=i_eof) 
+  { if ((c->bat.n)&&((r=i_batch_flush(c))!=XJS_OK)) return r; // the events may view the buffer
+    c->eofpos=c->end; c->bufpos+=(XJSSize)(c->end-c->buf);
+    if ((c->tok)&&(!c->drop)) 
+    { if (c->end>c->tok->seg) if ((r=i_str_append(c, c->tok, c->tok->seg, (XJSSize)(c->end-c->tok->seg)))!=XJS_OK) return r;
+      c->tok->copied=1;
+    }
+    for (i=1; i<=c->depth; i++) if (c->stk[i].kind==XJS_object) if ((r=i_str_copy(c, &c->stk[i].key))!=XJS_OK) return r;
+  }
+  c->cur=c->end=i_eof; 
+  if (c->tok) c->tok->seg=i_eof;
+  if (c->inp_cb==NULL) return (c->more)?XJS_MORE:XJS_END;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if (c->stats) c->stats->inputs++;
+#endif
+  if ((r=c->inp_cb(&b, &n, c->inp_arg))!=XJS_OK) { if (r==XJS_END) c->inp_cb=NULL; return r; }
+  if (b==NULL) return XJS_ERR_USAGE;
+  if (n==0) { c->inp_cb=NULL; return XJS_END; } // an empty buffer also ends the input
+  c->cur=c->buf=b; c->end=b+n;
+  if (c->tok) c->tok->seg=b;
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** Signal the node to the callback.
+** ---------------------------------------------------------------------------
+*/
+static int i_emit(IXJSCtx *c, IXJSFrame *f, void **np, XJSType kind, const IXJSStr *name, const IXJSStr *value)
+{ int r;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  unsigned long long t=0;
+  if (c->stats) i_stats_node(c->stats, kind, value);
+#endif
+  if (c->bat.cb) return i_batch_put(c, f, kind, name, value);
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if (c->stats) t=i_ticks();
+#endif
+  if (c->view_cb) r=c->view_cb(np, kind, (name)?name->p:NULL, (name)?name->n:0, (value)?value->p:NULL, (value)?value->n:0, c->node_arg);
+  else if (c->desc_cb) r=i_emit_desc(c, f, np, kind, name, value);
+  else r=c->node_cb(np, kind, (name)?name->p:NULL, (value)?value->p:NULL, c->node_arg);
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if (c->stats) c->stats->cb_ticks+=i_ticks()-t;
+#endif
+  return r;
+}
+
+static int i_emit_num(IXJSCtx *c, void **np, const IXJSStr *name, const IXJSStr *value)
+{ XJSNumber num; int r;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  unsigned long long t=0;
+  if (c->stats) { i_stats_node(c->stats, XJS_number, value); t=i_ticks(); }
+#endif
+  i_num_decode(value->p, value->p+value->n, &num); // the grammar was checked by the scanner
+  r=c->num_cb(np, (name)?name->p:NULL, (name)?name->n:0, value->p, value->n, &num, c->node_arg);
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if (c->stats) c->stats->cb_ticks+=i_ticks()-t;
+#endif
+  return r;
+}
+
+/*
+** Describe a node in the container f for XJSNodeDescCB. A scalar is at the
+** offset where it began, a bracket was just passed, the end of a document
+** is where the cursor is.
+*/
+static int i_emit_desc(IXJSCtx *c, IXJSFrame *f, void **np, XJSType kind, const IXJSStr *name, const IXJSStr *value)
+{ XJSNode d;
+  d.kind=kind; d.depth=(int)(f-c->stk);
+  d.index=(kind==XJS_document_end)?f->cnt-1:f->cnt;
+  d.name=(name)?name->p:NULL; d.name_len=(name)?name->n:0;
+  d.value=(value)?value->p:NULL; d.value_len=(value)?value->n:0;
+  if ((kind>=XJS_number)&&(kind<=XJS_name)) d.offset=c->vpos;
+  else 
+  { d.offset=c->bufpos+((c->end!=i_eof)?(XJSSize)(c->cur-c->buf):0);
+    if (kind!=XJS_document_end) d.offset--;
+  }
+  return c->desc_cb(np, &d, c->node_arg);
+}
+
+/*
+** Add an event for a node in the container f to the batch. Array positions
+** are the index instead of a name. A name or value outside the input buffer
+** is copied into the batch's text, the batch is passed on first if it
+** doesn't fit, and when it is full.
+*/
+static int i_batch_put(IXJSCtx *c, IXJSFrame *f, XJSType kind, const IXJSStr *name, const IXJSStr *value)
+{ IXJSBatch *b=&c->bat; XJSEvent *e; XJSSize need, actsz=0; int r;
+  need=i_batch_need(c, name)+i_batch_need(c, value);
+  if ((b->tn+need>b->tsz)&&((r=i_batch_flush(c))!=XJS_OK)) return r;
+  if (need>b->tsz) // the batch is empty
+  { XJSSize sz=(b->tsz)?b->tsz*2:IXJS_BATCH_TEXT; if (sz<need) sz=need;
+    char *m=(char*)i_mem(c, XJS_alloc, XJS_parser, b->text, sz, &actsz);
+    if ((m==NULL)||(actsz<need)) return XJS_ERR_MEM_ALLOC;
+    b->text=m; b->tsz=actsz;
+  }
+  e=b->ev+b->n;
+  e->kind=kind; e->depth=(int)(f-c->stk); e->parent=f->ev;
+  e->index=(kind==XJS_document_end)?f->cnt-1:f->cnt; // the document is counted before its end
+  e->name=i_batch_str(c, name, &e->name_len); 
+  e->value=i_batch_str(c, value, &e->value_len);
+  if ((kind==XJS_array)||(kind==XJS_object)
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+      ||(kind==XJS_block)||(kind==XJS_block_header)||(kind==XJS_block_array)
+#endif
+     ) (f+1)->ev=b->seq+b->n; // the container was pushed, its nodes refer to this event
+  if ((++b->n)==b->size) return i_batch_flush(c);
+  return XJS_OK;
+}
+
+/*
+** Bytes of s to copy into the batch: all of it unless it is a view of the
+** input buffer or a known name, which xjs_key finds by its address.
+*/
+static XJSSize i_batch_need(IXJSCtx *c, const IXJSStr *s)
+{ if ((s==NULL)||(s->n==0)) return 0;
+  if ((c->end!=i_eof)&&(s->p>=c->buf)&&(s->p<c->end)) return 0;
+  if ((c->keys)&&(s->p>=c->keys->text)&&(s->p<c->keys->tend)) return 0;
+  return s->n;
+}
+
+/* The text of s for an event, there is room for it in the batch. */
+static const char *i_batch_str(IXJSCtx *c, const IXJSStr *s, XJSSize *n)
+{ IXJSBatch *b=&c->bat; char *t;
+  if (s==NULL) { *n=0; return NULL; }
+  *n=s->n;
+  if (i_batch_need(c, s)==0) return s->p;
+  t=b->text+b->tn; memcpy(t, s->p, s->n); b->tn+=s->n;
+  return t;
+}
+
+/* Pass the events collected so far to the batch callback. */
+static int i_batch_flush(IXJSCtx *c)
+{ IXJSBatch *b=&c->bat; int n=b->n, r;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  unsigned long long t=(c->stats)?i_ticks():0;
+#endif
+  if (n==0) return XJS_OK;
+  b->n=0; b->tn=0;
+  r=b->cb(b->ev, n, b->seq, c->node_arg);
+  b->seq+=n;
+#ifdef XJS_CFLAG_ENABLE_STATS
+  if (c->stats) c->stats->cb_ticks+=i_ticks()-t;
+#endif
+  return r;
+}
+
+#ifdef XJS_CFLAG_ENABLE_STATS
+/* A clock for the stats, cycles where there is a cheap counter of them. */
+static unsigned long long i_ticks(void)
+{
+#ifdef IXJS_STATS_TSC
+  return (unsigned long long)__rdtsc();
+#else
+  return (unsigned long long)clock();
+#endif
+}
+
+static void i_stats_node(XJSStats *st, XJSType kind, const IXJSStr *value)
+{ switch (kind)
+  { case XJS_array: st->arrays++; break;
+    case XJS_object: st->objects++; break;
+    case XJS_number: st->numbers++; break;
+    case XJS_string: st->strings++; if (value->n>st->longest) st->longest=value->n; break;
+    case XJS_true: st->trues++; break;
+    case XJS_false: st->falses++; break;
+    case XJS_null: st->nulls++; break;
+    case XJS_name: st->names++; break;
+    case XJS_document_end: st->docs++; break;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    case XJS_block: st->blocks++; break;
+    case XJS_block_header: st->headers++; break;
+    case XJS_block_array: st->records++; break;
+#endif
+    default: break; // the ends
+  }
+}
+
+static void i_stats_mem(XJSStats *st, XJSMemReq action, void *prev, XJSSize size)
+{ if (action==XJS_free) { if (prev) st->frees++; return; }
+  if (prev) st->reallocs++; else st->allocs++;
+  st->alloc_bytes+=size;
+}
+
+/* After a call into the parser that started at t with cb ticks in callbacks so far. */
+static void i_stats_done(IXJSCtx *c, unsigned long long t, unsigned long long cb)
+{ XJSStats *st=c->stats;
+  st->parse_ticks+=(i_ticks()-t)-(st->cb_ticks-cb);
+  st->bytes=c->bufpos+((c->end!=i_eof)?(XJSSize)(c->cur-c->buf):0);
+}
+#endif
+
+/* ---------------------------------------------------------------------------
+** Token and string storage. A token starts as a view of the input, from
+** i_tok_begin to the cursor at i_tok_end. If the input moves on before the
+** token ends (i_refill), it is collected in storage from the memory manager.
+** The null terminated XJSNodeCB always gets a copy.
+** ---------------------------------------------------------------------------
+*/
+static void i_str_init(IXJSStr *s, XJSType context, const char *p, XJSSize n)
+{ s->p=p; s->n=n; s->seg=NULL; s->mem=NULL; s->mxsz=0; s->context=context; s->copied=(p!=NULL);
+}
+
+static int i_str_append(IXJSCtx *c, IXJSStr *s, const char *src, XJSSize len)
+{ XJSSize actsz=s->mxsz, want=s->n+len+1; // always leave room for the terminator
+  if ((s->mem==NULL)||(want>s->mxsz))
+  { XJSSize sz=(s->mxsz)?s->mxsz*2:IXJS_MEM_STR_BLOCK_SIZE; if (sz<want) sz=want; // doubles, a long string is copied a few times
+    char *m=(char*)i_mem(c, XJS_alloc, s->context, s->mem, sz, &actsz); 
+#ifdef XJS_CFLAG_ENABLE_STATS
+    if ((c->stats)&&(s->mem)) c->stats->grows++;
+#endif
+    if ((m==NULL)||(actsz<want)) return XJS_ERR_MEM_ALLOC;
+    s->mem=m; s->mxsz=actsz;
+  }
+  if (len) memcpy(s->mem+s->n, src, len);
+  s->n+=len; s->mem[s->n]=0; s->p=s->mem;
+  return XJS_OK;
+}
+
+static int i_str_copy(IXJSCtx *c, IXJSStr *s)
+{ int r; const char *p=s->p; XJSSize n=s->n;
+  if (s->copied) return XJS_OK;
+  if (n==0) { s->p=i_eof; s->copied=1; return XJS_OK; }
+  s->n=0; if ((r=i_str_append(c, s, p, n))!=XJS_OK) return r;
+  s->copied=1; return XJS_OK;
+}
+
+static void i_str_free(IXJSCtx *c, IXJSStr *s)
+{ if (s->mem) i_mem(c, XJS_free, s->context, s->mem, 0, NULL);
+  s->mem=NULL; s->p=NULL; s->n=0; s->mxsz=0;
+}
+
+static void i_tok_begin(IXJSCtx *c, IXJSStr *s)
+{ s->p=NULL; s->n=0; s->seg=c->cur; s->copied=0; c->tok=s;
+}
+
+static int i_tok_end(IXJSCtx *c, IXJSStr *s)
+{ XJSSize n=(XJSSize)(c->cur-s->seg); int copy=(!c->views)&&((c->num_cb==NULL)||(s->context!=XJS_number)); // typed numbers are views too
+  c->tok=NULL;
+  if (c->drop) return XJS_OK;
+  if ((c->keys)&&(c->vkind==XJS_name)) // a known name is the dictionary's copy
+  { const char *k; int r;
+    if (!s->copied) { if ((k=i_key_find(c->keys, s->seg, n))!=NULL) { s->p=k; s->n=n; s->copied=1; return XJS_OK; } }
+    else 
+    { if ((r=i_str_append(c, s, s->seg, n))!=XJS_OK) return r;
+      if ((k=i_key_find(c->keys, s->p, s->n))!=NULL) { n=s->n; i_str_free(c, s); s->p=k; s->n=n; }
+      return XJS_OK;
+    }
+  }
+  if ((copy)&&(s->context==XJS_name)&&(c->stk[c->depth].fl)) copy=0; // the filter copies the names it signals
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if ((c->cols.on)&&(c->stk[c->depth].kind==XJS_block_array)) copy=0; // cells are copied into the columns
+#endif
+  if ((s->copied)||(copy))
+  { if ((n)||(s->mem)) return i_str_append(c, s, s->seg, n); 
+    s->p=(c->views)?i_eof:NULL; s->copied=1; // empty, NULL for XJSNodeCB like the original API
+    return XJS_OK;
+  }
+  s->p=s->seg; s->n=n; 
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** Typed numbers. The digits are gathered into a 64 bit integer w (the first
+** 19 significant ones) and a decimal exponent q, the number is w*10^q.
+** Integers that fit are exact. A double is exact with one multiply or
+** divide when w and 10^q both are (Clinger). Otherwise Eisel-Lemire gets the
+** rounded double from the 128 bit product of w and 5^q (i_pow5), and when
+** more than 19 digits were cut and w and w+1 round apart, strtod decides.
+** ---------------------------------------------------------------------------
+*/
+#define IXJS_NUM_MAXW   19     /* significant digits kept in w */
+#define IXJS_NUM_SLOW   780    /* significant digits passed to strtod, enough to round any double */
+#define IXJS_POW5_MIN   (-342) /* range of i_pow5, beyond it a double is 0 or infinite */
+#define IXJS_POW5_MAX   308
+
+static const double i_pow10[23]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+/* 
+** 5^q for q in [IXJS_POW5_MIN,IXJS_POW5_MAX] normalized to 128 bits (most
+** significant bit set), truncated for q>=0 and rounded up for q<0.
+*/
+static const IXJSU64 i_pow5[][2]={
+  {0xeef453d6923bd65aULL,0x113faa2906a13b3fULL},{0x9558b4661b6565f8ULL,0x4ac7ca59a424c507ULL},
+  {0xbaaee17fa23ebf76ULL,0x5d79bcf00d2df649ULL},{0xe95a99df8ace6f53ULL,0xf4d82c2c107973dcULL},
+  {0x91d8a02bb6c10594ULL,0x79071b9b8a4be869ULL},{0xb64ec836a47146f9ULL,0x9748e2826cdee284ULL},
+  {0xe3e27a444d8d98b7ULL,0xfd1b1b2308169b25ULL},{0x8e6d8c6ab0787f72ULL,0xfe30f0f5e50e20f7ULL},
+  {0xb208ef855c969f4fULL,0xbdbd2d335e51a935ULL},{0xde8b2b66b3bc4723ULL,0xad2c788035e61382ULL},
+  {0x8b16fb203055ac76ULL,0x4c3bcb5021afcc31ULL},{0xaddcb9e83c6b1793ULL,0xdf4abe242a1bbf3dULL},
+  {0xd953e8624b85dd78ULL,0xd71d6dad34a2af0dULL},{0x87d4713d6f33aa6bULL,0x8672648c40e5ad68ULL},
+  {0xa9c98d8ccb009506ULL,0x680efdaf511f18c2ULL},{0xd43bf0effdc0ba48ULL,0x0212bd1b2566def2ULL},
+  {0x84a57695fe98746dULL,0x014bb630f7604b57ULL},{0xa5ced43b7e3e9188ULL,0x419ea3bd35385e2dULL},
+  {0xcf42894a5dce35eaULL,0x52064cac828675b9ULL},{0x818995ce7aa0e1b2ULL,0x7343efebd1940993ULL},
+  {0xa1ebfb4219491a1fULL,0x1014ebe6c5f90bf8ULL},{0xca66fa129f9b60a6ULL,0xd41a26e077774ef6ULL},
+  {0xfd00b897478238d0ULL,0x8920b098955522b4ULL},{0x9e20735e8cb16382ULL,0x55b46e5f5d5535b0ULL},
+  {0xc5a890362fddbc62ULL,0xeb2189f734aa831dULL},{0xf712b443bbd52b7bULL,0xa5e9ec7501d523e4ULL},
+  {0x9a6bb0aa55653b2dULL,0x47b233c92125366eULL},{0xc1069cd4eabe89f8ULL,0x999ec0bb696e840aULL},
+  {0xf148440a256e2c76ULL,0xc00670ea43ca250dULL},{0x96cd2a865764dbcaULL,0x380406926a5e5728ULL},
+  {0xbc807527ed3e12bcULL,0xc605083704f5ecf2ULL},{0xeba09271e88d976bULL,0xf7864a44c633682eULL},
+  {0x93445b8731587ea3ULL,0x7ab3ee6afbe0211dULL},{0xb8157268fdae9e4cULL,0x5960ea05bad82964ULL},
+  {0xe61acf033d1a45dfULL,0x6fb92487298e33bdULL},{0x8fd0c16206306babULL,0xa5d3b6d479f8e056ULL},
+  {0xb3c4f1ba87bc8696ULL,0x8f48a4899877186cULL},{0xe0b62e2929aba83cULL,0x331acdabfe94de87ULL},
+  {0x8c71dcd9ba0b4925ULL,0x9ff0c08b7f1d0b14ULL},{0xaf8e5410288e1b6fULL,0x07ecf0ae5ee44dd9ULL},
+  {0xdb71e91432b1a24aULL,0xc9e82cd9f69d6150ULL},{0x892731ac9faf056eULL,0xbe311c083a225cd2ULL},
+  {0xab70fe17c79ac6caULL,0x6dbd630a48aaf406ULL},{0xd64d3d9db981787dULL,0x092cbbccdad5b108ULL},
+  {0x85f0468293f0eb4eULL,0x25bbf56008c58ea5ULL},{0xa76c582338ed2621ULL,0xaf2af2b80af6f24eULL},
+  {0xd1476e2c07286faaULL,0x1af5af660db4aee1ULL},{0x82cca4db847945caULL,0x50d98d9fc890ed4dULL},
+  {0xa37fce126597973cULL,0xe50ff107bab528a0ULL},{0xcc5fc196fefd7d0cULL,0x1e53ed49a96272c8ULL},
+  {0xff77b1fcbebcdc4fULL,0x25e8e89c13bb0f7aULL},{0x9faacf3df73609b1ULL,0x77b191618c54e9acULL},
+  {0xc795830d75038c1dULL,0xd59df5b9ef6a2417ULL},{0xf97ae3d0d2446f25ULL,0x4b0573286b44ad1dULL},
+  {0x9becce62836ac577ULL,0x4ee367f9430aec32ULL},{0xc2e801fb244576d5ULL,0x229c41f793cda73fULL},
+  {0xf3a20279ed56d48aULL,0x6b43527578c1110fULL},{0x9845418c345644d6ULL,0x830a13896b78aaa9ULL},
+  {0xbe5691ef416bd60cULL,0x23cc986bc656d553ULL},{0xedec366b11c6cb8fULL,0x2cbfbe86b7ec8aa8ULL},
+  {0x94b3a202eb1c3f39ULL,0x7bf7d71432f3d6a9ULL},{0xb9e08a83a5e34f07ULL,0xdaf5ccd93fb0cc53ULL},
+  {0xe858ad248f5c22c9ULL,0xd1b3400f8f9cff68ULL},{0x91376c36d99995beULL,0x23100809b9c21fa1ULL},
+  {0xb58547448ffffb2dULL,0xabd40a0c2832a78aULL},{0xe2e69915b3fff9f9ULL,0x16c90c8f323f516cULL},
+  {0x8dd01fad907ffc3bULL,0xae3da7d97f6792e3ULL},{0xb1442798f49ffb4aULL,0x99cd11cfdf41779cULL},
+  {0xdd95317f31c7fa1dULL,0x40405643d711d583ULL},{0x8a7d3eef7f1cfc52ULL,0x482835ea666b2572ULL},
+  {0xad1c8eab5ee43b66ULL,0xda3243650005eecfULL},{0xd863b256369d4a40ULL,0x90bed43e40076a82ULL},
+  {0x873e4f75e2224e68ULL,0x5a7744a6e804a291ULL},{0xa90de3535aaae202ULL,0x711515d0a205cb36ULL},
+  {0xd3515c2831559a83ULL,0x0d5a5b44ca873e03ULL},{0x8412d9991ed58091ULL,0xe858790afe9486c2ULL},
+  {0xa5178fff668ae0b6ULL,0x626e974dbe39a872ULL},{0xce5d73ff402d98e3ULL,0xfb0a3d212dc8128fULL},
+  {0x80fa687f881c7f8eULL,0x7ce66634bc9d0b99ULL},{0xa139029f6a239f72ULL,0x1c1fffc1ebc44e80ULL},
+  {0xc987434744ac874eULL,0xa327ffb266b56220ULL},{0xfbe9141915d7a922ULL,0x4bf1ff9f0062baa8ULL},
+  {0x9d71ac8fada6c9b5ULL,0x6f773fc3603db4a9ULL},{0xc4ce17b399107c22ULL,0xcb550fb4384d21d3ULL},
+  {0xf6019da07f549b2bULL,0x7e2a53a146606a48ULL},{0x99c102844f94e0fbULL,0x2eda7444cbfc426dULL},
+  {0xc0314325637a1939ULL,0xfa911155fefb5308ULL},{0xf03d93eebc589f88ULL,0x793555ab7eba27caULL},
+  {0x96267c7535b763b5ULL,0x4bc1558b2f3458deULL},{0xbbb01b9283253ca2ULL,0x9eb1aaedfb016f16ULL},
+  {0xea9c227723ee8bcbULL,0x465e15a979c1cadcULL},{0x92a1958a7675175fULL,0x0bfacd89ec191ec9ULL},
+  {0xb749faed14125d36ULL,0xcef980ec671f667bULL},{0xe51c79a85916f484ULL,0x82b7e12780e7401aULL},
+  {0x8f31cc0937ae58d2ULL,0xd1b2ecb8b0908810ULL},{0xb2fe3f0b8599ef07ULL,0x861fa7e6dcb4aa15ULL},
+  {0xdfbdcece67006ac9ULL,0x67a791e093e1d49aULL},{0x8bd6a141006042bdULL,0xe0c8bb2c5c6d24e0ULL},
+  {0xaecc49914078536dULL,0x58fae9f773886e18ULL},{0xda7f5bf590966848ULL,0xaf39a475506a899eULL},
+  {0x888f99797a5e012dULL,0x6d8406c952429603ULL},{0xaab37fd7d8f58178ULL,0xc8e5087ba6d33b83ULL},
+  {0xd5605fcdcf32e1d6ULL,0xfb1e4a9a90880a64ULL},{0x855c3be0a17fcd26ULL,0x5cf2eea09a55067fULL},
+  {0xa6b34ad8c9dfc06fULL,0xf42faa48c0ea481eULL},{0xd0601d8efc57b08bULL,0xf13b94daf124da26ULL},
+  {0x823c12795db6ce57ULL,0x76c53d08d6b70858ULL},{0xa2cb1717b52481edULL,0x54768c4b0c64ca6eULL},
+  {0xcb7ddcdda26da268ULL,0xa9942f5dcf7dfd09ULL},{0xfe5d54150b090b02ULL,0xd3f93b35435d7c4cULL},
+  {0x9efa548d26e5a6e1ULL,0xc47bc5014a1a6dafULL},{0xc6b8e9b0709f109aULL,0x359ab6419ca1091bULL},
+  {0xf867241c8cc6d4c0ULL,0xc30163d203c94b62ULL},{0x9b407691d7fc44f8ULL,0x79e0de63425dcf1dULL},
+  {0xc21094364dfb5636ULL,0x985915fc12f542e4ULL},{0xf294b943e17a2bc4ULL,0x3e6f5b7b17b2939dULL},
+  {0x979cf3ca6cec5b5aULL,0xa705992ceecf9c42ULL},{0xbd8430bd08277231ULL,0x50c6ff782a838353ULL},
+  {0xece53cec4a314ebdULL,0xa4f8bf5635246428ULL},{0x940f4613ae5ed136ULL,0x871b7795e136be99ULL},
+  {0xb913179899f68584ULL,0x28e2557b59846e3fULL},{0xe757dd7ec07426e5ULL,0x331aeada2fe589cfULL},
+  {0x9096ea6f3848984fULL,0x3ff0d2c85def7621ULL},{0xb4bca50b065abe63ULL,0x0fed077a756b53a9ULL},
+  {0xe1ebce4dc7f16dfbULL,0xd3e8495912c62894ULL},{0x8d3360f09cf6e4bdULL,0x64712dd7abbbd95cULL},
+  {0xb080392cc4349decULL,0xbd8d794d96aacfb3ULL},{0xdca04777f541c567ULL,0xecf0d7a0fc5583a0ULL},
+  {0x89e42caaf9491b60ULL,0xf41686c49db57244ULL},{0xac5d37d5b79b6239ULL,0x311c2875c522ced5ULL},
+  {0xd77485cb25823ac7ULL,0x7d633293366b828bULL},{0x86a8d39ef77164bcULL,0xae5dff9c02033197ULL},
+  {0xa8530886b54dbdebULL,0xd9f57f830283fdfcULL},{0xd267caa862a12d66ULL,0xd072df63c324fd7bULL},
+  {0x8380dea93da4bc60ULL,0x4247cb9e59f71e6dULL},{0xa46116538d0deb78ULL,0x52d9be85f074e608ULL},
+  {0xcd795be870516656ULL,0x67902e276c921f8bULL},{0x806bd9714632dff6ULL,0x00ba1cd8a3db53b6ULL},
+  {0xa086cfcd97bf97f3ULL,0x80e8a40eccd228a4ULL},{0xc8a883c0fdaf7df0ULL,0x6122cd128006b2cdULL},
+  {0xfad2a4b13d1b5d6cULL,0x796b805720085f81ULL},{0x9cc3a6eec6311a63ULL,0xcbe3303674053bb0ULL},
+  {0xc3f490aa77bd60fcULL,0xbedbfc4411068a9cULL},{0xf4f1b4d515acb93bULL,0xee92fb5515482d44ULL},
+  {0x991711052d8bf3c5ULL,0x751bdd152d4d1c4aULL},{0xbf5cd54678eef0b6ULL,0xd262d45a78a0635dULL},
+  {0xef340a98172aace4ULL,0x86fb897116c87c34ULL},{0x9580869f0e7aac0eULL,0xd45d35e6ae3d4da0ULL},
+  {0xbae0a846d2195712ULL,0x8974836059cca109ULL},{0xe998d258869facd7ULL,0x2bd1a438703fc94bULL},
+  {0x91ff83775423cc06ULL,0x7b6306a34627ddcfULL},{0xb67f6455292cbf08ULL,0x1a3bc84c17b1d542ULL},
+  {0xe41f3d6a7377eecaULL,0x20caba5f1d9e4a93ULL},{0x8e938662882af53eULL,0x547eb47b7282ee9cULL},
+  {0xb23867fb2a35b28dULL,0xe99e619a4f23aa43ULL},{0xdec681f9f4c31f31ULL,0x6405fa00e2ec94d4ULL},
+  {0x8b3c113c38f9f37eULL,0xde83bc408dd3dd04ULL},{0xae0b158b4738705eULL,0x9624ab50b148d445ULL},
+  {0xd98ddaee19068c76ULL,0x3badd624dd9b0957ULL},{0x87f8a8d4cfa417c9ULL,0xe54ca5d70a80e5d6ULL},
+  {0xa9f6d30a038d1dbcULL,0x5e9fcf4ccd211f4cULL},{0xd47487cc8470652bULL,0x7647c3200069671fULL},
+  {0x84c8d4dfd2c63f3bULL,0x29ecd9f40041e073ULL},{0xa5fb0a17c777cf09ULL,0xf468107100525890ULL},
+  {0xcf79cc9db955c2ccULL,0x7182148d4066eeb4ULL},{0x81ac1fe293d599bfULL,0xc6f14cd848405530ULL},
+  {0xa21727db38cb002fULL,0xb8ada00e5a506a7cULL},{0xca9cf1d206fdc03bULL,0xa6d90811f0e4851cULL},
+  {0xfd442e4688bd304aULL,0x908f4a166d1da663ULL},{0x9e4a9cec15763e2eULL,0x9a598e4e043287feULL},
+  {0xc5dd44271ad3cdbaULL,0x40eff1e1853f29fdULL},{0xf7549530e188c128ULL,0xd12bee59e68ef47cULL},
+  {0x9a94dd3e8cf578b9ULL,0x82bb74f8301958ceULL},{0xc13a148e3032d6e7ULL,0xe36a52363c1faf01ULL},
+  {0xf18899b1bc3f8ca1ULL,0xdc44e6c3cb279ac1ULL},{0x96f5600f15a7b7e5ULL,0x29ab103a5ef8c0b9ULL},
+  {0xbcb2b812db11a5deULL,0x7415d448f6b6f0e7ULL},{0xebdf661791d60f56ULL,0x111b495b3464ad21ULL},
+  {0x936b9fcebb25c995ULL,0xcab10dd900beec34ULL},{0xb84687c269ef3bfbULL,0x3d5d514f40eea742ULL},
+  {0xe65829b3046b0afaULL,0x0cb4a5a3112a5112ULL},{0x8ff71a0fe2c2e6dcULL,0x47f0e785eaba72abULL},
+  {0xb3f4e093db73a093ULL,0x59ed216765690f56ULL},{0xe0f218b8d25088b8ULL,0x306869c13ec3532cULL},
+  {0x8c974f7383725573ULL,0x1e414218c73a13fbULL},{0xafbd2350644eeacfULL,0xe5d1929ef90898faULL},
+  {0xdbac6c247d62a583ULL,0xdf45f746b74abf39ULL},{0x894bc396ce5da772ULL,0x6b8bba8c328eb783ULL},
+  {0xab9eb47c81f5114fULL,0x066ea92f3f326564ULL},{0xd686619ba27255a2ULL,0xc80a537b0efefebdULL},
+  {0x8613fd0145877585ULL,0xbd06742ce95f5f36ULL},{0xa798fc4196e952e7ULL,0x2c48113823b73704ULL},
+  {0xd17f3b51fca3a7a0ULL,0xf75a15862ca504c5ULL},{0x82ef85133de648c4ULL,0x9a984d73dbe722fbULL},
+  {0xa3ab66580d5fdaf5ULL,0xc13e60d0d2e0ebbaULL},{0xcc963fee10b7d1b3ULL,0x318df905079926a8ULL},
+  {0xffbbcfe994e5c61fULL,0xfdf17746497f7052ULL},{0x9fd561f1fd0f9bd3ULL,0xfeb6ea8bedefa633ULL},
+  {0xc7caba6e7c5382c8ULL,0xfe64a52ee96b8fc0ULL},{0xf9bd690a1b68637bULL,0x3dfdce7aa3c673b0ULL},
+  {0x9c1661a651213e2dULL,0x06bea10ca65c084eULL},{0xc31bfa0fe5698db8ULL,0x486e494fcff30a62ULL},
+  {0xf3e2f893dec3f126ULL,0x5a89dba3c3efccfaULL},{0x986ddb5c6b3a76b7ULL,0xf89629465a75e01cULL},
+  {0xbe89523386091465ULL,0xf6bbb397f1135823ULL},{0xee2ba6c0678b597fULL,0x746aa07ded582e2cULL},
+  {0x94db483840b717efULL,0xa8c2a44eb4571cdcULL},{0xba121a4650e4ddebULL,0x92f34d62616ce413ULL},
+  {0xe896a0d7e51e1566ULL,0x77b020baf9c81d17ULL},{0x915e2486ef32cd60ULL,0x0ace1474dc1d122eULL},
+  {0xb5b5ada8aaff80b8ULL,0x0d819992132456baULL},{0xe3231912d5bf60e6ULL,0x10e1fff697ed6c69ULL},
+  {0x8df5efabc5979c8fULL,0xca8d3ffa1ef463c1ULL},{0xb1736b96b6fd83b3ULL,0xbd308ff8a6b17cb2ULL},
+  {0xddd0467c64bce4a0ULL,0xac7cb3f6d05ddbdeULL},{0x8aa22c0dbef60ee4ULL,0x6bcdf07a423aa96bULL},
+  {0xad4ab7112eb3929dULL,0x86c16c98d2c953c6ULL},{0xd89d64d57a607744ULL,0xe871c7bf077ba8b7ULL},
+  {0x87625f056c7c4a8bULL,0x11471cd764ad4972ULL},{0xa93af6c6c79b5d2dULL,0xd598e40d3dd89bcfULL},
+  {0xd389b47879823479ULL,0x4aff1d108d4ec2c3ULL},{0x843610cb4bf160cbULL,0xcedf722a585139baULL},
+  {0xa54394fe1eedb8feULL,0xc2974eb4ee658828ULL},{0xce947a3da6a9273eULL,0x733d226229feea32ULL},
+  {0x811ccc668829b887ULL,0x0806357d5a3f525fULL},{0xa163ff802a3426a8ULL,0xca07c2dcb0cf26f7ULL},
+  {0xc9bcff6034c13052ULL,0xfc89b393dd02f0b5ULL},{0xfc2c3f3841f17c67ULL,0xbbac2078d443ace2ULL},
+  {0x9d9ba7832936edc0ULL,0xd54b944b84aa4c0dULL},{0xc5029163f384a931ULL,0x0a9e795e65d4df11ULL},
+  {0xf64335bcf065d37dULL,0x4d4617b5ff4a16d5ULL},{0x99ea0196163fa42eULL,0x504bced1bf8e4e45ULL},
+  {0xc06481fb9bcf8d39ULL,0xe45ec2862f71e1d6ULL},{0xf07da27a82c37088ULL,0x5d767327bb4e5a4cULL},
+  {0x964e858c91ba2655ULL,0x3a6a07f8d510f86fULL},{0xbbe226efb628afeaULL,0x890489f70a55368bULL},
+  {0xeadab0aba3b2dbe5ULL,0x2b45ac74ccea842eULL},{0x92c8ae6b464fc96fULL,0x3b0b8bc90012929dULL},
+  {0xb77ada0617e3bbcbULL,0x09ce6ebb40173744ULL},{0xe55990879ddcaabdULL,0xcc420a6a101d0515ULL},
+  {0x8f57fa54c2a9eab6ULL,0x9fa946824a12232dULL},{0xb32df8e9f3546564ULL,0x47939822dc96abf9ULL},
+  {0xdff9772470297ebdULL,0x59787e2b93bc56f7ULL},{0x8bfbea76c619ef36ULL,0x57eb4edb3c55b65aULL},
+  {0xaefae51477a06b03ULL,0xede622920b6b23f1ULL},{0xdab99e59958885c4ULL,0xe95fab368e45ecedULL},
+  {0x88b402f7fd75539bULL,0x11dbcb0218ebb414ULL},{0xaae103b5fcd2a881ULL,0xd652bdc29f26a119ULL},
+  {0xd59944a37c0752a2ULL,0x4be76d3346f0495fULL},{0x857fcae62d8493a5ULL,0x6f70a4400c562ddbULL},
+  {0xa6dfbd9fb8e5b88eULL,0xcb4ccd500f6bb952ULL},{0xd097ad07a71f26b2ULL,0x7e2000a41346a7a7ULL},
+  {0x825ecc24c873782fULL,0x8ed400668c0c28c8ULL},{0xa2f67f2dfa90563bULL,0x728900802f0f32faULL},
+  {0xcbb41ef979346bcaULL,0x4f2b40a03ad2ffb9ULL},{0xfea126b7d78186bcULL,0xe2f610c84987bfa8ULL},
+  {0x9f24b832e6b0f436ULL,0x0dd9ca7d2df4d7c9ULL},{0xc6ede63fa05d3143ULL,0x91503d1c79720dbbULL},
+  {0xf8a95fcf88747d94ULL,0x75a44c6397ce912aULL},{0x9b69dbe1b548ce7cULL,0xc986afbe3ee11abaULL},
+  {0xc24452da229b021bULL,0xfbe85badce996168ULL},{0xf2d56790ab41c2a2ULL,0xfae27299423fb9c3ULL},
+  {0x97c560ba6b0919a5ULL,0xdccd879fc967d41aULL},{0xbdb6b8e905cb600fULL,0x5400e987bbc1c920ULL},
+  {0xed246723473e3813ULL,0x290123e9aab23b68ULL},{0x9436c0760c86e30bULL,0xf9a0b6720aaf6521ULL},
+  {0xb94470938fa89bceULL,0xf808e40e8d5b3e69ULL},{0xe7958cb87392c2c2ULL,0xb60b1d1230b20e04ULL},
+  {0x90bd77f3483bb9b9ULL,0xb1c6f22b5e6f48c2ULL},{0xb4ecd5f01a4aa828ULL,0x1e38aeb6360b1af3ULL},
+  {0xe2280b6c20dd5232ULL,0x25c6da63c38de1b0ULL},{0x8d590723948a535fULL,0x579c487e5a38ad0eULL},
+  {0xb0af48ec79ace837ULL,0x2d835a9df0c6d851ULL},{0xdcdb1b2798182244ULL,0xf8e431456cf88e65ULL},
+  {0x8a08f0f8bf0f156bULL,0x1b8e9ecb641b58ffULL},{0xac8b2d36eed2dac5ULL,0xe272467e3d222f3fULL},
+  {0xd7adf884aa879177ULL,0x5b0ed81dcc6abb0fULL},{0x86ccbb52ea94baeaULL,0x98e947129fc2b4e9ULL},
+  {0xa87fea27a539e9a5ULL,0x3f2398d747b36224ULL},{0xd29fe4b18e88640eULL,0x8eec7f0d19a03aadULL},
+  {0x83a3eeeef9153e89ULL,0x1953cf68300424acULL},{0xa48ceaaab75a8e2bULL,0x5fa8c3423c052dd7ULL},
+  {0xcdb02555653131b6ULL,0x3792f412cb06794dULL},{0x808e17555f3ebf11ULL,0xe2bbd88bbee40bd0ULL},
+  {0xa0b19d2ab70e6ed6ULL,0x5b6aceaeae9d0ec4ULL},{0xc8de047564d20a8bULL,0xf245825a5a445275ULL},
+  {0xfb158592be068d2eULL,0xeed6e2f0f0d56712ULL},{0x9ced737bb6c4183dULL,0x55464dd69685606bULL},
+  {0xc428d05aa4751e4cULL,0xaa97e14c3c26b886ULL},{0xf53304714d9265dfULL,0xd53dd99f4b3066a8ULL},
+  {0x993fe2c6d07b7fabULL,0xe546a8038efe4029ULL},{0xbf8fdb78849a5f96ULL,0xde98520472bdd033ULL},
+  {0xef73d256a5c0f77cULL,0x963e66858f6d4440ULL},{0x95a8637627989aadULL,0xdde7001379a44aa8ULL},
+  {0xbb127c53b17ec159ULL,0x5560c018580d5d52ULL},{0xe9d71b689dde71afULL,0xaab8f01e6e10b4a6ULL},
+  {0x9226712162ab070dULL,0xcab3961304ca70e8ULL},{0xb6b00d69bb55c8d1ULL,0x3d607b97c5fd0d22ULL},
+  {0xe45c10c42a2b3b05ULL,0x8cb89a7db77c506aULL},{0x8eb98a7a9a5b04e3ULL,0x77f3608e92adb242ULL},
+  {0xb267ed1940f1c61cULL,0x55f038b237591ed3ULL},{0xdf01e85f912e37a3ULL,0x6b6c46dec52f6688ULL},
+  {0x8b61313bbabce2c6ULL,0x2323ac4b3b3da015ULL},{0xae397d8aa96c1b77ULL,0xabec975e0a0d081aULL},
+  {0xd9c7dced53c72255ULL,0x96e7bd358c904a21ULL},{0x881cea14545c7575ULL,0x7e50d64177da2e54ULL},
+  {0xaa242499697392d2ULL,0xdde50bd1d5d0b9e9ULL},{0xd4ad2dbfc3d07787ULL,0x955e4ec64b44e864ULL},
+  {0x84ec3c97da624ab4ULL,0xbd5af13bef0b113eULL},{0xa6274bbdd0fadd61ULL,0xecb1ad8aeacdd58eULL},
+  {0xcfb11ead453994baULL,0x67de18eda5814af2ULL},{0x81ceb32c4b43fcf4ULL,0x80eacf948770ced7ULL},
+  {0xa2425ff75e14fc31ULL,0xa1258379a94d028dULL},{0xcad2f7f5359a3b3eULL,0x096ee45813a04330ULL},
+  {0xfd87b5f28300ca0dULL,0x8bca9d6e188853fcULL},{0x9e74d1b791e07e48ULL,0x775ea264cf55347eULL},
+  {0xc612062576589ddaULL,0x95364afe032a819eULL},{0xf79687aed3eec551ULL,0x3a83ddbd83f52205ULL},
+  {0x9abe14cd44753b52ULL,0xc4926a9672793543ULL},{0xc16d9a0095928a27ULL,0x75b7053c0f178294ULL},
+  {0xf1c90080baf72cb1ULL,0x5324c68b12dd6339ULL},{0x971da05074da7beeULL,0xd3f6fc16ebca5e04ULL},
+  {0xbce5086492111aeaULL,0x88f4bb1ca6bcf585ULL},{0xec1e4a7db69561a5ULL,0x2b31e9e3d06c32e6ULL},
+  {0x9392ee8e921d5d07ULL,0x3aff322e62439fd0ULL},{0xb877aa3236a4b449ULL,0x09befeb9fad487c3ULL},
+  {0xe69594bec44de15bULL,0x4c2ebe687989a9b4ULL},{0x901d7cf73ab0acd9ULL,0x0f9d37014bf60a11ULL},
+  {0xb424dc35095cd80fULL,0x538484c19ef38c95ULL},{0xe12e13424bb40e13ULL,0x2865a5f206b06fbaULL},
+  {0x8cbccc096f5088cbULL,0xf93f87b7442e45d4ULL},{0xafebff0bcb24aafeULL,0xf78f69a51539d749ULL},
+  {0xdbe6fecebdedd5beULL,0xb573440e5a884d1cULL},{0x89705f4136b4a597ULL,0x31680a88f8953031ULL},
+  {0xabcc77118461cefcULL,0xfdc20d2b36ba7c3eULL},{0xd6bf94d5e57a42bcULL,0x3d32907604691b4dULL},
+  {0x8637bd05af6c69b5ULL,0xa63f9a49c2c1b110ULL},{0xa7c5ac471b478423ULL,0x0fcf80dc33721d54ULL},
+  {0xd1b71758e219652bULL,0xd3c36113404ea4a9ULL},{0x83126e978d4fdf3bULL,0x645a1cac083126eaULL},
+  {0xa3d70a3d70a3d70aULL,0x3d70a3d70a3d70a4ULL},{0xccccccccccccccccULL,0xcccccccccccccccdULL},
+  {0x8000000000000000ULL,0x0000000000000000ULL},{0xa000000000000000ULL,0x0000000000000000ULL},
+  {0xc800000000000000ULL,0x0000000000000000ULL},{0xfa00000000000000ULL,0x0000000000000000ULL},
+  {0x9c40000000000000ULL,0x0000000000000000ULL},{0xc350000000000000ULL,0x0000000000000000ULL},
+  {0xf424000000000000ULL,0x0000000000000000ULL},{0x9896800000000000ULL,0x0000000000000000ULL},
+  {0xbebc200000000000ULL,0x0000000000000000ULL},{0xee6b280000000000ULL,0x0000000000000000ULL},
+  {0x9502f90000000000ULL,0x0000000000000000ULL},{0xba43b74000000000ULL,0x0000000000000000ULL},
+  {0xe8d4a51000000000ULL,0x0000000000000000ULL},{0x9184e72a00000000ULL,0x0000000000000000ULL},
+  {0xb5e620f480000000ULL,0x0000000000000000ULL},{0xe35fa931a0000000ULL,0x0000000000000000ULL},
+  {0x8e1bc9bf04000000ULL,0x0000000000000000ULL},{0xb1a2bc2ec5000000ULL,0x0000000000000000ULL},
+  {0xde0b6b3a76400000ULL,0x0000000000000000ULL},{0x8ac7230489e80000ULL,0x0000000000000000ULL},
+  {0xad78ebc5ac620000ULL,0x0000000000000000ULL},{0xd8d726b7177a8000ULL,0x0000000000000000ULL},
+  {0x878678326eac9000ULL,0x0000000000000000ULL},{0xa968163f0a57b400ULL,0x0000000000000000ULL},
+  {0xd3c21bcecceda100ULL,0x0000000000000000ULL},{0x84595161401484a0ULL,0x0000000000000000ULL},
+  {0xa56fa5b99019a5c8ULL,0x0000000000000000ULL},{0xcecb8f27f4200f3aULL,0x0000000000000000ULL},
+  {0x813f3978f8940984ULL,0x4000000000000000ULL},{0xa18f07d736b90be5ULL,0x5000000000000000ULL},
+  {0xc9f2c9cd04674edeULL,0xa400000000000000ULL},{0xfc6f7c4045812296ULL,0x4d00000000000000ULL},
+  {0x9dc5ada82b70b59dULL,0xf020000000000000ULL},{0xc5371912364ce305ULL,0x6c28000000000000ULL},
+  {0xf684df56c3e01bc6ULL,0xc732000000000000ULL},{0x9a130b963a6c115cULL,0x3c7f400000000000ULL},
+  {0xc097ce7bc90715b3ULL,0x4b9f100000000000ULL},{0xf0bdc21abb48db20ULL,0x1e86d40000000000ULL},
+  {0x96769950b50d88f4ULL,0x1314448000000000ULL},{0xbc143fa4e250eb31ULL,0x17d955a000000000ULL},
+  {0xeb194f8e1ae525fdULL,0x5dcfab0800000000ULL},{0x92efd1b8d0cf37beULL,0x5aa1cae500000000ULL},
+  {0xb7abc627050305adULL,0xf14a3d9e40000000ULL},{0xe596b7b0c643c719ULL,0x6d9ccd05d0000000ULL},
+  {0x8f7e32ce7bea5c6fULL,0xe4820023a2000000ULL},{0xb35dbf821ae4f38bULL,0xdda2802c8a800000ULL},
+  {0xe0352f62a19e306eULL,0xd50b2037ad200000ULL},{0x8c213d9da502de45ULL,0x4526f422cc340000ULL},
+  {0xaf298d050e4395d6ULL,0x9670b12b7f410000ULL},{0xdaf3f04651d47b4cULL,0x3c0cdd765f114000ULL},
+  {0x88d8762bf324cd0fULL,0xa5880a69fb6ac800ULL},{0xab0e93b6efee0053ULL,0x8eea0d047a457a00ULL},
+  {0xd5d238a4abe98068ULL,0x72a4904598d6d880ULL},{0x85a36366eb71f041ULL,0x47a6da2b7f864750ULL},
+  {0xa70c3c40a64e6c51ULL,0x999090b65f67d924ULL},{0xd0cf4b50cfe20765ULL,0xfff4b4e3f741cf6dULL},
+  {0x82818f1281ed449fULL,0xbff8f10e7a8921a4ULL},{0xa321f2d7226895c7ULL,0xaff72d52192b6a0dULL},
+  {0xcbea6f8ceb02bb39ULL,0x9bf4f8a69f764490ULL},{0xfee50b7025c36a08ULL,0x02f236d04753d5b4ULL},
+  {0x9f4f2726179a2245ULL,0x01d762422c946590ULL},{0xc722f0ef9d80aad6ULL,0x424d3ad2b7b97ef5ULL},
+  {0xf8ebad2b84e0d58bULL,0xd2e0898765a7deb2ULL},{0x9b934c3b330c8577ULL,0x63cc55f49f88eb2fULL},
+  {0xc2781f49ffcfa6d5ULL,0x3cbf6b71c76b25fbULL},{0xf316271c7fc3908aULL,0x8bef464e3945ef7aULL},
+  {0x97edd871cfda3a56ULL,0x97758bf0e3cbb5acULL},{0xbde94e8e43d0c8ecULL,0x3d52eeed1cbea317ULL},
+  {0xed63a231d4c4fb27ULL,0x4ca7aaa863ee4bddULL},{0x945e455f24fb1cf8ULL,0x8fe8caa93e74ef6aULL},
+  {0xb975d6b6ee39e436ULL,0xb3e2fd538e122b44ULL},{0xe7d34c64a9c85d44ULL,0x60dbbca87196b616ULL},
+  {0x90e40fbeea1d3a4aULL,0xbc8955e946fe31cdULL},{0xb51d13aea4a488ddULL,0x6babab6398bdbe41ULL},
+  {0xe264589a4dcdab14ULL,0xc696963c7eed2dd1ULL},{0x8d7eb76070a08aecULL,0xfc1e1de5cf543ca2ULL},
+  {0xb0de65388cc8ada8ULL,0x3b25a55f43294bcbULL},{0xdd15fe86affad912ULL,0x49ef0eb713f39ebeULL},
+  {0x8a2dbf142dfcc7abULL,0x6e3569326c784337ULL},{0xacb92ed9397bf996ULL,0x49c2c37f07965404ULL},
+  {0xd7e77a8f87daf7fbULL,0xdc33745ec97be906ULL},{0x86f0ac99b4e8dafdULL,0x69a028bb3ded71a3ULL},
+  {0xa8acd7c0222311bcULL,0xc40832ea0d68ce0cULL},{0xd2d80db02aabd62bULL,0xf50a3fa490c30190ULL},
+  {0x83c7088e1aab65dbULL,0x792667c6da79e0faULL},{0xa4b8cab1a1563f52ULL,0x577001b891185938ULL},
+  {0xcde6fd5e09abcf26ULL,0xed4c0226b55e6f86ULL},{0x80b05e5ac60b6178ULL,0x544f8158315b05b4ULL},
+  {0xa0dc75f1778e39d6ULL,0x696361ae3db1c721ULL},{0xc913936dd571c84cULL,0x03bc3a19cd1e38e9ULL},
+  {0xfb5878494ace3a5fULL,0x04ab48a04065c723ULL},{0x9d174b2dcec0e47bULL,0x62eb0d64283f9c76ULL},
+  {0xc45d1df942711d9aULL,0x3ba5d0bd324f8394ULL},{0xf5746577930d6500ULL,0xca8f44ec7ee36479ULL},
+  {0x9968bf6abbe85f20ULL,0x7e998b13cf4e1ecbULL},{0xbfc2ef456ae276e8ULL,0x9e3fedd8c321a67eULL},
+  {0xefb3ab16c59b14a2ULL,0xc5cfe94ef3ea101eULL},{0x95d04aee3b80ece5ULL,0xbba1f1d158724a12ULL},
+  {0xbb445da9ca61281fULL,0x2a8a6e45ae8edc97ULL},{0xea1575143cf97226ULL,0xf52d09d71a3293bdULL},
+  {0x924d692ca61be758ULL,0x593c2626705f9c56ULL},{0xb6e0c377cfa2e12eULL,0x6f8b2fb00c77836cULL},
+  {0xe498f455c38b997aULL,0x0b6dfb9c0f956447ULL},{0x8edf98b59a373fecULL,0x4724bd4189bd5eacULL},
+  {0xb2977ee300c50fe7ULL,0x58edec91ec2cb657ULL},{0xdf3d5e9bc0f653e1ULL,0x2f2967b66737e3edULL},
+  {0x8b865b215899f46cULL,0xbd79e0d20082ee74ULL},{0xae67f1e9aec07187ULL,0xecd8590680a3aa11ULL},
+  {0xda01ee641a708de9ULL,0xe80e6f4820cc9495ULL},{0x884134fe908658b2ULL,0x3109058d147fdcddULL},
+  {0xaa51823e34a7eedeULL,0xbd4b46f0599fd415ULL},{0xd4e5e2cdc1d1ea96ULL,0x6c9e18ac7007c91aULL},
+  {0x850fadc09923329eULL,0x03e2cf6bc604ddb0ULL},{0xa6539930bf6bff45ULL,0x84db8346b786151cULL},
+  {0xcfe87f7cef46ff16ULL,0xe612641865679a63ULL},{0x81f14fae158c5f6eULL,0x4fcb7e8f3f60c07eULL},
+  {0xa26da3999aef7749ULL,0xe3be5e330f38f09dULL},{0xcb090c8001ab551cULL,0x5cadf5bfd3072cc5ULL},
+  {0xfdcb4fa002162a63ULL,0x73d9732fc7c8f7f6ULL},{0x9e9f11c4014dda7eULL,0x2867e7fddcdd9afaULL},
+  {0xc646d63501a1511dULL,0xb281e1fd541501b8ULL},{0xf7d88bc24209a565ULL,0x1f225a7ca91a4226ULL},
+  {0x9ae757596946075fULL,0x3375788de9b06958ULL},{0xc1a12d2fc3978937ULL,0x0052d6b1641c83aeULL},
+  {0xf209787bb47d6b84ULL,0xc0678c5dbd23a49aULL},{0x9745eb4d50ce6332ULL,0xf840b7ba963646e0ULL},
+  {0xbd176620a501fbffULL,0xb650e5a93bc3d898ULL},{0xec5d3fa8ce427affULL,0xa3e51f138ab4cebeULL},
+  {0x93ba47c980e98cdfULL,0xc66f336c36b10137ULL},{0xb8a8d9bbe123f017ULL,0xb80b0047445d4184ULL},
+  {0xe6d3102ad96cec1dULL,0xa60dc059157491e5ULL},{0x9043ea1ac7e41392ULL,0x87c89837ad68db2fULL},
+  {0xb454e4a179dd1877ULL,0x29babe4598c311fbULL},{0xe16a1dc9d8545e94ULL,0xf4296dd6fef3d67aULL},
+  {0x8ce2529e2734bb1dULL,0x1899e4a65f58660cULL},{0xb01ae745b101e9e4ULL,0x5ec05dcff72e7f8fULL},
+  {0xdc21a1171d42645dULL,0x76707543f4fa1f73ULL},{0x899504ae72497ebaULL,0x6a06494a791c53a8ULL},
+  {0xabfa45da0edbde69ULL,0x0487db9d17636892ULL},{0xd6f8d7509292d603ULL,0x45a9d2845d3c42b6ULL},
+  {0x865b86925b9bc5c2ULL,0x0b8a2392ba45a9b2ULL},{0xa7f26836f282b732ULL,0x8e6cac7768d7141eULL},
+  {0xd1ef0244af2364ffULL,0x3207d795430cd926ULL},{0x8335616aed761f1fULL,0x7f44e6bd49e807b8ULL},
+  {0xa402b9c5a8d3a6e7ULL,0x5f16206c9c6209a6ULL},{0xcd036837130890a1ULL,0x36dba887c37a8c0fULL},
+  {0x802221226be55a64ULL,0xc2494954da2c9789ULL},{0xa02aa96b06deb0fdULL,0xf2db9baa10b7bd6cULL},
+  {0xc83553c5c8965d3dULL,0x6f92829494e5acc7ULL},{0xfa42a8b73abbf48cULL,0xcb772339ba1f17f9ULL},
+  {0x9c69a97284b578d7ULL,0xff2a760414536efbULL},{0xc38413cf25e2d70dULL,0xfef5138519684abaULL},
+  {0xf46518c2ef5b8cd1ULL,0x7eb258665fc25d69ULL},{0x98bf2f79d5993802ULL,0xef2f773ffbd97a61ULL},
+  {0xbeeefb584aff8603ULL,0xaafb550ffacfd8faULL},{0xeeaaba2e5dbf6784ULL,0x95ba2a53f983cf38ULL},
+  {0x952ab45cfa97a0b2ULL,0xdd945a747bf26183ULL},{0xba756174393d88dfULL,0x94f971119aeef9e4ULL},
+  {0xe912b9d1478ceb17ULL,0x7a37cd5601aab85dULL},{0x91abb422ccb812eeULL,0xac62e055c10ab33aULL},
+  {0xb616a12b7fe617aaULL,0x577b986b314d6009ULL},{0xe39c49765fdf9d94ULL,0xed5a7e85fda0b80bULL},
+  {0x8e41ade9fbebc27dULL,0x14588f13be847307ULL},{0xb1d219647ae6b31cULL,0x596eb2d8ae258fc8ULL},
+  {0xde469fbd99a05fe3ULL,0x6fca5f8ed9aef3bbULL},{0x8aec23d680043beeULL,0x25de7bb9480d5854ULL},
+  {0xada72ccc20054ae9ULL,0xaf561aa79a10ae6aULL},{0xd910f7ff28069da4ULL,0x1b2ba1518094da04ULL},
+  {0x87aa9aff79042286ULL,0x90fb44d2f05d0842ULL},{0xa99541bf57452b28ULL,0x353a1607ac744a53ULL},
+  {0xd3fa922f2d1675f2ULL,0x42889b8997915ce8ULL},{0x847c9b5d7c2e09b7ULL,0x69956135febada11ULL},
+  {0xa59bc234db398c25ULL,0x43fab9837e699095ULL},{0xcf02b2c21207ef2eULL,0x94f967e45e03f4bbULL},
+  {0x8161afb94b44f57dULL,0x1d1be0eebac278f5ULL},{0xa1ba1ba79e1632dcULL,0x6462d92a69731732ULL},
+  {0xca28a291859bbf93ULL,0x7d7b8f7503cfdcfeULL},{0xfcb2cb35e702af78ULL,0x5cda735244c3d43eULL},
+  {0x9defbf01b061adabULL,0x3a0888136afa64a7ULL},{0xc56baec21c7a1916ULL,0x088aaa1845b8fdd0ULL},
+  {0xf6c69a72a3989f5bULL,0x8aad549e57273d45ULL},{0x9a3c2087a63f6399ULL,0x36ac54e2f678864bULL},
+  {0xc0cb28a98fcf3c7fULL,0x84576a1bb416a7ddULL},{0xf0fdf2d3f3c30b9fULL,0x656d44a2a11c51d5ULL},
+  {0x969eb7c47859e743ULL,0x9f644ae5a4b1b325ULL},{0xbc4665b596706114ULL,0x873d5d9f0dde1feeULL},
+  {0xeb57ff22fc0c7959ULL,0xa90cb506d155a7eaULL},{0x9316ff75dd87cbd8ULL,0x09a7f12442d588f2ULL},
+  {0xb7dcbf5354e9beceULL,0x0c11ed6d538aeb2fULL},{0xe5d3ef282a242e81ULL,0x8f1668c8a86da5faULL},
+  {0x8fa475791a569d10ULL,0xf96e017d694487bcULL},{0xb38d92d760ec4455ULL,0x37c981dcc395a9acULL},
+  {0xe070f78d3927556aULL,0x85bbe253f47b1417ULL},{0x8c469ab843b89562ULL,0x93956d7478ccec8eULL},
+  {0xaf58416654a6babbULL,0x387ac8d1970027b2ULL},{0xdb2e51bfe9d0696aULL,0x06997b05fcc0319eULL},
+  {0x88fcf317f22241e2ULL,0x441fece3bdf81f03ULL},{0xab3c2fddeeaad25aULL,0xd527e81cad7626c3ULL},
+  {0xd60b3bd56a5586f1ULL,0x8a71e223d8d3b074ULL},{0x85c7056562757456ULL,0xf6872d5667844e49ULL},
+  {0xa738c6bebb12d16cULL,0xb428f8ac016561dbULL},{0xd106f86e69d785c7ULL,0xe13336d701beba52ULL},
+  {0x82a45b450226b39cULL,0xecc0024661173473ULL},{0xa34d721642b06084ULL,0x27f002d7f95d0190ULL},
+  {0xcc20ce9bd35c78a5ULL,0x31ec038df7b441f4ULL},{0xff290242c83396ceULL,0x7e67047175a15271ULL},
+  {0x9f79a169bd203e41ULL,0x0f0062c6e984d386ULL},{0xc75809c42c684dd1ULL,0x52c07b78a3e60868ULL},
+  {0xf92e0c3537826145ULL,0xa7709a56ccdf8a82ULL},{0x9bbcc7a142b17ccbULL,0x88a66076400bb691ULL},
+  {0xc2abf989935ddbfeULL,0x6acff893d00ea435ULL},{0xf356f7ebf83552feULL,0x0583f6b8c4124d43ULL},
+  {0x98165af37b2153deULL,0xc3727a337a8b704aULL},{0xbe1bf1b059e9a8d6ULL,0x744f18c0592e4c5cULL},
+  {0xeda2ee1c7064130cULL,0x1162def06f79df73ULL},{0x9485d4d1c63e8be7ULL,0x8addcb5645ac2ba8ULL},
+  {0xb9a74a0637ce2ee1ULL,0x6d953e2bd7173692ULL},{0xe8111c87c5c1ba99ULL,0xc8fa8db6ccdd0437ULL},
+  {0x910ab1d4db9914a0ULL,0x1d9c9892400a22a2ULL},{0xb54d5e4a127f59c8ULL,0x2503beb6d00cab4bULL},
+  {0xe2a0b5dc971f303aULL,0x2e44ae64840fd61dULL},{0x8da471a9de737e24ULL,0x5ceaecfed289e5d2ULL},
+  {0xb10d8e1456105dadULL,0x7425a83e872c5f47ULL},{0xdd50f1996b947518ULL,0xd12f124e28f77719ULL},
+  {0x8a5296ffe33cc92fULL,0x82bd6b70d99aaa6fULL},{0xace73cbfdc0bfb7bULL,0x636cc64d1001550bULL},
+  {0xd8210befd30efa5aULL,0x3c47f7e05401aa4eULL},{0x8714a775e3e95c78ULL,0x65acfaec34810a71ULL},
+  {0xa8d9d1535ce3b396ULL,0x7f1839a741a14d0dULL},{0xd31045a8341ca07cULL,0x1ede48111209a050ULL},
+  {0x83ea2b892091e44dULL,0x934aed0aab460432ULL},{0xa4e4b66b68b65d60ULL,0xf81da84d5617853fULL},
+  {0xce1de40642e3f4b9ULL,0x36251260ab9d668eULL},{0x80d2ae83e9ce78f3ULL,0xc1d72b7c6b426019ULL},
+  {0xa1075a24e4421730ULL,0xb24cf65b8612f81fULL},{0xc94930ae1d529cfcULL,0xdee033f26797b627ULL},
+  {0xfb9b7cd9a4a7443cULL,0x169840ef017da3b1ULL},{0x9d412e0806e88aa5ULL,0x8e1f289560ee864eULL},
+  {0xc491798a08a2ad4eULL,0xf1a6f2bab92a27e2ULL},{0xf5b5d7ec8acb58a2ULL,0xae10af696774b1dbULL},
+  {0x9991a6f3d6bf1765ULL,0xacca6da1e0a8ef29ULL},{0xbff610b0cc6edd3fULL,0x17fd090a58d32af3ULL},
+  {0xeff394dcff8a948eULL,0xddfc4b4cef07f5b0ULL},{0x95f83d0a1fb69cd9ULL,0x4abdaf101564f98eULL},
+  {0xbb764c4ca7a4440fULL,0x9d6d1ad41abe37f1ULL},{0xea53df5fd18d5513ULL,0x84c86189216dc5edULL},
+  {0x92746b9be2f8552cULL,0x32fd3cf5b4e49bb4ULL},{0xb7118682dbb66a77ULL,0x3fbc8c33221dc2a1ULL},
+  {0xe4d5e82392a40515ULL,0x0fabaf3feaa5334aULL},{0x8f05b1163ba6832dULL,0x29cb4d87f2a7400eULL},
+  {0xb2c71d5bca9023f8ULL,0x743e20e9ef511012ULL},{0xdf78e4b2bd342cf6ULL,0x914da9246b255416ULL},
+  {0x8bab8eefb6409c1aULL,0x1ad089b6c2f7548eULL},{0xae9672aba3d0c320ULL,0xa184ac2473b529b1ULL},
+  {0xda3c0f568cc4f3e8ULL,0xc9e5d72d90a2741eULL},{0x8865899617fb1871ULL,0x7e2fa67c7a658892ULL},
+  {0xaa7eebfb9df9de8dULL,0xddbb901b98feeab7ULL},{0xd51ea6fa85785631ULL,0x552a74227f3ea565ULL},
+  {0x8533285c936b35deULL,0xd53a88958f87275fULL},{0xa67ff273b8460356ULL,0x8a892abaf368f137ULL},
+  {0xd01fef10a657842cULL,0x2d2b7569b0432d85ULL},{0x8213f56a67f6b29bULL,0x9c3b29620e29fc73ULL},
+  {0xa298f2c501f45f42ULL,0x8349f3ba91b47b8fULL},{0xcb3f2f7642717713ULL,0x241c70a936219a73ULL},
+  {0xfe0efb53d30dd4d7ULL,0xed238cd383aa0110ULL},{0x9ec95d1463e8a506ULL,0xf4363804324a40aaULL},
+  {0xc67bb4597ce2ce48ULL,0xb143c6053edcd0d5ULL},{0xf81aa16fdc1b81daULL,0xdd94b7868e94050aULL},
+  {0x9b10a4e5e9913128ULL,0xca7cf2b4191c8326ULL},{0xc1d4ce1f63f57d72ULL,0xfd1c2f611f63a3f0ULL},
+  {0xf24a01a73cf2dccfULL,0xbc633b39673c8cecULL},{0x976e41088617ca01ULL,0xd5be0503e085d813ULL},
+  {0xbd49d14aa79dbc82ULL,0x4b2d8644d8a74e18ULL},{0xec9c459d51852ba2ULL,0xddf8e7d60ed1219eULL},
+  {0x93e1ab8252f33b45ULL,0xcabb90e5c942b503ULL},{0xb8da1662e7b00a17ULL,0x3d6a751f3b936243ULL},
+  {0xe7109bfba19c0c9dULL,0x0cc512670a783ad4ULL},{0x906a617d450187e2ULL,0x27fb2b80668b24c5ULL},
+  {0xb484f9dc9641e9daULL,0xb1f9f660802dedf6ULL},{0xe1a63853bbd26451ULL,0x5e7873f8a0396973ULL},
+  {0x8d07e33455637eb2ULL,0xdb0b487b6423e1e8ULL},{0xb049dc016abc5e5fULL,0x91ce1a9a3d2cda62ULL},
+  {0xdc5c5301c56b75f7ULL,0x7641a140cc7810fbULL},{0x89b9b3e11b6329baULL,0xa9e904c87fcb0a9dULL},
+  {0xac2820d9623bf429ULL,0x546345fa9fbdcd44ULL},{0xd732290fbacaf133ULL,0xa97c177947ad4095ULL},
+  {0x867f59a9d4bed6c0ULL,0x49ed8eabcccc485dULL},{0xa81f301449ee8c70ULL,0x5c68f256bfff5a74ULL},
+  {0xd226fc195c6a2f8cULL,0x73832eec6fff3111ULL},{0x83585d8fd9c25db7ULL,0xc831fd53c5ff7eabULL},
+  {0xa42e74f3d032f525ULL,0xba3e7ca8b77f5e55ULL},{0xcd3a1230c43fb26fULL,0x28ce1bd2e55f35ebULL},
+  {0x80444b5e7aa7cf85ULL,0x7980d163cf5b81b3ULL},{0xa0555e361951c366ULL,0xd7e105bcc332621fULL},
+  {0xc86ab5c39fa63440ULL,0x8dd9472bf3fefaa7ULL},{0xfa856334878fc150ULL,0xb14f98f6f0feb951ULL},
+  {0x9c935e00d4b9d8d2ULL,0x6ed1bf9a569f33d3ULL},{0xc3b8358109e84f07ULL,0x0a862f80ec4700c8ULL},
+  {0xf4a642e14c6262c8ULL,0xcd27bb612758c0faULL},{0x98e7e9cccfbd7dbdULL,0x8038d51cb897789cULL},
+  {0xbf21e44003acdd2cULL,0xe0470a63e6bd56c3ULL},{0xeeea5d5004981478ULL,0x1858ccfce06cac74ULL},
+  {0x95527a5202df0ccbULL,0x0f37801e0c43ebc8ULL},{0xbaa718e68396cffdULL,0xd30560258f54e6baULL},
+  {0xe950df20247c83fdULL,0x47c6b82ef32a2069ULL},{0x91d28b7416cdd27eULL,0x4cdc331d57fa5441ULL},
+  {0xb6472e511c81471dULL,0xe0133fe4adf8e952ULL},{0xe3d8f9e563a198e5ULL,0x58180fddd97723a6ULL},
+  {0x8e679c2f5e44ff8fULL,0x570f09eaa7ea7648ULL}
+};
+
+/* the 128 bit product a*b, returns the low half */
+static IXJSU64 i_mul128(IXJSU64 a, IXJSU64 b, IXJSU64 *hi)
+{
+#ifdef __SIZEOF_INT128__
+  __extension__ unsigned __int128 r=(unsigned __int128)a*b; 
+  *hi=(IXJSU64)(r>>64); return (IXJSU64)r;
+#else
+  IXJSU64 al=a&0xFFFFFFFFULL, ah=a>>32, bl=b&0xFFFFFFFFULL, bh=b>>32;
+  IXJSU64 ll=al*bl, lh=al*bh, hl=ah*bl, mid=(ll>>32)+(lh&0xFFFFFFFFULL)+(hl&0xFFFFFFFFULL);
+  *hi=ah*bh+(lh>>32)+(hl>>32)+(mid>>32);
+  return (mid<<32)|(ll&0xFFFFFFFFULL);
+#endif
+}
+
+/* number of bits between the highest and lowest set bit of hi:lo (not 0) */
+static int i_bits128(IXJSU64 hi, IXJSU64 lo)
+{ int n=(hi)?128-i_clz64(hi):64-i_clz64(lo);
+  if (lo) { while (!(lo&1)) { lo>>=1; n--; } } 
+  else { n-=64; while (!(hi&1)) { hi>>=1; n--; } }
+  return n;
+}
+
+/*
+** w*10^q is exactly a double: 5^|q| fits in 64 bits and what is left after
+** the powers of two fits in the 53 bit significand.
+*/
+static int i_num_exact(IXJSU64 w, long q)
+{ IXJSU64 p5=1, hi=0, lo; int i;
+  if ((q<-27)||(q>27)) return 0;
+  for (i=0;i<((q<0)?-q:q);i++) p5*=5;
+  if (q<0) { if (w%p5) return 0; lo=w/p5; }
+  else lo=i_mul128(w, p5, &hi);
+  return i_bits128(hi, lo)<=53;
+}
+
+/*
+** Eisel-Lemire: the bits of the double nearest to w*10^q, w not 0 and q in
+** the range of i_pow5.
+*/
+static IXJSU64 i_num_el(IXJSU64 w, long q)
+{ IXJSU64 hi, lo, hi2, m; int lz=i_clz64(w), up, sh; long p2;
+  const IXJSU64 *t=i_pow5[q-IXJS_POW5_MIN];
+  w<<=lz;
+  lo=i_mul128(w, t[0], &hi);
+  if ((hi&0x1FF)==0x1FF) { i_mul128(w, t[1], &hi2); lo+=hi2; if (hi2>lo) hi++; } // the truncated part may carry
+  up=(int)(hi>>63); sh=up+64-52-3;
+  m=hi>>sh;
+  p2=(((152170L+65536L)*q)>>16)+63+up-lz+1023;
+  if (p2<=0) // subnormal
+  { if ((-p2+1)>=64) return 0;
+    m>>=(-p2+1); m+=(m&1); m>>=1;
+    return (m<(1ULL<<52))?m:(1ULL<<52); // rounded up to the smallest normal
+  }
+  if ((lo<=1)&&(q>=-4)&&(q<=23)&&((m&3)==1)&&((m<<sh)==hi)) m&=~1ULL; // exactly halfway, round to even
+  m+=(m&1); m>>=1;
+  if (m>=(2ULL<<52)) { m=(1ULL<<52); p2++; }
+  m&=~(1ULL<<52);
+  if (p2>=0x7FF) return 0x7FF0000000000000ULL;
+  return ((IXJSU64)p2<<52)|m;
+}
+
+/*
+** Correctly rounded, for numbers with more digits than w holds: the first
+** IXJS_NUM_SLOW significant digits as an integer (and a 1 if any non zero
+** digit follows) with the exponent, no decimal point so the locale can't
+** get in the way.
+*/
+static double i_num_slow(const char *p, const char *e, long x)
+{ char b[IXJS_NUM_SLOW+32], t[24]; int k=0, nd=0, frac=0, more=0, i=0; long ex=x; 
+  for (;(p<e)&&((*p)!='e')&&((*p)!='E');p++)
+  { if ((*p)=='.') { frac=1; continue; }
+    if ((nd==0)&&((*p)=='0')) { if (frac) ex--; continue; } // leading zeros
+    if (nd<IXJS_NUM_SLOW) { b[k++]=*p; nd++; if (frac) ex--; }
+    else { if (!frac) ex++; if ((*p)!='0') more=1; }
+  }
+  if (more) { b[k++]='1'; ex--; }
+  b[k++]='e'; if (ex<0) { b[k++]='-'; ex=-ex; }
+  do { t[i++]=(char)('0'+(ex%10)); ex/=10; } while (ex);
+  while (i) b[k++]=t[--i];
+  b[k]=0;
+  return strtod(b, NULL);
+}
+
+/*
+** Decode the JSON number in [p,e).
+*/
+static int i_num_decode(const char *p, const char *e, XJSNumber *num)
+{ const char *s=p; IXJSU64 w=0, bits; int nd=0, cut=0, neg=0, isint=1, xneg=0; long q=0, x=0; double d;
+  num->kind=XJS_NUM_DOUBLE; num->flags=0; num->i=0; num->d=0;
+  if ((p<e)&&((*p)=='-')) { neg=1; p++; }
+  if ((p>=e)||(!IXJS_DIGIT(*p))) return XJS_ERR_EXP_DIGIT;
+  if ((*p)=='0') p++;
+  else for (;(p<e)&&(IXJS_DIGIT(*p));p++) 
+  { if (nd<IXJS_NUM_MAXW) { w=w*10+(IXJSU64)(*p-'0'); nd++; } else { q++; if ((*p)!='0') cut=1; } }
+  if ((p<e)&&((*p)=='.'))
+  { p++; isint=0; 
+    if ((p>=e)||(!IXJS_DIGIT(*p))) return XJS_ERR_EXP_DIGIT;
+    for (;(p<e)&&(IXJS_DIGIT(*p));p++) 
+    { if (nd<IXJS_NUM_MAXW) { w=w*10+(IXJSU64)(*p-'0'); q--; if (w) nd++; } else if ((*p)!='0') cut=1; }
+  }
+  if ((p<e)&&(((*p)=='e')||((*p)=='E')))
+  { p++; isint=0; 
+    if ((p<e)&&(((*p)=='+')||((*p)=='-'))) xneg=((*p++)=='-');
+    if ((p>=e)||(!IXJS_DIGIT(*p))) return XJS_ERR_EXP_DIGIT;
+    for (;(p<e)&&(IXJS_DIGIT(*p));p++) if (x<100000) x=x*10+(*p-'0'); // far beyond any double either way
+    q+=(xneg)?-x:x;
+  }
+  if (p!=e) return XJS_ERR_BAD_INPUT;
+  if (isint) 
+  { if ((q==0)&&(w<=((neg)?0x8000000000000000ULL:0x7FFFFFFFFFFFFFFFULL)))
+    { num->kind=XJS_NUM_INT; 
+      num->i=(neg)?((w==0x8000000000000000ULL)?(-0x7FFFFFFFFFFFFFFFLL-1):-(long long)w):(long long)w;
+    }
+    else num->flags|=XJS_NUMF_RANGE; // too big for 64 bits
+  }
+  if (w==0) { num->d=(neg)?-0.0:0.0; return XJS_OK; }
+  if ((!cut)&&(w<=(1ULL<<53))&&(q>=-22)&&(q<=22)) d=(q<0)?(double)w/i_pow10[-q]:(double)w*i_pow10[q];
+  else if (q<IXJS_POW5_MIN) { d=0; num->flags|=XJS_NUMF_RANGE|XJS_NUMF_INEXACT; }
+  else
+  { bits=(q>IXJS_POW5_MAX)?0x7FF0000000000000ULL:i_num_el(w, q);
+    if ((cut)&&(q<=IXJS_POW5_MAX)&&(i_num_el(w+1, q)!=bits)) d=i_num_slow(s+neg, e, (xneg)?-x:x); // the cut digits decide
+    else memcpy(&d, &bits, sizeof(d));
+    if (d==0) num->flags|=XJS_NUMF_RANGE|XJS_NUMF_INEXACT; // too small for a double
+  }
+  if ((d-d)!=0) num->flags|=XJS_NUMF_RANGE|XJS_NUMF_INEXACT; // infinite
+  if ((cut)||(!i_num_exact(w, q))) num->flags|=XJS_NUMF_INEXACT;
+  num->d=(neg)?-d:d;
+  return XJS_OK;
 }
 
 #ifdef __cplusplus
@@ -29,7 +29,8 @@
 ** A simple JSON parser for C/C++
 ** 
 ** **xjs** parses a JSON stream and signals the caller of items parsed via
-** a callback function. Input can be ASCII or UTF-8
+** a callback function. Input can be ASCII or UTF-8, strings are validated
+** as UTF-8 while they are scanned.
 ** 
 ** **xjs** does not provide any hierarchical structure to the stream.
 ** The caller can assosicate memory with parsed objects and arrays within
@@ -46,6 +47,35 @@
 ** 
 ** Each buffer returned by the input callback must be null terminated. 
 ** 
+** `xjs_parse_n` takes length delimited input instead, and its input
+** callback (`XJSInputNCB`) returns a pointer and a length. The buffers need
+** not be null terminated, so data read from a file or socket can be passed
+** to the parser without copying it into a padded buffer.
+** 
+** `xjs_parse_view` also takes length delimited input, and passes names and
+** values to its callback (`XJSNodeViewCB`) as a pointer and a length. When
+** a token lies inside the current input buffer the pointer is into the
+** input, so nothing is allocated or copied for it. Only tokens that cross
+** the end of an input buffer are copied into storage from the memory manager.
+** 
+** `xjs_parser_new` creates a push parser for input that arrives in pieces,
+** for example from a non-blocking socket. Each piece is passed to `xjs_feed`
+** as it comes, the parser keeps the open containers and the partial token
+** between calls and returns `XJS_MORE` until the document is complete.
+** `xjs_finish` ends the input. The pieces need not be null terminated and
+** are not used after `xjs_feed` returns.
+** 
+** ## Nesting limit
+** 
+** The parser does not recurse, it keeps one frame per open container on a
+** stack. The first frames are on the C stack (or in the push parser), deeper
+** input grows the stack with the memory manager (`XJS_parser`). Containers
+** nested deeper than 1024 fail with `XJS_ERR_DEPTH`, so hostile input can
+** neither overflow the C stack nor use unbounded storage. `xjs_parser_limit`
+** sets another limit for a parser, and can give it fixed storage for the
+** stack (`xjs_stack_size` bytes), then the parser allocates nothing for it.
+** `xjs_parser_parse` runs such a parser on pulled input like `xjs_parse_n`.
+** 
 ** ## Blocks (not standard JSON)
 ** 
 ** Blocks provides a more compact method of representing an array
@@ -79,7 +109,8 @@
 ** `XJS_CFLAG_DISABLE_MEM_FALLBACK` - if defined the parser will NOT use
 ** libc `malloc/free` to allocate storage, and `XJSMemCB` must be passed to
 ** parse. Otherwise passing NULL to xjs_parse for `XJSMemCB` will default to 
-** `malloc/free`.
+** the built-in arena (see `xjs_arena_new`), which gets its chunks from
+** `malloc/free`. The arena functions are not available when it is defined.
 ** 
 ** `XJS_CFLAG_ENABLE_BLOCKS` - if defined the parser will handle Blocks as 
 ** described above otherwise blocks in JSON will generate an error.
@@ -90,11 +121,21 @@
 ** `XJS_CFLAG_DISABLE_ARRAY_POS_AS_NAME` - **xjs** sends the ordinal number
 ** of array elements as ascii text in the name field for all array elements.
 ** If defined the name field will be ```NULL``` for array elements. 
-** *Otherwise `snprintf` from libc will be linked.*
 ** 
 ** `XJS_CFLAG_DISABLE_SIZE_T` - if defined the API will not use `size_t`
 ** from libc, instead it will use `unsigned long`.
 ** 
+** `XJS_CFLAG_DISABLE_SIMD` - if defined the scanner will only use its
+** portable byte at a time kernels. Otherwise SSE2 or AVX2 kernels are used
+** for strings and white space when the CPU supports them (x86 with GCC or
+** Clang).
+** 
+** `XJS_CFLAG_DISABLE_UTF8_CHECK` - if defined bytes above 0x7F in strings
+** are passed through as they are. Otherwise strings must be valid UTF-8
+** and invalid sequences fail with `XJS_ERR_BAD_UTF8`.
+** 
+** `XJS_CFLAG_MAX_DEPTH` - the default nesting limit (1024 if not defined).
+** 
 ** ---------------------------------------------------------------------------
 */
 
@@ -141,6 +182,12 @@ typedef size_t XJSSize;
 #define XJS_ERR_BAD_LITERAL          15   /* invalid input regarding a literal */
 #define XJS_ERR_CONTROL_CHAR         16   /* bad ascii */
 #define XJS_ERR_MORE_INPUT           17   /* input remaining after completion */
+#define XJS_ERR_BAD_UTF8             18   /* invalid UTF-8 sequence in a string */
+#define XJS_MORE                     19   /* the input ended inside the document, feed more (xjs_feed) */
+#define XJS_ERR_DEPTH                20   /* containers are nested deeper than the limit */
+#define XJS_ERR_BAD_SURROGATE        21   /* a \u escape is an unpaired UTF-16 surrogate (XJS_OPT_DECODE) */
+#define XJS_SKIP                     22   /* from the node callback of an array or object: pass over its contents */
+#define XJS_ERR_IO                   23   /* a file could not be opened, mapped or read */
 #ifdef XJS_CFLAG_ENABLE_BLOCKS
 #define XJS_ERR_BLOCK_ARRAY_SIZE    100   /* block arrays must all be the same size (including header) */
 #endif
@@ -165,6 +212,13 @@ typedef enum
   XJS_false            =  6,  /* a "false" literal was parsed */
   XJS_null             =  7,  /* a "null" literal was parsed */
   XJS_name             =  8,  /* NOT SIGNALED! only for memory management */
+  XJS_parser           =  9,  /* NOT SIGNALED! only for memory management (push parser, the container stack beyond 15 levels, xjs_par) */
+  XJS_index            = 10,  /* NOT SIGNALED! only for memory management (structural index XJS_OPT_INDEX, block index) */
+  XJS_dom              = 11,  /* NOT SIGNALED! only for memory management (xjs_dom tape and string pool) */
+  XJS_filter           = 12,  /* NOT SIGNALED! only for memory management (xjs_filter_new) */
+  XJS_keys             = 13,  /* NOT SIGNALED! only for memory management (xjs_keys_new) */
+  XJS_write            = 14,  /* NOT SIGNALED! only for memory management (xjs_write buffer and stack) */
+  XJS_file             = 15,  /* NOT SIGNALED! only for memory management (xjs_file read buffer) */
 #ifdef XJS_CFLAG_ENABLE_BLOCKS 
   XJS_block            =  100,  /* a data block has been found, the CB can set a parent that will be used for all its records */
   XJS_block_end        = -100,  /* a data block is completed (parent is set to the data block) */
@@ -174,7 +228,8 @@ typedef enum
   XJS_block_array_end  = -102,  /* the current record in the block is complete */
 #endif
   XJS_array_end        = -1,  /* signals that an array is completed (parent is set to the array) */
-  XJS_object_end       = -2   /* signals that an object is completed (parent is set to the object) */
+  XJS_object_end       = -2,  /* signals that an object is completed (parent is set to the object) */
+  XJS_document_end     = -3   /* a top level value is completed (XJS_OPT_SEQ), the next document may follow */
 } XJSType; 
 
 /*
@@ -183,7 +238,9 @@ typedef enum
 ** Structure of JSON Node (item) Callback. This function is passed to the 
 ** parser and called whenever an item is encountered in the stream. 
 **
-** Returns XJS_OK, any other value will halt processing 
+** Returns XJS_OK, or XJS_SKIP when kind is XJS_array or XJS_object (or
+** XJS_block) to pass over its contents: nothing in it is signaled or
+** copied, only its end is. Any other value will halt processing 
 ** ---------------------------------------------------------------------------
 */
 typedef int (*XJSNodeCB)(
@@ -192,7 +249,105 @@ typedef int (*XJSNodeCB)(
   const char *name,   /* IN : Name for an object member */
   const char *value,  /* IN : Value field */
   void *node_arg);    /* IN : argument from parse call */
+
+/*
+** ---------------------------------------------------------------------------
+** CALLBACK: XJSNodeViewCB
+** Zero copy version of XJSNodeCB used by xjs_parse_view. The name and value
+** are passed as a pointer and a length, and are NOT null terminated. When a
+** token lies inside the current input buffer they point straight into the
+** input, otherwise into storage from the memory manager. Either way they
+** are only valid until the callback returns.
+**
+** Returns XJS_OK, XJS_SKIP like XJSNodeCB, any other value will halt
+** processing 
+** ---------------------------------------------------------------------------
+*/
+typedef int (*XJSNodeViewCB)(
+  void **parent,      /* IN/OUT : Callback should set on new array or object, and use on others to create hierarchy */
+  XJSType kind,       /* IN : Specifies the kind of node that was parsed. */
+  const char *name,   /* IN : Name for an object member (not null terminated), NULL if none */
+  XJSSize name_len,   /* IN : Length of name */
+  const char *value,  /* IN : Value field (not null terminated), NULL if none */
+  XJSSize value_len,  /* IN : Length of value */
+  void *node_arg);    /* IN : argument from parse call */
+
+/*
+** ---------------------------------------------------------------------------
+** A node as XJSNodeDescCB gets it. The name and value are views like those
+** of XJSNodeViewCB. An array element has no name, index is its position.
+** The offset counts from the first byte of the input (across all buffers):
+** the open or close bracket of a container, the first byte of a scalar (the
+** quote of a string), or the byte after the document for XJS_document_end.
+** ---------------------------------------------------------------------------
+*/
+typedef struct
+{ XJSType kind;          /* the kind of node */
+  int depth;             /* 0 for a top level value, the end of a container has the depth of its start */
+  XJSSize index;         /* position in the container (from 0), or the document with XJS_OPT_SEQ */
+  XJSSize offset;        /* where the node is in the input */
+  const char *name;      /* member name (not null terminated), NULL in an array and at the top level */
+  XJSSize name_len;
+  const char *value;     /* value field (not null terminated), NULL if none */
+  XJSSize value_len;
+} XJSNode;
+
+/*
+** ---------------------------------------------------------------------------
+** CALLBACK: XJSNodeDescCB
+** XJSNodeViewCB with the node described by an XJSNode, used by
+** xjs_parse_desc and xjs_parser_new_desc. The node is only valid until the
+** callback returns.
+**
+** Returns XJS_OK, XJS_SKIP like XJSNodeCB, any other value will halt
+** processing 
+** ---------------------------------------------------------------------------
+*/
+typedef int (*XJSNodeDescCB)(
+  void **parent,      /* IN/OUT : Callback should set on new array or object, and use on others to create hierarchy */
+  const XJSNode *node, /* IN : The node */
+  void *node_arg);    /* IN : argument from parse call */
     
+/*
+** ---------------------------------------------------------------------------
+** Typed number, decoded from the text of a JSON number. Integers (no
+** fraction or exponent) that fit in 64 bits are exact in i, everything else
+** is a double rounded to nearest. d is always set.
+** ---------------------------------------------------------------------------
+*/
+#define XJS_NUM_INT      1   /* an integer, i is exact */
+#define XJS_NUM_DOUBLE   2   /* only d is set */
+
+#define XJS_NUMF_RANGE   1   /* an integer too big for i, or a number beyond double (d is +-HUGE_VAL or 0) */
+#define XJS_NUMF_INEXACT 2   /* d may differ from the number in the text (it was rounded) */
+
+typedef struct 
+{ int kind;          /* XJS_NUM_INT or XJS_NUM_DOUBLE */
+  int flags;         /* XJS_NUMF_* */
+  long long i;       /* the value if kind is XJS_NUM_INT, otherwise 0 */
+  double d;          /* the value as a double */
+} XJSNumber;
+
+/*
+** ---------------------------------------------------------------------------
+** CALLBACK: XJSNumberCB
+** Called instead of the node callback for numbers once a parser has one
+** (xjs_parser_numbers). It gets the decoded number next to the text, which
+** is NOT null terminated and only valid until the callback returns. The
+** name is like the node callback's, with its length.
+**
+** Returns XJS_OK, any other value will halt processing 
+** ---------------------------------------------------------------------------
+*/
+typedef int (*XJSNumberCB)(
+  void **parent,      /* IN/OUT : Parent set by the container's callback */
+  const char *name,   /* IN : Name for an object member, NULL if none */
+  XJSSize name_len,   /* IN : Length of name */
+  const char *text,   /* IN : The number as it is in the input (not null terminated) */
+  XJSSize text_len,   /* IN : Length of text */
+  const XJSNumber *num, /* IN : The decoded number */
+  void *node_arg);    /* IN : argument from parser creation */
+
 /*
 ** ---------------------------------------------------------------------------
 ** CALLBACK: XJSInputCB
@@ -208,6 +363,24 @@ typedef int (*XJSInputCB)(
   const char **input, /* OUT : Pointer to new input buffer */
   void *inp_arg);     /* IN : argument from parse call */
 
+/*
+** ---------------------------------------------------------------------------
+** CALLBACK: XJSInputNCB
+** Length delimited JSON Input Callback used by xjs_parse_n. This function is
+** called whenever the parser reaches the end of the current input buffer.
+** It should provide a pointer to the next buffer of JSON and its length,
+** the buffer does NOT need to be null terminated and must stay valid until
+** the next call. A zero length buffer ends the input (like XJS_END).
+**
+** Returns XJS_OK, XJS_END at the end of input, any other value will halt
+** processing
+** ---------------------------------------------------------------------------
+*/
+typedef int (*XJSInputNCB)(
+  const char **input, /* OUT : Pointer to new input buffer */
+  XJSSize *len,       /* OUT : Number of bytes in the new input buffer */
+  void *inp_arg);     /* IN : argument from parse call */
+
 /*
 ** ---------------------------------------------------------------------------
 ** CALLBACK: XJSMemCB
@@ -239,9 +412,593 @@ int xjs_parse(
   void *node_arg,        /* IN : Parameter passed to node_cb */
   XJSInputCB inp_cb,     /* IN : Request for input, can be NULL if json contains all the input */
   void *inp_arg,         /* IN : Parameter passed to inp_cb */
-  XJSMemCB mem_cb,       /* IN : Optional memory manager callback (NULL for libc)   */
+  XJSMemCB mem_cb,       /* IN : Optional memory manager callback (NULL for the built-in arena) */
+  const char **errpos);  /* OUT: NULL if successful, otherwise pointer to input when an error occurred */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parse_n is xjs_parse for length delimited input. The input
+** is scanned as the range [json,json+len) and the input callback is only
+** called at the end of each buffer, no null terminators are required.
+**
+** Returns XJS_OK or an error code defined above.
+** ---------------------------------------------------------------------------
+*/
+int xjs_parse_n(
+  const char *json,      /* IN : Input (need not be null terminated), or NULL to use inp_cb prior to parsing */
+  XJSSize len,           /* IN : Number of bytes at json */
+  XJSNodeCB node_cb,     /* IN : Node parsed callback function, can't be NULL */
+  void *node_arg,        /* IN : Parameter passed to node_cb */
+  XJSInputNCB inp_cb,    /* IN : Request for input, can be NULL if json contains all the input */
+  void *inp_arg,         /* IN : Parameter passed to inp_cb */
+  XJSMemCB mem_cb,       /* IN : Optional memory manager callback (NULL for the built-in arena) */
+  const char **errpos);  /* OUT: NULL if successful, otherwise pointer to input when an error occurred */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parse_view is xjs_parse_n with a zero copy node callback.
+** Names and values that lie inside an input buffer are passed as views of
+** the input, the memory manager is only used for tokens that cross the end
+** of an input buffer (and for block headers).
+**
+** Returns XJS_OK or an error code defined above.
+** ---------------------------------------------------------------------------
+*/
+int xjs_parse_view(
+  const char *json,      /* IN : Input (need not be null terminated), or NULL to use inp_cb prior to parsing */
+  XJSSize len,           /* IN : Number of bytes at json */
+  XJSNodeViewCB node_cb, /* IN : Node parsed callback function, can't be NULL */
+  void *node_arg,        /* IN : Parameter passed to node_cb */
+  XJSInputNCB inp_cb,    /* IN : Request for input, can be NULL if json contains all the input */
+  void *inp_arg,         /* IN : Parameter passed to inp_cb */
+  XJSMemCB mem_cb,       /* IN : Optional memory manager callback (NULL for the built-in arena) */
+  const char **errpos);  /* OUT: NULL if successful, otherwise pointer to input when an error occurred */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parse_desc is xjs_parse_view with a node descriptor
+** (XJSNodeDescCB): the lengths, the depth, the position of an array element
+** as a number instead of text, and the offset of the node in the input.
+**
+** Returns XJS_OK or an error code defined above.
+** ---------------------------------------------------------------------------
+*/
+int xjs_parse_desc(
+  const char *json,      /* IN : Input (need not be null terminated), or NULL to use inp_cb prior to parsing */
+  XJSSize len,           /* IN : Number of bytes at json */
+  XJSNodeDescCB node_cb, /* IN : Node parsed callback function, can't be NULL */
+  void *node_arg,        /* IN : Parameter passed to node_cb */
+  XJSInputNCB inp_cb,    /* IN : Request for input, can be NULL if json contains all the input */
+  void *inp_arg,         /* IN : Parameter passed to inp_cb */
+  XJSMemCB mem_cb,       /* IN : Optional memory manager callback (NULL for the built-in arena) */
+  const char **errpos);  /* OUT: NULL if successful, otherwise pointer to input when an error occurred */
+
+/*
+** ---------------------------------------------------------------------------
+** Push parser. The caller feeds the input as it arrives instead of the
+** parser asking for it through an input callback, so a parse never blocks.
+** The parser keeps its state (the open containers, the partial token, the
+** block header) between the calls, and copies the parts of a partial token
+** it still needs before xjs_feed returns.
+** ---------------------------------------------------------------------------
+*/
+typedef struct XJSParser XJSParser; /* opaque, from xjs_parser_new */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_new creates a push parser with a node callback,
+** xjs_parser_new_view with a zero copy node callback (see xjs_parse_view),
+** or xjs_parser_new_desc with a node descriptor callback (xjs_parse_desc).
+** The parser is allocated from the memory manager (XJS_parser).
+**
+** Returns the parser, or NULL if there is no storage for it.
+** ---------------------------------------------------------------------------
+*/
+XJSParser *xjs_parser_new(
+  XJSNodeCB node_cb,     /* IN : Node parsed callback function, can't be NULL */
+  void *node_arg,        /* IN : Parameter passed to node_cb */
+  XJSMemCB mem_cb);      /* IN : Optional memory manager callback (NULL for the built-in arena) */
+
+XJSParser *xjs_parser_new_view(
+  XJSNodeViewCB node_cb, /* IN : Node parsed callback function, can't be NULL */
+  void *node_arg,        /* IN : Parameter passed to node_cb */
+  XJSMemCB mem_cb);      /* IN : Optional memory manager callback (NULL for the built-in arena) */
+
+XJSParser *xjs_parser_new_desc(
+  XJSNodeDescCB node_cb, /* IN : Node parsed callback function, can't be NULL */
+  void *node_arg,        /* IN : Parameter passed to node_cb */
+  XJSMemCB mem_cb);      /* IN : Optional memory manager callback (NULL for the built-in arena) */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_limit sets the deepest nesting of containers the
+** parser accepts (0 for the default), deeper input fails with XJS_ERR_DEPTH.
+** If stack is not NULL the container stack is kept in it instead of storage
+** from the memory manager, xjs_stack_size(max_depth) bytes are enough. The
+** stack must be aligned for pointers and stay valid until the parser is
+** freed. Call it before the first xjs_feed or xjs_parser_parse.
+**
+** Returns XJS_OK, or XJS_ERR_USAGE if the parse has started or the stack is
+** too small for a single container.
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_limit(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  int max_depth,         /* IN : Deepest nesting allowed, 0 for the default */
+  void *stack,           /* IN : Optional storage for the container stack (NULL to allocate it) */
+  XJSSize stack_size);   /* IN : Number of bytes at stack */
+
+XJSSize xjs_stack_size(int max_depth);
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_options turns on optional parser behaviour, the
+** XJS_OPT_* flags below. Call it before the parse starts.
+**
+** XJS_OPT_DECODE - strings and names reach the callback with their escapes
+** decoded to UTF-8 (\uXXXX including surrogate pairs, unpaired surrogates
+** fail with XJS_ERR_BAD_SURROGATE). A string with escapes is decoded into
+** storage from the memory manager, strings without are passed as before.
+** \u0000 decodes to a null byte, XJSNodeCB sees the string end there.
+**
+** XJS_OPT_INDEX - for a document that is all in memory (xjs_parser_parse
+** without an input callback). A first pass finds every structural
+** character, string and scalar 64 bytes at a time and records their
+** offsets in an index (from the memory manager, XJS_index). The parse then
+** jumps from entry to entry, and strings without escapes are taken whole.
+** The events are the same. Documents of 2 GB or more, or when there is no
+** storage for the index, are parsed without it.
+**
+** XJS_OPT_SEQ - the input is a sequence of documents (NDJSON, or values
+** just separated by white space) instead of one. Any value can be a
+** document, also a string, number or literal. XJS_document_end is signaled
+** after each (with a NULL parent, name and value) and the next one is
+** parsed with the same parser, stack and buffers. Input of only white
+** space is an empty sequence, and xjs_feed returns XJS_OK whenever the
+** input so far ends between two documents. XJS_FILTER_STOP has no effect, every
+** document is parsed to its end.
+**
+** Returns XJS_OK, or XJS_ERR_USAGE if the parse has started or an option
+** is unknown.
+** ---------------------------------------------------------------------------
+*/
+#define XJS_OPT_DECODE   0x01   /* decode escapes in strings and names */
+#define XJS_OPT_INDEX    0x02   /* two pass parse of a document in memory */
+#define XJS_OPT_SEQ      0x04   /* a sequence of documents */
+
+int xjs_parser_options(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  int options);          /* IN : XJS_OPT_* flags or'ed together */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_numbers makes the parser decode numbers as it
+** scans them, and pass them to num_cb instead of the node callback (NULL
+** to go back to text). Numbers passed to num_cb are not copied when they
+** lie in the input buffer, even for XJSNodeCB. Call it before the parse
+** starts.
+**
+** Returns XJS_OK, or XJS_ERR_USAGE if the parse has started.
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_numbers(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  XJSNumberCB num_cb);   /* IN : Number callback, gets the parser's node_arg */
+
+/*
+** ---------------------------------------------------------------------------
+** An event of a batch (xjs_parser_batch), one for each node XJSNodeViewCB
+** would get. Events are numbered from 0 across the parse. Names and values
+** are NOT null terminated, they are views of the input or copies kept with
+** the batch, and are valid until the batch callback returns.
+** ---------------------------------------------------------------------------
+*/
+typedef struct
+{ XJSType kind;          /* the kind of node, as for XJSNodeViewCB */
+  int depth;             /* 0 for a top level value, the end of a container has the depth of its start */
+  long long parent;      /* number of the event that opened the container it is in, -1 at the top level */
+  XJSSize index;         /* position in the container (from 0), or the document with XJS_OPT_SEQ */
+  const char *name;      /* member name, NULL in an array and at the top level */
+  XJSSize name_len;
+  const char *value;     /* value of a scalar, NULL for containers and literals */
+  XJSSize value_len;
+} XJSEvent;
+
+/*
+** ---------------------------------------------------------------------------
+** CALLBACK: XJSBatchCB
+** Called with n events, the first of them numbered first. 
+**
+** Returns XJS_OK, any other value will halt processing
+** ---------------------------------------------------------------------------
+*/
+typedef int (*XJSBatchCB)(
+  const XJSEvent *events, /* IN : The events, in the order of the input */
+  int n,                 /* IN : Number of events */
+  long long first,       /* IN : Number of the first event */
+  void *node_arg);       /* IN : argument from parser creation */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_batch makes the parser collect its events into
+** events (size of them) and pass them to batch_cb instead of calling the
+** node callback for each, NULL to go back to the node callback. A batch is
+** passed on when the array is full, before the parser moves on to the next
+** input buffer, and before xjs_feed, xjs_finish or xjs_parser_parse
+** return. The node callback (it can be NULL) and XJSNumberCB are not
+** called, numbers are text, and XJS_SKIP can't be used. The array is only
+** written by the parser. Call it before the parse starts.
+**
+** Returns XJS_OK, or XJS_ERR_USAGE if the parse has started or there is no
+** array.
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_batch(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  XJSEvent *events,      /* IN : Storage for a batch, valid until the parser is freed */
+  int size,              /* IN : Number of events at events */
+  XJSBatchCB batch_cb);  /* IN : Batch callback, gets the parser's node_arg */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_number decodes the text of a JSON number, like the
+** parser does for XJSNumberCB. Integers that fit are exact, doubles are
+** correctly rounded (Eisel-Lemire, falling back to strtod for the rare
+** numbers it can't decide).
+**
+** Returns XJS_OK, or XJS_ERR_EXP_DIGIT / XJS_ERR_BAD_INPUT if the text is
+** not a JSON number.
+** ---------------------------------------------------------------------------
+*/
+int xjs_number(
+  const char *text,      /* IN : The number (need not be null terminated) */
+  XJSSize len,           /* IN : Number of bytes at text */
+  XJSNumber *num);       /* OUT: The decoded number */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_filter_new compiles paths into a filter for
+** xjs_parser_filter. A path is a JSON Pointer ("/events/0/user", ~0 for ~
+** and ~1 for / in a name, "" for the whole document) where a "*" segment
+** matches any member or element. A filter can be used by many parsers, one
+** after the other or at the same time, and must outlive them.
+**
+** A parser with a filter signals only the values on a path, all of them
+** (with everything inside), and the containers on the way to them (with
+** their ends, so the parents set by the callback are there). Nothing else
+** is copied or signaled. Scalars off the paths are still checked, but
+** containers off them are passed over like XJS_SKIP (only brackets and
+** strings are checked), so an invalid value inside one is not reported.
+** Names are compared as the callback would get them (decoded with
+** XJS_OPT_DECODE). Paths don't lead into blocks.
+**
+** XJS_FILTER_STOP - once a value on every path without a wildcard has been
+** signaled, the parse stops and returns XJS_OK. The rest of the input is
+** not read (or checked), the open containers are not ended.
+**
+** Returns XJS_OK and sets *filter, or XJS_ERR_USAGE if a path is not valid
+** or there are more than 64 paths, or XJS_ERR_MEM_ALLOC.
+** ---------------------------------------------------------------------------
+*/
+#define XJS_FILTER_STOP  0x01   /* stop the parse once every path without a wildcard is found */
+
+typedef struct XJSFilter XJSFilter; /* opaque, from xjs_filter_new */
+
+int xjs_filter_new(
+  XJSFilter **filter,    /* OUT: The filter, free it with xjs_filter_free */
+  const char *const *paths, /* IN : The paths (null terminated) */
+  int npaths,            /* IN : Number of paths, 1 to 64 */
+  int flags,             /* IN : XJS_FILTER_* flags or'ed together */
+  XJSMemCB mem_cb);      /* IN : Optional memory manager callback (NULL for libc) */
+
+void xjs_filter_free(XJSFilter *filter);
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_filter makes the parser signal only what filter
+** selects (NULL for everything). Call it before the parse starts.
+**
+** Returns XJS_OK, or XJS_ERR_USAGE if the parse has started.
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_filter(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  const XJSFilter *filter); /* IN : Filter from xjs_filter_new, or NULL */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_keys_new compiles the member names a callback knows into
+** a key dictionary (a perfect hash) for xjs_parser_keys. A parser with a
+** dictionary passes a known name as the dictionary's own copy (null
+** terminated), so it is not copied or allocated, and xjs_key gives its id,
+** the index in names, from the pointer alone. Other names are passed as
+** before and xjs_key returns XJS_KEY_UNKNOWN for them. Names are compared
+** as the callback would get them (decoded with XJS_OPT_DECODE). A
+** dictionary can be used by many parsers, and must outlive them.
+**
+** int nodecb(void **parent, XJSType kind, const char *name, const char *value, void *arg)
+** { switch (xjs_key(keys, name)) { case K_ID: ...; case K_NAME: ...; } }
+**
+** xjs_keys_new returns XJS_OK and sets *keys, XJS_ERR_USAGE if a name is
+** there twice, or XJS_ERR_MEM_ALLOC.
+** xjs_parser_keys returns XJS_OK, or XJS_ERR_USAGE if the parse has started.
+** ---------------------------------------------------------------------------
+*/
+#define XJS_KEY_UNKNOWN  (-1)
+
+typedef struct XJSKeys XJSKeys; /* opaque, from xjs_keys_new */
+
+int xjs_keys_new(
+  XJSKeys **keys,        /* OUT: The dictionary, free it with xjs_keys_free */
+  const char *const *names, /* IN : The names (null terminated), their index is the id */
+  int nnames,            /* IN : Number of names */
+  XJSMemCB mem_cb);      /* IN : Optional memory manager callback (NULL for libc) */
+
+void xjs_keys_free(XJSKeys *keys);
+int xjs_key(const XJSKeys *keys, const char *name);
+int xjs_parser_keys(XJSParser *parser, const XJSKeys *keys);
+
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+/*
+** ---------------------------------------------------------------------------
+** Block columns. A parser with a column callback (xjs_parser_columns)
+** collects the records of a block into column vectors, one XJSColumn per
+** header field, and passes them in batches of up to rows records instead of
+** signaling each record and cell. The block, its header and its end are
+** signaled as before, the callback gets the parent set for the block.
+**
+** Row r of a column has the kind kind[r]:
+**   XJS_number   - d[r], and i[r] if bit r of ints is set (an integer that
+**                  fits, see XJSNumber)
+**   XJS_string   - the text from text+off[r] to text+off[r+1] (like
+**                  XJSNodeViewCB, decoded with XJS_OPT_DECODE)
+**   XJS_true, XJS_false - bit r of bools is set for true
+**   XJS_null     - bit r of nulls is set
+**   XJS_array, XJS_object, XJS_block - a container, its JSON text is in
+**                  text like a string's
+** Bit r of a bitmap is (map[r/8]>>(r%8))&1. off has rows+1 entries, rows
+** that are not text have off[r+1]==off[r]. The vectors (from the memory
+** manager, XJS_block_array) are only valid until the callback returns.
+** ---------------------------------------------------------------------------
+*/
+typedef struct
+{ const char *name;      /* the header field (null terminated), NULL if it is empty or the header was not kept */
+  unsigned char *kind;   /* XJSType of each row */
+  long long *i;          /* integers */
+  double *d;             /* numbers */
+  XJSSize *off;          /* text offsets, rows+1 of them */
+  char *text;            /* text of the strings and containers (not null terminated) */
+  unsigned char *ints;   /* bitmap: i is exact */
+  unsigned char *bools;  /* bitmap: true */
+  unsigned char *nulls;  /* bitmap: null */
+} XJSColumn;
+
+typedef struct
+{ int rows;              /* records in the batch */
+  XJSSize first;         /* index of the first one in the block */
+  int ncols;             /* fields in the header */
+  const XJSColumn *col;  /* ncols columns */
+} XJSColumns;
+
+/*
+** ---------------------------------------------------------------------------
+** CALLBACK: XJSColumnCB
+** Called with the next batch of records of a block (xjs_parser_columns).
+**
+** Returns XJS_OK, any other value will halt processing
+** ---------------------------------------------------------------------------
+*/
+typedef int (*XJSColumnCB)(
+  void **parent,      /* IN/OUT : Parent set by the block's callback */
+  const XJSColumns *batch, /* IN : The records */
+  void *node_arg);    /* IN : argument from parser creation */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_columns makes the parser pass the records of
+** blocks to col_cb in batches of rows (0 for 1024), NULL to signal them as
+** nodes again. Call it before the parse starts.
+**
+** Returns XJS_OK, or XJS_ERR_USAGE if the parse has started.
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_columns(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  XJSColumnCB col_cb,    /* IN : Column callback, gets the parser's node_arg */
+  int rows);             /* IN : Records per batch, 0 for the default */
+
+/*
+** ---------------------------------------------------------------------------
+** Block index. For a document that is one large block, xjs_block_index_new
+** reads it once and marks every every-th record (0 for 1024) with the byte
+** offset of its open bracket, and keeps the header names (as they are in
+** the input). The records are passed over like XJS_SKIP, so only their
+** brackets and strings are checked. The input is like xjs_parse_n, the
+** offsets count from its first byte across all the buffers.
+**
+** xjs_block_index_save writes the index to buf (so it can be stored next
+** to the document) if size is enough, and returns the bytes it takes.
+** xjs_block_index_load makes an index from what was saved.
+**
+** xjs_parser_block sets a parser up to parse the block's records from rec
+** on, count of them (0 for all, then the block end is signaled). The input
+** must start at *offset in the document (the mark at or before rec), for
+** example json+offset for xjs_parser_parse or a file read from there. The
+** records between the mark and rec are passed over, the block and its
+** header are not signaled, the records get parent as their parent. Column
+** batches (xjs_parser_columns, call it first) start at rec. Several
+** parsers can each take a range of the records of one index.
+**
+** xjs_block_index_new returns XJS_OK and sets *bi, XJS_ERR_BAD_INPUT if the
+** document is not a block, or another error code.
+** xjs_block_index_load returns XJS_OK and sets *bi, XJS_ERR_BAD_INPUT if
+** buf is not a saved index, or XJS_ERR_MEM_ALLOC.
+** xjs_parser_block returns XJS_OK, or XJS_ERR_USAGE if the parse has
+** started or rec is beyond the last record.
+** ---------------------------------------------------------------------------
+*/
+typedef struct XJSBlockIndex XJSBlockIndex; /* opaque, from xjs_block_index_new */
+
+int xjs_block_index_new(
+  XJSBlockIndex **bi,    /* OUT: The index, free it with xjs_block_index_free */
+  const char *json,      /* IN : Input (need not be null terminated), or NULL to use inp_cb prior to parsing */
+  XJSSize len,           /* IN : Number of bytes at json */
+  XJSInputNCB inp_cb,    /* IN : Request for input, can be NULL if json contains all the input */
+  void *inp_arg,         /* IN : Parameter passed to inp_cb */
+  XJSSize every,         /* IN : Records from one mark to the next, 0 for the default */
+  XJSMemCB mem_cb,       /* IN : Optional memory manager callback (NULL for libc) */
   const char **errpos);  /* OUT: NULL if successful, otherwise pointer to input when an error occurred */
 
+void xjs_block_index_free(XJSBlockIndex *bi);
+XJSSize xjs_block_index_records(const XJSBlockIndex *bi);
+XJSSize xjs_block_index_save(const XJSBlockIndex *bi, void *buf, XJSSize size);
+int xjs_block_index_load(XJSBlockIndex **bi, const void *buf, XJSSize len, XJSMemCB mem_cb);
+
+int xjs_parser_block(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  const XJSBlockIndex *bi, /* IN : Index of the document */
+  XJSSize rec,           /* IN : The first record to parse (0 based) */
+  XJSSize count,         /* IN : Records to parse, 0 for all the rest */
+  void *parent,          /* IN : Parent for the records, as if set by the block's callback */
+  XJSSize *offset);      /* OUT: Where in the document the input must start */
+#endif
+
+#ifdef XJS_CFLAG_ENABLE_STATS
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_stats (XJS_CFLAG_ENABLE_STATS) clears *stats and
+** has the parser count into it from then on, until the parser is freed or
+** stats is set to NULL. The times are cycles (the TSC) on x86 with GCC or
+** Clang, otherwise clock() ticks; parse_ticks is the time in xjs_feed,
+** xjs_finish and xjs_parser_parse less the time in the callbacks.
+**
+** Returns XJS_OK.
+** ---------------------------------------------------------------------------
+*/
+typedef struct
+{ XJSSize bytes;          /* input the parser went through */
+  XJSSize arrays, objects, numbers, strings, trues, falses, nulls; /* nodes signaled by kind (an end counts with its container) */
+  XJSSize names, docs;    /* XJS_name (block headers), XJS_document_end */
+  XJSSize blocks, headers, records; /* XJS_block, XJS_block_header, XJS_block_array */
+  XJSSize allocs, reallocs, frees; /* requests to the memory manager (or the arena) */
+  XJSSize alloc_bytes;    /* bytes asked for by allocs and reallocs */
+  XJSSize grows;          /* token storage that had to grow (a token longer than its storage, or across input buffers) */
+  XJSSize inputs;         /* calls to the input callback */
+  XJSSize longest;        /* the longest string value, in bytes as signaled */
+  int max_depth;          /* the deepest nesting */
+  unsigned long long cb_ticks;    /* time in the node, number and column callbacks */
+  unsigned long long parse_ticks; /* time in the parser outside them */
+} XJSStats;
+
+int xjs_parser_stats(XJSParser *parser, XJSStats *stats);
+#endif
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_elements makes the input the elements of an array
+** instead of a document: a list of values separated by commas, without the
+** brackets, from element number first (from 0) on. The array itself is not
+** signaled, its elements are signaled like the elements of any array (a
+** NULL parent, and their position as the name with XJSNodeCB). With first
+** 0 the list may be empty, otherwise it follows a comma and there must be
+** an element. Parsers started at different elements can take disjoint
+** parts of one large array (xjs_par). Call it before the first xjs_feed or
+** xjs_parser_parse, not with XJS_OPT_SEQ.
+**
+** Returns XJS_OK, XJS_ERR_USAGE if the parse has started, or
+** XJS_ERR_MEM_ALLOC.
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_elements(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  XJSSize first);        /* IN : Number of the first element */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_parse parses a whole document with the parser's
+** callbacks and limits, the input is like xjs_parse_n. A parser runs one
+** parse, either this or xjs_feed.
+**
+** Returns XJS_OK or an error code defined above.
+** ---------------------------------------------------------------------------
+*/
+int xjs_parser_parse(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  const char *json,      /* IN : Start of the input, or NULL to get it all from inp_cb */
+  XJSSize len,           /* IN : Number of bytes at json */
+  XJSInputNCB inp_cb,    /* IN : Optional input callback for more input */
+  void *inp_arg,         /* IN : Parameter passed to inp_cb */
+  const char **errpos);  /* OUT: NULL if successful, otherwise pointer to input when an error occurred */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_feed parses the next piece of the input, [json,json+len).
+** The piece can end anywhere, even inside a token. After an error the
+** parser stops, and every later call returns the same error.
+**
+** Returns XJS_MORE if the document is not complete yet, XJS_OK if it is
+** (only white space may follow), or an error code defined above.
+** ---------------------------------------------------------------------------
+*/
+int xjs_feed(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  const char *json,      /* IN : Next piece of the input (need not be null terminated) */
+  XJSSize len,           /* IN : Number of bytes at json */
+  const char **errpos);  /* OUT: Can be NULL, otherwise set to the position in json when an error occurred */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_finish ends the input. A document that is still open is
+** an error (like the end of the input for xjs_parse).
+**
+** Returns XJS_OK or an error code defined above.
+** ---------------------------------------------------------------------------
+*/
+int xjs_finish(
+  XJSParser *parser,     /* IN : Parser from xjs_parser_new */
+  const char **errpos);  /* OUT: Can be NULL, otherwise set to the end of the last piece on error */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_parser_free releases the parser and everything it holds,
+** it can be called at any time (also to abandon a parse).
+** ---------------------------------------------------------------------------
+*/
+void xjs_parser_free(XJSParser *parser);
+
+/*
+** ---------------------------------------------------------------------------
+** Arena. Without a memory manager callback the parser allocates from an
+** arena: storage is bumped out of chunks from libc that double in size,
+** and the last allocation is grown or given back in place, so the strings
+** the parser collects and frees one after the other reuse the same bytes.
+** xjs_parse and friends use one for the call (its first chunk is on the C
+** stack), a push parser has its own. A caller's arena set on a parser with
+** xjs_parser_arena is kept warm across parses: xjs_arena_reset releases
+** everything allocated from it but keeps its chunks.
+**
+** xjs_arena_new    - a new empty arena, chunk_size is the first chunk (0 for 4 KB)
+** xjs_arena_alloc  - storage from the arena (aligned for any type), callbacks can
+**                    build their own nodes in it
+** xjs_arena_reset  - release all the storage, keep the chunks
+** xjs_arena_free   - release the arena and its chunks
+** xjs_parser_arena - the parser allocates from arena (NULL for its own) instead
+**                    of its memory manager, call it before the parse starts.
+**                    Returns XJS_OK, or XJS_ERR_USAGE if the parse has started.
+**
+** Not available if XJS_CFLAG_DISABLE_MEM_FALLBACK is defined.
+** ---------------------------------------------------------------------------
+*/
+typedef struct XJSArena XJSArena; /* opaque, from xjs_arena_new */
+
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+XJSArena *xjs_arena_new(XJSSize chunk_size);
+void *xjs_arena_alloc(XJSArena *arena, XJSSize size);
+void xjs_arena_reset(XJSArena *arena);
+void xjs_arena_free(XJSArena *arena);
+int xjs_parser_arena(XJSParser *parser, XJSArena *arena);
+#endif
+
 /*
 ** ---------------------------------------------------------------------------
 ** Public API: Description functions return english descriptions. 
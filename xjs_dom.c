@@ -0,0 +1,361 @@
+/* ---------------------------------------------------------------------------
+** xjs_dom is an optional document builder for xjs
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+** Permission to use, copy, modify, and/or distribute this software for any
+** purpose with or without fee is hereby granted.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+** THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+** Also offered with MIT License.
+** ---------------------------------------------------------------------------
+*/
+
+#include "xjs_dom.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#if !defined(NULL)
+#define NULL ((void*)0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+** ---------------------------------------------------------------------------
+** The tape. Every word has a tag in its top byte and a 56 bit payload:
+**
+**   'r'  root, first and last word, the first holds the tape length
+**   '{'  object, holds the place after its '}', the next word its count
+**   '['  array, the same with ']'
+**   '}'  ']'  end of a container, holds the place of its open word
+**   'k'  member name, holds its offset in the pool, the value follows
+**   '"'  string, holds its offset in the pool
+**   'l'  integer, holds the XJSNumber flags, the next word is the value
+**   'd'  double, holds the flags and kind << 8, the next word is the value
+**   't'  'f'  'n'  true, false, null
+**
+** A pool entry is the length (an XJSSize) followed by the bytes and a null.
+** While a container is being built its open word holds the place of the
+** container around it and its count word the count of that one, so the
+** builder needs no stack of its own.
+** ---------------------------------------------------------------------------
+*/
+typedef unsigned long long IXJSDomWord;
+
+#define IXJS_DOM_TAG(w)     ((int)((w)>>56))
+#define IXJS_DOM_VAL(w)     ((XJSSize)((w)&0x00FFFFFFFFFFFFFFULL))
+#define IXJS_DOM_WORD(t,v)  (((IXJSDomWord)(t)<<56)|(IXJSDomWord)(v))
+
+/* IXJS_DOM_TAPE_SIZE, IXJS_DOM_POOL_SIZE - first sizes when the input length is not known */
+#define IXJS_DOM_TAPE_SIZE  1024
+#define IXJS_DOM_POOL_SIZE  4096
+
+struct XJSDom
+{ XJSMemCB mem_cb;
+  IXJSDomWord *tape; XJSSize n, tsz;  /* words used and allocated */
+  char *pool; XJSSize pn, psz;        /* bytes used and allocated */
+  XJSSize open, cnt;                  /* while building: the open container and its count so far */
+  int hdr;                            /* while building: in a block header */
+};
+
+static int i_dom_node(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *node_arg);
+static int i_dom_number(void **parent, const char *name, XJSSize name_len, const char *text, XJSSize text_len, const XJSNumber *num, void *node_arg);
+static int i_dom_begin(XJSDom *d, const char *name, XJSSize name_len);
+static int i_dom_open(XJSDom *d, int tag);
+static int i_dom_close(XJSDom *d);
+static int i_dom_tape(XJSDom *d, XJSSize k);
+static int i_dom_str(XJSDom *d, int tag, const char *s, XJSSize n);
+static XJSSize i_dom_after(const XJSDom *d, XJSSize i);
+static const char *i_dom_pool(const XJSDom *d, XJSSize i, XJSSize *len);
+
+/*
+** Default memory management using libc malloc/free/realloc, like the parser's.
+** ---------------------------------------------------------------------------
+*/
+#ifdef XJS_CFLAG_DISABLE_MEM_FALLBACK
+static XJSMemCB i_dom_mem = NULL;
+#else
+static void *i_dom_mem(XJSMemReq action, XJSType context, void *prev, XJSSize size, XJSSize *actsz)
+{ void *ret=NULL; if (actsz) *actsz=0;
+  if (action==XJS_free) free(prev);
+  else if (action==XJS_alloc)
+  { if (prev) ret=realloc(prev, size);
+    else ret=malloc(size);
+  }
+  if ((ret)&&(actsz)) *actsz=size;
+  return ret;
+}
+#endif
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_dom_parse(XJSDom **dom, const char *json, XJSSize len, XJSInputNCB inp_cb, void *inp_arg, XJSMemCB mem_cb, const char **errpos)
+{ XJSDom *d; XJSParser *p; XJSMemCB m=(mem_cb)?mem_cb:i_dom_mem; XJSSize actsz=0; int r;
+  if (dom==NULL) return XJS_ERR_USAGE;
+  *dom=NULL; if (errpos) *errpos=NULL;
+  if (m==NULL) return XJS_ERR_MEM_MISSING;
+  if ((d=(XJSDom*)m(XJS_alloc, XJS_dom, NULL, sizeof(XJSDom), &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+  memset(d, 0, sizeof(XJSDom)); d->mem_cb=m;
+  if ((p=xjs_parser_new_view(i_dom_node, d, mem_cb))==NULL) { xjs_dom_free(d); return XJS_ERR_MEM_ALLOC; }
+  xjs_parser_numbers(p, i_dom_number);
+  xjs_parser_options(p, XJS_OPT_DECODE);
+  r=i_dom_tape(d, (json)?len/4+16:IXJS_DOM_TAPE_SIZE); // a word for every 4 bytes of compact input is plenty
+  if (r==XJS_OK) { d->tape[d->n++]=IXJS_DOM_WORD('r', 0); d->open=0; d->cnt=0; }
+  if (r==XJS_OK) r=xjs_parser_parse(p, json, len, inp_cb, inp_arg, errpos);
+  xjs_parser_free(p);
+  if ((r==XJS_OK)&&((r=i_dom_tape(d, 1))==XJS_OK))
+  { d->tape[d->n++]=IXJS_DOM_WORD('r', 0);
+    d->tape[0]=IXJS_DOM_WORD('r', d->n);
+  }
+  if (r!=XJS_OK) { xjs_dom_free(d); return r; }
+  *dom=d;
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_dom_free(XJSDom *dom)
+{ if (dom==NULL) return;
+  if (dom->tape) dom->mem_cb(XJS_free, XJS_dom, dom->tape, 0, NULL);
+  if (dom->pool) dom->mem_cb(XJS_free, XJS_dom, dom->pool, 0, NULL);
+  dom->mem_cb(XJS_free, XJS_dom, dom, 0, NULL);
+}
+
+/* ---------------------------------------------------------------------------
+** Building. The parser's callbacks append to the tape, every value is
+** counted in its container and a member's name goes in front of it.
+** ---------------------------------------------------------------------------
+*/
+static int i_dom_node(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *node_arg)
+{ XJSDom *d=(XJSDom*)node_arg; int r;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if (kind==XJS_block_header) { d->hdr=1; return XJS_OK; }
+  if (d->hdr) { if (kind==XJS_block_header_end) d->hdr=0; return XJS_OK; } // the names are passed with the cells
+#endif
+  switch (kind)
+  { case XJS_array_end: case XJS_object_end:
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    case XJS_block_end: case XJS_block_array_end:
+#endif
+      return i_dom_close(d);
+    default: break;
+  }
+  if ((r=i_dom_begin(d, name, name_len))!=XJS_OK) return r;
+  switch (kind)
+  { case XJS_array:
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    case XJS_block: // an array of records
+#endif
+      return i_dom_open(d, '[');
+    case XJS_object:
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    case XJS_block_array: // a record, an object with the header's names
+#endif
+      return i_dom_open(d, '{');
+    case XJS_string: return i_dom_str(d, '"', value, value_len);
+    case XJS_true:  if ((r=i_dom_tape(d, 1))==XJS_OK) d->tape[d->n++]=IXJS_DOM_WORD('t', 0); return r;
+    case XJS_false: if ((r=i_dom_tape(d, 1))==XJS_OK) d->tape[d->n++]=IXJS_DOM_WORD('f', 0); return r;
+    case XJS_null:  if ((r=i_dom_tape(d, 1))==XJS_OK) d->tape[d->n++]=IXJS_DOM_WORD('n', 0); return r;
+    default: return XJS_ERR_USAGE; // numbers go to i_dom_number
+  }
+}
+
+static int i_dom_number(void **parent, const char *name, XJSSize name_len, const char *text, XJSSize text_len, const XJSNumber *num, void *node_arg)
+{ XJSDom *d=(XJSDom*)node_arg; IXJSDomWord w; int r;
+  if ((r=i_dom_begin(d, name, name_len))!=XJS_OK) return r;
+  if ((r=i_dom_tape(d, 2))!=XJS_OK) return r;
+  if ((num->kind==XJS_NUM_INT)&&(!(num->flags&XJS_NUMF_RANGE)))
+  { d->tape[d->n++]=IXJS_DOM_WORD('l', num->flags); memcpy(&w, &num->i, sizeof(w)); }
+  else { d->tape[d->n++]=IXJS_DOM_WORD('d', num->flags|(num->kind<<8)); memcpy(&w, &num->d, sizeof(w)); }
+  d->tape[d->n++]=w;
+  return XJS_OK;
+}
+
+static int i_dom_begin(XJSDom *d, const char *name, XJSSize name_len)
+{ d->cnt++;
+  if (IXJS_DOM_TAG(d->tape[d->open])!='{') return XJS_OK; // array positions are not kept
+  return i_dom_str(d, 'k', name, name_len);
+}
+
+static int i_dom_open(XJSDom *d, int tag)
+{ int r;
+  if ((r=i_dom_tape(d, 2))!=XJS_OK) return r;
+  d->tape[d->n]=IXJS_DOM_WORD(tag, d->open); d->tape[d->n+1]=d->cnt; // the container around it, until it ends
+  d->open=d->n; d->cnt=0; d->n+=2;
+  return XJS_OK;
+}
+
+static int i_dom_close(XJSDom *d)
+{ XJSSize o=d->open; IXJSDomWord w=d->tape[o]; int r, tag=IXJS_DOM_TAG(w);
+  if ((r=i_dom_tape(d, 1))!=XJS_OK) return r;
+  d->tape[d->n++]=IXJS_DOM_WORD((tag=='{')?'}':']', o);
+  d->open=IXJS_DOM_VAL(w);
+  d->tape[o]=IXJS_DOM_WORD(tag, d->n);
+  w=d->tape[o+1]; d->tape[o+1]=d->cnt; d->cnt=(XJSSize)w;
+  return XJS_OK;
+}
+
+/* Make room for k more words on the tape. */
+static int i_dom_tape(XJSDom *d, XJSSize k)
+{ IXJSDomWord *t; XJSSize sz, actsz=0;
+  if ((d->n+k)<=d->tsz) return XJS_OK;
+  sz=(d->tsz)?d->tsz*2:k; if (sz<(d->n+k)) sz=d->n+k;
+  if ((t=(IXJSDomWord*)d->mem_cb(XJS_alloc, XJS_dom, d->tape, sz*sizeof(IXJSDomWord), &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+  d->tape=t; d->tsz=actsz/sizeof(IXJSDomWord);
+  return ((d->n+k)<=d->tsz)?XJS_OK:XJS_ERR_MEM_ALLOC;
+}
+
+/* Append [s,s+n) to the pool and its word to the tape. */
+static int i_dom_str(XJSDom *d, int tag, const char *s, XJSSize n)
+{ char *p; XJSSize want=d->pn+sizeof(XJSSize)+n+1, sz, actsz=0; int r;
+  if ((r=i_dom_tape(d, 1))!=XJS_OK) return r;
+  if (want>d->psz)
+  { sz=(d->psz)?d->psz*2:IXJS_DOM_POOL_SIZE; if (sz<want) sz=want;
+    if ((p=(char*)d->mem_cb(XJS_alloc, XJS_dom, d->pool, sz, &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+    d->pool=p; d->psz=actsz;
+    if (want>d->psz) return XJS_ERR_MEM_ALLOC;
+  }
+  p=d->pool+d->pn; memcpy(p, &n, sizeof(XJSSize));
+  if (n) memcpy(p+sizeof(XJSSize), s, n);
+  p[sizeof(XJSSize)+n]=0;
+  d->tape[d->n++]=IXJS_DOM_WORD(tag, d->pn);
+  d->pn=want;
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** Access. i_dom_after is the place after the value at i, one step for a
+** whole container.
+** ---------------------------------------------------------------------------
+*/
+static XJSSize i_dom_after(const XJSDom *d, XJSSize i)
+{ IXJSDomWord w=d->tape[i];
+  switch (IXJS_DOM_TAG(w))
+  { case '{': case '[': return IXJS_DOM_VAL(w);
+    case 'l': case 'd': return i+2;
+    default: return i+1;
+  }
+}
+
+static const char *i_dom_pool(const XJSDom *d, XJSSize i, XJSSize *len)
+{ const char *p=d->pool+IXJS_DOM_VAL(d->tape[i]); XJSSize n;
+  memcpy(&n, p, sizeof(XJSSize));
+  if (len) *len=n;
+  return p+sizeof(XJSSize);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTIONS
+** ---------------------------------------------------------------------------
+*/
+XJSDomVal xjs_dom_root(const XJSDom *dom)
+{ XJSDomVal v; v.dom=dom; v.k=0;
+  v.i=((dom)&&(dom->n>2))?1:0;
+  return v;
+}
+
+XJSType xjs_dom_type(XJSDomVal v)
+{ if (v.i==0) return XJS_unknown;
+  switch (IXJS_DOM_TAG(v.dom->tape[v.i]))
+  { case '{': return XJS_object;
+    case '[': return XJS_array;
+    case '"': return XJS_string;
+    case 'l': case 'd': return XJS_number;
+    case 't': return XJS_true;
+    case 'f': return XJS_false;
+    case 'n': return XJS_null;
+    default: return XJS_unknown;
+  }
+}
+
+XJSSize xjs_dom_count(XJSDomVal v)
+{ int tag;
+  if (v.i==0) return 0;
+  tag=IXJS_DOM_TAG(v.dom->tape[v.i]);
+  return ((tag=='{')||(tag=='['))?(XJSSize)v.dom->tape[v.i+1]:0;
+}
+
+XJSDomVal xjs_dom_first(XJSDomVal v)
+{ XJSDomVal e; int tag; e.dom=v.dom; e.i=e.k=0;
+  if (v.i==0) return e;
+  tag=IXJS_DOM_TAG(v.dom->tape[v.i]);
+  if ((tag=='[')&&(IXJS_DOM_TAG(v.dom->tape[v.i+2])!=']')) e.i=v.i+2;
+  else if ((tag=='{')&&(IXJS_DOM_TAG(v.dom->tape[v.i+2])=='k')) { e.k=v.i+2; e.i=v.i+3; }
+  return e;
+}
+
+XJSDomVal xjs_dom_next(XJSDomVal v)
+{ XJSDomVal e; XJSSize j; int tag; e.dom=v.dom; e.i=e.k=0;
+  if (v.i==0) return e;
+  j=i_dom_after(v.dom, v.i); tag=IXJS_DOM_TAG(v.dom->tape[j]);
+  if (tag=='k') { e.k=j; e.i=j+1; }
+  else if ((tag!='}')&&(tag!=']')&&(tag!='r')) e.i=j;
+  return e;
+}
+
+XJSDomVal xjs_dom_get(XJSDomVal v, const char *name, XJSSize name_len)
+{ XJSDomVal e; const char *k; XJSSize n;
+  if ((v.i==0)||(IXJS_DOM_TAG(v.dom->tape[v.i])!='{')) { e.dom=v.dom; e.i=e.k=0; return e; }
+  for (e=xjs_dom_first(v); e.i; e=xjs_dom_next(e))
+  { k=i_dom_pool(v.dom, e.k, &n);
+    if ((n==name_len)&&((n==0)||(memcmp(k, name, n)==0))) return e;
+  }
+  return e;
+}
+
+XJSDomVal xjs_dom_at(XJSDomVal v, XJSSize index)
+{ XJSDomVal e=xjs_dom_first(v);
+  if (index>=xjs_dom_count(v)) { e.i=e.k=0; return e; }
+  while ((index--)&&(e.i)) e=xjs_dom_next(e);
+  return e;
+}
+
+const char *xjs_dom_key(XJSDomVal v, XJSSize *len)
+{ if (len) *len=0;
+  if ((v.i==0)||(v.k==0)) return NULL;
+  return i_dom_pool(v.dom, v.k, len);
+}
+
+const char *xjs_dom_str(XJSDomVal v, XJSSize *len)
+{ if (len) *len=0;
+  if ((v.i==0)||(IXJS_DOM_TAG(v.dom->tape[v.i])!='"')) return NULL;
+  return i_dom_pool(v.dom, v.i, len);
+}
+
+int xjs_dom_num(XJSDomVal v, XJSNumber *num)
+{ IXJSDomWord w; int tag;
+  if (v.i==0) return XJS_NOPE;
+  w=v.dom->tape[v.i]; tag=IXJS_DOM_TAG(w);
+  if (tag=='l')
+  { num->kind=XJS_NUM_INT; num->flags=(int)(IXJS_DOM_VAL(w)&0xFF);
+    memcpy(&num->i, &v.dom->tape[v.i+1], sizeof(num->i)); num->d=(double)num->i;
+  }
+  else if (tag=='d')
+  { num->kind=(int)((IXJS_DOM_VAL(w)>>8)&0xFF); num->flags=(int)(IXJS_DOM_VAL(w)&0xFF);
+    num->i=0; memcpy(&num->d, &v.dom->tape[v.i+1], sizeof(num->d));
+  }
+  else return XJS_NOPE;
+  return XJS_OK;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/* EOF */
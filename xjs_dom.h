@@ -0,0 +1,125 @@
+/* ---------------------------------------------------------------------------
+** xjs_dom is an optional document builder for xjs
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+** Permission to use, copy, modify, and/or distribute this software for any
+** purpose with or without fee is hereby granted.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+** THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+** Also offered with MIT License.
+** ---------------------------------------------------------------------------
+** # xjs_dom
+**
+** **xjs_dom** records a parse into a tape, one array of 64 bit words for the
+** whole document, instead of a tree of nodes. Strings and names are copied
+** (with their escapes decoded) into a string pool next to it. The tape and
+** the pool are each one buffer from the memory manager (`XJS_dom`), grown
+** by doubling, so a document is a handful of allocations however many
+** values it holds.
+**
+** Each container on the tape stores where it ends, so a whole subtree is
+** skipped in one step, and how many elements or members it has. Values are
+** visited with a `XJSDomVal`, a small handle that is passed by value:
+**
+** ```
+** XJSDom *d; XJSDomVal v; XJSNumber n;
+** if (xjs_dom_parse(&d, json, len, NULL, NULL, NULL, &err)==XJS_OK)
+** { for (v=xjs_dom_first(xjs_dom_root(d)); xjs_dom_valid(v); v=xjs_dom_next(v))
+**     if (xjs_dom_num(xjs_dom_get(v, "id", 2), &n)==XJS_OK) use_id(n.i);
+** }
+** xjs_dom_free(d);
+** ```
+**
+** Blocks (`XJS_CFLAG_ENABLE_BLOCKS`) are recorded as an array of objects,
+** the header names become the member names of each record.
+** ---------------------------------------------------------------------------
+*/
+#ifndef __XJS_DOM_H__
+#define __XJS_DOM_H__
+
+#include "xjs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct XJSDom XJSDom; /* opaque, from xjs_dom_parse */
+
+/*
+** A value in a document. i is its place on the tape, 0 for no value (what
+** the accessors return past the end, or for a missing member). k is the
+** place of its name if it is an object member, otherwise 0.
+*/
+typedef struct
+{ const XJSDom *dom;
+  XJSSize i;
+  XJSSize k;
+} XJSDomVal;
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_dom_parse parses a document into a new XJSDom. The input
+** is like xjs_parse_n. Numbers are decoded (like xjs_number) and strings
+** have their escapes decoded (like XJS_OPT_DECODE).
+**
+** Returns XJS_OK and sets *dom, or an error code from xjs.h (*dom is NULL).
+** ---------------------------------------------------------------------------
+*/
+int xjs_dom_parse(
+  XJSDom **dom,          /* OUT: The document, free it with xjs_dom_free */
+  const char *json,      /* IN : Input (need not be null terminated), or NULL to use inp_cb prior to parsing */
+  XJSSize len,           /* IN : Number of bytes at json */
+  XJSInputNCB inp_cb,    /* IN : Request for input, can be NULL if json contains all the input */
+  void *inp_arg,         /* IN : Parameter passed to inp_cb */
+  XJSMemCB mem_cb,       /* IN : Optional memory manager callback (NULL for libc)   */
+  const char **errpos);  /* OUT: NULL if successful, otherwise pointer to input when an error occurred */
+
+void xjs_dom_free(XJSDom *dom);
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: accessors. They take any XJSDomVal, a value of the wrong kind
+** or no value gives no value (or 0, NULL) back, so calls can be chained.
+**
+** xjs_dom_root    - the top level value of the document
+** xjs_dom_type    - XJS_object, XJS_array, XJS_string, XJS_number, XJS_true,
+**                   XJS_false, XJS_null, or XJS_unknown for no value
+** xjs_dom_count   - the number of elements or members of a container
+** xjs_dom_first   - the first element or member value of a container
+** xjs_dom_next    - the next element or member value, a container is
+**                   skipped in one step
+** xjs_dom_get     - the value of an object member by name (a linear search)
+** xjs_dom_at      - the element at an index (skips the ones before it)
+** xjs_dom_key     - the name of a member value (null terminated)
+** xjs_dom_str     - the text of a string (null terminated, may contain \0)
+** xjs_dom_num     - a number, returns XJS_OK or XJS_NOPE if v is not one
+** ---------------------------------------------------------------------------
+*/
+XJSDomVal xjs_dom_root(const XJSDom *dom);
+XJSType xjs_dom_type(XJSDomVal v);
+XJSSize xjs_dom_count(XJSDomVal v);
+XJSDomVal xjs_dom_first(XJSDomVal v);
+XJSDomVal xjs_dom_next(XJSDomVal v);
+XJSDomVal xjs_dom_get(XJSDomVal v, const char *name, XJSSize name_len);
+XJSDomVal xjs_dom_at(XJSDomVal v, XJSSize index);
+const char *xjs_dom_key(XJSDomVal v, XJSSize *len);
+const char *xjs_dom_str(XJSDomVal v, XJSSize *len);
+int xjs_dom_num(XJSDomVal v, XJSNumber *num);
+
+#define xjs_dom_valid(v) ((v).i!=0)
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __XJS_DOM_H__
+
+/* EOF */
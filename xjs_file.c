@@ -0,0 +1,326 @@
+/* ---------------------------------------------------------------------------
+** xjs_file is an optional file input source for xjs
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+** Permission to use, copy, modify, and/or distribute this software for any
+** purpose with or without fee is hereby granted.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+** THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+** Also offered with MIT License.
+** ---------------------------------------------------------------------------
+*/
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "xjs_file.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#if !defined(NULL)
+#define NULL ((void*)0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* IXJS_FILE_BUF - the size of the read buffer when xjs_file_open is not given one */
+#define IXJS_FILE_BUF   (1024*1024)
+
+/* IXJS_FILE_DEPTH - the buffers xjs_file_ahead reads into when it is not given a number, IXJS_FILE_DEPTH_MAX the most */
+#define IXJS_FILE_DEPTH      4
+#define IXJS_FILE_DEPTH_MAX  64
+
+/* the ring is shared by the reader thread and the parser without a lock, the lock is only to sleep on */
+#define IXJS_LOAD(p)     __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define IXJS_STORE(p,v)  __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+
+typedef struct
+{ char *buf;            /* f->size bytes */
+  XJSSize len;          /* bytes read into it */
+  int st;               /* XJS_OK, XJS_END (nothing was read) or XJS_ERR_IO */
+} IXJSFileSlot;
+
+struct XJSFile
+{ XJSMemCB mem_cb;
+  int fd, own;          /* the descriptor, closed by xjs_file_free if own */
+  int reg;              /* a regular file: reads fill the buffer */
+  int mapped;           /* map is the whole file (len bytes) */
+  const char *map; XJSSize len;
+  char *mem, *buf;      /* the read buffer (or the ring), buf is mem aligned to a page */
+  XJSSize size, page;   /* bytes per buffer, a multiple of page */
+  int used, done, err;  /* the input was asked for, the end of the file was passed on, the read error */
+  /* xjs_file_ahead */
+  int depth;            /* buffers in the ring, 0 without a reader thread */
+  IXJSFileSlot *ring;
+  XJSSize wr, rd;       /* buffers the reader has filled, the parser has released (atomic) */
+  int held;             /* the parser has the buffer at rd */
+  int wait_r, wait_p;   /* the reader (ring full) or the parser (ring empty) sleeps on cv (atomic) */
+  int stop;             /* the reader is to stop (atomic) */
+  pthread_t th; pthread_mutex_t mx; pthread_cond_t cv;
+};
+
+static int i_file_new(XJSFile **file, int fd, int own, XJSSize bufsize, int flags, XJSMemCB mem_cb);
+static int i_file_map(XJSFile *f, const struct stat *sb);
+static int i_file_read(XJSFile *f, char *b, XJSSize *n);
+static int i_file_next(XJSFile *f, const char **input, XJSSize *len);
+static void *i_file_reader(void *arg);
+static void i_file_wake(XJSFile *f);
+
+/*
+** Default memory management using libc malloc/free/realloc, like the parser's.
+** ---------------------------------------------------------------------------
+*/
+#ifdef XJS_CFLAG_DISABLE_MEM_FALLBACK
+static XJSMemCB i_file_mem = NULL;
+#else
+static void *i_file_mem(XJSMemReq action, XJSType context, void *prev, XJSSize size, XJSSize *actsz)
+{ void *ret=NULL; if (actsz) *actsz=0;
+  if (action==XJS_free) free(prev);
+  else if (action==XJS_alloc)
+  { if (prev) ret=realloc(prev, size);
+    else ret=malloc(size);
+  }
+  if ((ret)&&(actsz)) *actsz=size;
+  return ret;
+}
+#endif
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_file_open(XJSFile **file, const char *path, XJSSize bufsize, int flags, XJSMemCB mem_cb)
+{ int fd, r;
+  *file=NULL;
+  if ((path==NULL)||(flags&~XJS_FILE_READ)) return XJS_ERR_USAGE;
+  if ((fd=open(path, O_RDONLY))<0) return XJS_ERR_IO;
+  if ((r=i_file_new(file, fd, 1, bufsize, flags, mem_cb))!=XJS_OK) close(fd);
+  return r;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_file_fd(XJSFile **file, int fd, XJSSize bufsize, int flags, XJSMemCB mem_cb)
+{ *file=NULL;
+  if ((fd<0)||(flags&~XJS_FILE_READ)) return XJS_ERR_USAGE;
+  return i_file_new(file, fd, 0, bufsize, flags, mem_cb);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_file_free(XJSFile *file)
+{ if (file==NULL) return;
+  if (file->depth) // a read in progress is finished first
+  { IXJS_STORE(&file->stop, 1); i_file_wake(file);
+    pthread_join(file->th, NULL);
+    pthread_cond_destroy(&file->cv); pthread_mutex_destroy(&file->mx);
+  }
+  if ((file->mapped)&&(file->len)) munmap((void*)file->map, (size_t)file->len);
+  if (file->mem) file->mem_cb(XJS_free, XJS_file, file->mem, 0, NULL);
+  if (file->own) close(file->fd);
+  file->mem_cb(XJS_free, XJS_file, file, 0, NULL);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK, XJS_END or XJS_ERR_IO
+** ---------------------------------------------------------------------------
+*/
+int xjs_file_input(const char **input, XJSSize *len, void *inp_arg)
+{ XJSFile *f=(XJSFile*)inp_arg; XJSSize n=0;
+  *input=NULL; *len=0; f->used=1;
+  if (f->err) return f->err;
+  if (f->done) return XJS_END;
+  if (f->mapped) { f->done=1; *input=f->map; *len=f->len; return (f->len)?XJS_OK:XJS_END; }
+  if (f->depth) return i_file_next(f, input, len);
+  if ((f->err=i_file_read(f, f->buf, &n))!=XJS_OK) return f->err;
+  if (n==0) { f->done=1; return XJS_END; }
+  *input=f->buf; *len=n;
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_file_ahead(XJSFile *file, int depth)
+{ XJSFile *f=file; char *mem, *base; XJSSize actsz=0; int i;
+  if (f->mapped) return XJS_OK; // the kernel reads ahead of a mapping
+  if (depth==0) depth=IXJS_FILE_DEPTH;
+  if ((f->depth)||(f->used)||(depth<2)||(depth>IXJS_FILE_DEPTH_MAX)) return XJS_ERR_USAGE;
+  if ((mem=(char*)f->mem_cb(XJS_alloc, XJS_file, NULL, (XJSSize)depth*(f->size+sizeof(IXJSFileSlot))+f->page, &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+  base=mem+((f->page-(XJSSize)((unsigned long)mem%f->page))%f->page);
+  f->ring=(IXJSFileSlot*)(base+(XJSSize)depth*f->size); // after the buffers, which are whole pages
+  for (i=0; i<depth; i++) { f->ring[i].buf=base+(XJSSize)i*f->size; f->ring[i].len=0; f->ring[i].st=XJS_OK; }
+  f->wr=f->rd=0; f->held=f->wait_r=f->wait_p=f->stop=0; f->depth=depth;
+  if ((pthread_mutex_init(&f->mx, NULL)!=0)||(pthread_cond_init(&f->cv, NULL)!=0)||(pthread_create(&f->th, NULL, i_file_reader, f)!=0))
+  { f->depth=0; f->ring=NULL;
+    f->mem_cb(XJS_free, XJS_file, mem, 0, NULL);
+    return XJS_ERR;
+  }
+  f->mem_cb(XJS_free, XJS_file, f->mem, 0, NULL); // the ring replaces the buffer
+  f->mem=mem; f->buf=NULL;
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_file_parse(XJSFile *file, XJSParser *parser, const char **errpos)
+{ if (file->mapped) { file->done=1; return xjs_parser_parse(parser, file->map, file->len, NULL, NULL, errpos); }
+  return xjs_parser_parse(parser, NULL, 0, xjs_file_input, file, errpos);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns the mapped file or NULL
+** ---------------------------------------------------------------------------
+*/
+const char *xjs_file_data(const XJSFile *file, XJSSize *len)
+{ if (len) *len=(file->mapped)?file->len:0;
+  return (file->mapped)?file->map:NULL;
+}
+
+/*
+** Make the file for fd: mapped if it can be, otherwise with a read buffer
+** of whole pages that starts on a page.
+*/
+static int i_file_new(XJSFile **file, int fd, int own, XJSSize bufsize, int flags, XJSMemCB mem_cb)
+{ XJSFile *f; XJSMemCB m=(mem_cb)?mem_cb:i_file_mem; XJSSize actsz=0, page; struct stat sb; long ps;
+  if (m==NULL) return XJS_ERR_MEM_MISSING;
+  if (fstat(fd, &sb)!=0) return XJS_ERR_IO;
+  if ((f=(XJSFile*)m(XJS_alloc, XJS_file, NULL, sizeof(XJSFile), &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+  memset(f, 0, sizeof(XJSFile));
+  f->mem_cb=m; f->fd=fd; f->own=own; f->reg=S_ISREG(sb.st_mode);
+  if ((f->reg)&&(!(flags&XJS_FILE_READ))&&(i_file_map(f, &sb))) { *file=f; return XJS_OK; }
+  f->page=page=((ps=sysconf(_SC_PAGESIZE))>0)?(XJSSize)ps:4096;
+  if (bufsize==0) bufsize=IXJS_FILE_BUF;
+  bufsize=(bufsize+page-1)/page*page;
+  if ((f->mem=(char*)m(XJS_alloc, XJS_file, NULL, bufsize+page, &actsz))==NULL) { f->mem_cb(XJS_free, XJS_file, f, 0, NULL); return XJS_ERR_MEM_ALLOC; }
+  f->buf=f->mem+((page-(XJSSize)((unsigned long)f->mem%page))%page);
+  f->size=bufsize;
+#if defined(POSIX_FADV_SEQUENTIAL)
+  if (f->reg) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL); // a hint, it may fail
+#endif
+  *file=f;
+  return XJS_OK;
+}
+
+/* Map the regular file f from its start, returns 0 if it is not mapped. */
+static int i_file_map(XJSFile *f, const struct stat *sb)
+{ void *m;
+  if ((sb->st_size<0)||((unsigned long long)sb->st_size>(unsigned long long)(size_t)-1)) return 0;
+  if (lseek(f->fd, 0, SEEK_CUR)!=0) return 0; // read from where the descriptor is
+  if (sb->st_size==0) { f->mapped=1; f->map=""; f->len=0; return 1; } // mmap can't map it
+  if ((m=mmap(NULL, (size_t)sb->st_size, PROT_READ, MAP_PRIVATE, f->fd, 0))==MAP_FAILED) return 0;
+  posix_madvise(m, (size_t)sb->st_size, POSIX_MADV_SEQUENTIAL); // a hint, it may fail
+  f->mapped=1; f->map=(const char*)m; f->len=(XJSSize)sb->st_size;
+  return 1;
+}
+
+/*
+** Read the next buffer into b, *n is 0 at the end of the file. A regular
+** file fills the buffer, a pipe or socket returns what one read gives.
+*/
+static int i_file_read(XJSFile *f, char *b, XJSSize *n)
+{ ssize_t r;
+  *n=0;
+  while ((*n)<f->size)
+  { if ((r=read(f->fd, b+(*n), (size_t)(f->size-(*n))))<0)
+    { if (errno==EINTR) continue;
+      return XJS_ERR_IO;
+    }
+    if (r==0) break;
+    (*n)+=(XJSSize)r;
+    if (!f->reg) break;
+  }
+  return XJS_OK;
+}
+
+/*
+** The parser's side of the ring: release the buffer it had and take the
+** next, sleeping only while the reader is behind.
+*/
+static int i_file_next(XJSFile *f, const char **input, XJSSize *len)
+{ IXJSFileSlot *s;
+  if (f->held) // the parser is done with it (views last until the next call)
+  { f->held=0; IXJS_STORE(&f->rd, f->rd+1);
+    if (IXJS_LOAD(&f->wait_r)) i_file_wake(f);
+  }
+  if (IXJS_LOAD(&f->wr)==f->rd)
+  { pthread_mutex_lock(&f->mx); IXJS_STORE(&f->wait_p, 1);
+    while (IXJS_LOAD(&f->wr)==f->rd) pthread_cond_wait(&f->cv, &f->mx);
+    IXJS_STORE(&f->wait_p, 0); pthread_mutex_unlock(&f->mx);
+  }
+  s=f->ring+(f->rd%(XJSSize)f->depth);
+  if (s->st!=XJS_OK) { f->done=1; if (s->st!=XJS_END) f->err=s->st; return s->st; }
+  f->held=1; *input=s->buf; *len=s->len;
+  return XJS_OK;
+}
+
+/*
+** The reader thread fills the free buffers of the ring in order, until the
+** end of the file, an error, or xjs_file_free. It sleeps only while every
+** buffer is full.
+*/
+static void *i_file_reader(void *arg)
+{ XJSFile *f=(XJSFile*)arg; IXJSFileSlot *s; int st;
+  do
+  { if ((IXJS_LOAD(&f->wr)-IXJS_LOAD(&f->rd))==(XJSSize)f->depth)
+    { pthread_mutex_lock(&f->mx); IXJS_STORE(&f->wait_r, 1);
+      while (((IXJS_LOAD(&f->wr)-IXJS_LOAD(&f->rd))==(XJSSize)f->depth)&&(!IXJS_LOAD(&f->stop))) pthread_cond_wait(&f->cv, &f->mx);
+      IXJS_STORE(&f->wait_r, 0); pthread_mutex_unlock(&f->mx);
+    }
+    if (IXJS_LOAD(&f->stop)) break;
+    s=f->ring+(f->wr%(XJSSize)f->depth);
+    if (((st=i_file_read(f, s->buf, &s->len))==XJS_OK)&&(s->len==0)) st=XJS_END;
+    s->st=st;
+    IXJS_STORE(&f->wr, f->wr+1); // hands the buffer over
+    if (IXJS_LOAD(&f->wait_p)) i_file_wake(f);
+  } while (st==XJS_OK);
+  return NULL;
+}
+
+/*
+** Wake the side that sleeps. It set its flag and checked the ring under mx,
+** so taking mx here can't miss it.
+*/
+static void i_file_wake(XJSFile *f)
+{ pthread_mutex_lock(&f->mx);
+  pthread_cond_broadcast(&f->cv);
+  pthread_mutex_unlock(&f->mx);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/* EOF */
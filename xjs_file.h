@@ -0,0 +1,132 @@
+/* ---------------------------------------------------------------------------
+** xjs_file is an optional file input source for xjs
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+** Permission to use, copy, modify, and/or distribute this software for any
+** purpose with or without fee is hereby granted.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+** THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+** Also offered with MIT License.
+** ---------------------------------------------------------------------------
+** # xjs_file
+**
+** **xjs_file** gives the parser the contents of a file. A regular file is
+** mapped into memory (read only, with a hint that it is read from start to
+** end) and passed to the parser as one range, so there is no copy, no
+** null terminator and a single input callback for the whole file. Pipes,
+** sockets and terminals can't be mapped, they are read into one large
+** page aligned buffer at a time:
+**
+** ```
+** XJSFile *f; XJSParser *p=xjs_parser_new_view(nodecb, ctx, NULL);
+** if ((r=xjs_file_open(&f, "big.json", 0, 0, NULL))==XJS_OK)
+** { r=xjs_file_parse(f, p, &err);
+**   xjs_file_free(f);
+** }
+** xjs_parser_free(p);
+** ```
+**
+** `xjs_file_input` is an `XJSInputNCB`, so a file also works with
+** `xjs_parse_n`, `xjs_parse_view` and `xjs_block_index_new`. Views of the
+** input stay valid until the file is freed (mapped) or until the next
+** buffer is read.
+**
+** A file that is read can also be read ahead on a thread (`xjs_file_ahead`)
+** while the parser works on the buffer before.
+**
+** It uses POSIX (`open`, `read`, `mmap`, threads), so it is for the
+** systems that have them.
+** ---------------------------------------------------------------------------
+*/
+#ifndef __XJS_FILE_H__
+#define __XJS_FILE_H__
+
+#include "xjs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct XJSFile XJSFile; /* opaque, from xjs_file_open */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_file_open opens the file at path, xjs_file_fd uses a
+** descriptor that is already open (it is read from where it is, and not
+** closed by xjs_file_free). A regular file is mapped unless XJS_FILE_READ
+** is set or the mapping fails, anything else is read in buffers of bufsize
+** bytes (0 for 1 MB, rounded up to whole pages).
+**
+** Returns XJS_OK and sets *file, XJS_ERR_IO if the file can't be opened,
+** or XJS_ERR_MEM_ALLOC.
+** ---------------------------------------------------------------------------
+*/
+#define XJS_FILE_READ    0x01   /* read even a regular file, never map it */
+
+int xjs_file_open(
+  XJSFile **file,        /* OUT: The file, free it with xjs_file_free */
+  const char *path,      /* IN : The file */
+  XJSSize bufsize,       /* IN : Size of the read buffer, 0 for the default */
+  int flags,             /* IN : XJS_FILE_* flags or'ed together */
+  XJSMemCB mem_cb);      /* IN : Optional memory manager callback (NULL for libc) */
+
+int xjs_file_fd(
+  XJSFile **file,        /* OUT: The file, free it with xjs_file_free */
+  int fd,                /* IN : An open descriptor, e.g. 0 for stdin */
+  XJSSize bufsize,       /* IN : Size of the read buffer, 0 for the default */
+  int flags,             /* IN : XJS_FILE_* flags or'ed together */
+  XJSMemCB mem_cb);      /* IN : Optional memory manager callback (NULL for libc) */
+
+void xjs_file_free(XJSFile *file);
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_file_ahead starts a thread that reads the file ahead of
+** the parser into a ring of depth buffers (0 for 4, at most 64), so the
+** next buffer is usually there when the parser asks for it. The buffers
+** are passed between the threads without a lock, a side only sleeps when
+** the ring is full or empty. Call it before the input is first asked for.
+** A mapped file is left as it is (the kernel reads ahead of the mapping),
+** open it with XJS_FILE_READ to read it on the thread. xjs_file_free
+** stops the thread, after a read it is waiting on.
+**
+** Returns XJS_OK, XJS_ERR_USAGE if the input has started or the thread is
+** running, XJS_ERR_MEM_ALLOC, or XJS_ERR if the thread can't start.
+** ---------------------------------------------------------------------------
+*/
+int xjs_file_ahead(
+  XJSFile *file,         /* IN : File from xjs_file_open or xjs_file_fd */
+  int depth);            /* IN : Number of buffers, 0 for the default */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API:
+** xjs_file_input - XJSInputNCB, inp_arg is the file. A mapped file is
+**                  passed whole on the first call, otherwise each call
+**                  reads the next buffer. Returns XJS_END at the end of
+**                  the file and XJS_ERR_IO if a read fails.
+** xjs_file_parse - xjs_parser_parse of the whole file (with XJS_OPT_INDEX
+**                  too when it is mapped).
+** xjs_file_data  - the contents of a mapped file and their length, or NULL
+**                  if the file is read.
+** ---------------------------------------------------------------------------
+*/
+int xjs_file_input(const char **input, XJSSize *len, void *inp_arg);
+int xjs_file_parse(XJSFile *file, XJSParser *parser, const char **errpos);
+const char *xjs_file_data(const XJSFile *file, XJSSize *len);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __XJS_FILE_H__
+
+/* EOF */
@@ -0,0 +1,442 @@
+/* ---------------------------------------------------------------------------
+** xjs_par is an optional parallel driver for xjs
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+** Permission to use, copy, modify, and/or distribute this software for any
+** purpose with or without fee is hereby granted.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+** THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+** Also offered with MIT License.
+** ---------------------------------------------------------------------------
+*/
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "xjs_par.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#if !defined(NULL)
+#define NULL ((void*)0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* IXJS_PAR_CHUNK - the size of a chunk when xjs_par_chunks is not given one */
+#define IXJS_PAR_CHUNK  (4*1024*1024)
+
+/* what the workers do with the chunks, see i_par_worker */
+#define IXJS_PAR_LINES  0   /* parse the lines (documents) of each chunk */
+#define IXJS_PAR_SCAN   1   /* XJS_PAR_ARRAY: follow the quotes and brackets of each chunk, see i_par_scan */
+#define IXJS_PAR_ELEMS  2   /* XJS_PAR_ARRAY: parse the elements from the first in each chunk */
+#define IXJS_PAR_WHOLE  3   /* XJS_PAR_ARRAY: the input is not an array, one chunk of all of it */
+
+/*
+** XJS_PAR_ARRAY: a chunk of the array as i_par_scan found it, for both
+** a start outside a string (0) and inside one (1). Backslashes escape the
+** next byte in either case, JSON has none outside strings.
+*/
+typedef struct
+{ int q;              /* the chunk has an odd number of quotes that are not escaped */
+  long d[2];          /* change of the depth over the chunk */
+  long m[2];          /* least depth in the chunk, relative to its start */
+  XJSSize n[2];       /* commas at that least depth */
+  int s;              /* known after the scan: the chunk starts inside a string */
+  long depth;         /* known after the scan: the depth at its start, 1 in the array */
+  XJSSize first;      /* known after the scan: the element after its first comma at depth 1 */
+} IXJSParSpan;
+
+typedef struct
+{ struct XJSPar *par;
+  int i;               /* the worker's number */
+  void *node_arg;
+  XJSArena *arena;     /* the worker's own arena, or NULL with a memory manager */
+  pthread_t th;
+  int started;         /* th is running (worker 0 is the calling thread) */
+} IXJSParW;
+
+struct XJSPar
+{ XJSMemCB mem_cb;      /* for the driver, and the parsers if user is set */
+  int user;             /* mem_cb is the caller's */
+  XJSNodeViewCB node_cb;
+  int n;                /* workers, w is allocated with the driver */
+  IXJSParW *w;
+  int opts, flags;      /* XJS_OPT_*, XJS_PAR_* */
+  int phase;            /* IXJS_PAR_* */
+  XJSSize chunk;        /* bytes per chunk */
+  XJSParChunkCB chunk_cb; void *chunk_arg;
+  /* a parse */
+  const char *json; XJSSize len, nchunk;
+  XJSSize open, close;  /* XJS_PAR_ARRAY: the brackets of the array */
+  IXJSParSpan *sp;      /* XJS_PAR_ARRAY: the chunks (nchunk of them) */
+  pthread_mutex_t mx; pthread_cond_t cv;
+  XJSSize next;         /* the next chunk a worker takes */
+  XJSSize turn;         /* XJS_PAR_ORDERED: the chunk whose callback is next */
+  int run, err;         /* a parse is running, the first error (by chunk) */
+  XJSSize errchunk, erroff;
+};
+
+static int i_par_run(XJSPar *p, int phase, XJSSize nchunk);
+static int i_par_array(XJSPar *p);
+static void *i_par_worker(void *arg);
+static int i_par_range(const XJSPar *p, XJSSize k, XJSSize *b, XJSSize *e, XJSSize *first);
+static XJSSize i_par_start(const XJSPar *p, XJSSize k);
+static void i_par_scan(XJSPar *p, XJSSize k);
+static XJSSize i_par_sep(const XJSPar *p, XJSSize k);
+static int i_par_esc(const XJSPar *p, XJSSize o);
+static int i_par_chunk(IXJSParW *w, XJSSize b, XJSSize e, XJSSize first, XJSSize *erroff);
+static void i_par_fail(XJSPar *p, XJSSize k, int r, XJSSize off);
+static void i_par_reset(IXJSParW *w);
+
+/*
+** Default memory management using libc malloc/free/realloc, like the parser's.
+** ---------------------------------------------------------------------------
+*/
+#ifdef XJS_CFLAG_DISABLE_MEM_FALLBACK
+static XJSMemCB i_par_mem = NULL;
+#else
+static void *i_par_mem(XJSMemReq action, XJSType context, void *prev, XJSSize size, XJSSize *actsz)
+{ void *ret=NULL; if (actsz) *actsz=0;
+  if (action==XJS_free) free(prev);
+  else if (action==XJS_alloc)
+  { if (prev) ret=realloc(prev, size);
+    else ret=malloc(size);
+  }
+  if ((ret)&&(actsz)) *actsz=size;
+  return ret;
+}
+#endif
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns a driver or NULL
+** ---------------------------------------------------------------------------
+*/
+XJSPar *xjs_par_new(XJSNodeViewCB node_cb, void **node_args, int nthreads, XJSMemCB mem_cb)
+{ XJSPar *p; XJSMemCB m=(mem_cb)?mem_cb:i_par_mem; XJSSize actsz=0; int i;
+  if ((m==NULL)||(node_cb==NULL)||(nthreads<1)) return NULL;
+  if ((p=(XJSPar*)m(XJS_alloc, XJS_parser, NULL, sizeof(XJSPar)+(XJSSize)nthreads*sizeof(IXJSParW), &actsz))==NULL) return NULL;
+  memset(p, 0, sizeof(XJSPar)+(XJSSize)nthreads*sizeof(IXJSParW));
+  p->mem_cb=m; p->user=(mem_cb!=NULL); p->node_cb=node_cb; p->n=nthreads; p->chunk=IXJS_PAR_CHUNK;
+  p->w=(IXJSParW*)(p+1);
+  for (i=0; i<nthreads; i++)
+  { p->w[i].par=p; p->w[i].i=i; p->w[i].node_arg=(node_args)?node_args[i]:NULL;
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+    if ((!p->user)&&((p->w[i].arena=xjs_arena_new(0))==NULL)) { xjs_par_free(p); return NULL; }
+#endif
+  }
+  return p;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_par_free(XJSPar *par)
+{ int i;
+  if (par==NULL) return;
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+  for (i=0; i<par->n; i++) if (par->w[i].arena) xjs_arena_free(par->w[i].arena);
+#else
+  (void)i;
+#endif
+  par->mem_cb(XJS_free, XJS_parser, par, 0, NULL);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns the number of processors online, at least 1
+** ---------------------------------------------------------------------------
+*/
+int xjs_par_cpus(void)
+{ long n=sysconf(_SC_NPROCESSORS_ONLN);
+  return (n<1)?1:(n>4096)?4096:(int)n;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTIONS
+** return XJS_OK or XJS_ERR_USAGE
+** ---------------------------------------------------------------------------
+*/
+int xjs_par_options(XJSPar *par, int options)
+{ if (par->run) return XJS_ERR_USAGE;
+  par->opts=options;
+  return XJS_OK;
+}
+
+int xjs_par_chunks(XJSPar *par, XJSParChunkCB chunk_cb, void *chunk_arg, int flags, XJSSize chunk_size)
+{ if ((par->run)||(flags&~(XJS_PAR_ORDERED|XJS_PAR_ARRAY))) return XJS_ERR_USAGE;
+  par->chunk_cb=chunk_cb; par->chunk_arg=chunk_arg; par->flags=flags;
+  par->chunk=(chunk_size)?chunk_size:IXJS_PAR_CHUNK;
+  return XJS_OK;
+}
+
+XJSArena *xjs_par_arena(XJSPar *par, int worker)
+{ return ((worker<0)||(worker>=par->n))?NULL:par->w[worker].arena;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_par_parse(XJSPar *par, const char *json, XJSSize len, XJSSize *erroff)
+{ int r;
+  if (erroff) *erroff=0;
+  if ((par->run)||((json==NULL)&&(len))) return XJS_ERR_USAGE;
+  par->json=json; par->len=len; par->err=XJS_OK; par->errchunk=par->erroff=0; par->run=1;
+  if ((pthread_mutex_init(&par->mx, NULL)!=0)||(pthread_cond_init(&par->cv, NULL)!=0)) { par->run=0; return XJS_ERR; }
+  if (par->flags&XJS_PAR_ARRAY) r=i_par_array(par);
+  else r=i_par_run(par, IXJS_PAR_LINES, (len+par->chunk-1)/par->chunk);
+  pthread_cond_destroy(&par->cv); pthread_mutex_destroy(&par->mx);
+  par->run=0;
+  if ((r!=XJS_OK)&&(erroff)) *erroff=par->erroff;
+  return r;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_par_file(XJSPar *par, const char *path, XJSSize *erroff)
+{ int fd, r; struct stat sb; void *m;
+  if (erroff) *erroff=0;
+  if (par->run) return XJS_ERR_USAGE;
+  if ((fd=open(path, O_RDONLY))<0) return XJS_ERR_IO;
+  if ((fstat(fd, &sb)!=0)||(sb.st_size<0)||((unsigned long long)sb.st_size>(unsigned long long)(XJSSize)-1)) { close(fd); return XJS_ERR_IO; }
+  if (sb.st_size==0) { close(fd); return XJS_OK; } // an empty sequence, mmap can't map it
+  if ((m=mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0))==MAP_FAILED) { close(fd); return XJS_ERR_IO; }
+  close(fd); // the mapping stays
+  r=xjs_par_parse(par, (const char*)m, (XJSSize)sb.st_size, erroff);
+  munmap(m, (size_t)sb.st_size);
+  return r;
+}
+
+/*
+** Run the workers over nchunk chunks for phase, the calling thread is
+** worker 0. Returns the error of the first chunk that failed.
+*/
+static int i_par_run(XJSPar *p, int phase, XJSSize nchunk)
+{ int i;
+  p->phase=phase; p->nchunk=nchunk; p->next=p->turn=0;
+  for (i=1; (i<p->n)&&((XJSSize)i<nchunk); i++) p->w[i].started=(pthread_create(&p->w[i].th, NULL, i_par_worker, &p->w[i])==0); // fewer workers if it fails
+  i_par_worker(&p->w[0]);
+  for (i=1; i<p->n; i++) if (p->w[i].started) { pthread_join(p->w[i].th, NULL); p->w[i].started=0; }
+  return p->err;
+}
+
+/*
+** XJS_PAR_ARRAY. The chunks of the array are scanned in parallel for their
+** quotes and brackets, each for both a start inside and outside a string.
+** Going through them in order then tells which case each really starts
+** in, its depth and how many elements come before it. Each chunk is then
+** parsed from its first comma at depth 1 to the next chunk's, with the
+** right element numbers. A wrong guess can only come from input that is
+** not JSON, and then some chunk fails to parse.
+*/
+static int i_par_array(XJSPar *p)
+{ const char *j=p->json; XJSSize b=0, e=p->len, k, n, cnt=0, actsz=0; long depth=1; int s=0, r;
+  while ((b<e)&&((j[b]==' ')||(j[b]=='\t')||(j[b]=='\n')||(j[b]=='\r'))) b++;
+  while ((e>b)&&((j[e-1]==' ')||(j[e-1]=='\t')||(j[e-1]=='\n')||(j[e-1]=='\r'))) e--;
+  if (((e-b)<2)||(j[b]!='[')||(j[e-1]!=']')) return i_par_run(p, IXJS_PAR_WHOLE, 1); // not an array, the parser tells what it is
+  p->open=b; p->close=e-1;
+  if ((n=(p->close-p->open-1+p->chunk-1)/p->chunk)==0) return XJS_OK; // []
+  if ((p->sp=(IXJSParSpan*)p->mem_cb(XJS_alloc, XJS_parser, NULL, n*sizeof(IXJSParSpan), &actsz))==NULL) return XJS_ERR_MEM_ALLOC;
+  if ((r=i_par_run(p, IXJS_PAR_SCAN, n))==XJS_OK)
+  { for (k=0; k<n; k++)
+    { p->sp[k].s=s; p->sp[k].depth=depth; p->sp[k].first=cnt+1;
+      if ((depth+p->sp[k].m[s])==1) cnt+=p->sp[k].n[s]; // the commas of the array itself
+      depth+=p->sp[k].d[s]; s^=p->sp[k].q;
+    }
+    r=i_par_run(p, IXJS_PAR_ELEMS, n);
+  }
+  p->mem_cb(XJS_free, XJS_parser, p->sp, 0, NULL); p->sp=NULL;
+  return r;
+}
+
+/*
+** A worker takes the next chunk until there are none left or a chunk
+** failed. In ordered mode it waits for the chunks before its own to be
+** called back before it calls back for it.
+*/
+static void *i_par_worker(void *arg)
+{ IXJSParW *w=(IXJSParW*)arg; XJSPar *p=w->par; XJSSize k, b, e, first, off=0; int r, some;
+  for (;;)
+  { pthread_mutex_lock(&p->mx);
+    k=((p->err==XJS_OK)&&(p->next<p->nchunk))?p->next++:p->nchunk;
+    pthread_mutex_unlock(&p->mx);
+    if (k>=p->nchunk) break;
+    if (p->phase==IXJS_PAR_SCAN) { i_par_scan(p, k); continue; }
+    some=i_par_range(p, k, &b, &e, &first); // a line or an element can be longer than a chunk, the next has none
+    r=(some)?i_par_chunk(w, b, e, first, &off):XJS_OK;
+    if (r!=XJS_OK) { i_par_fail(p, k, r, b+off); break; }
+    if (p->flags&XJS_PAR_ORDERED)
+    { pthread_mutex_lock(&p->mx);
+      while ((p->turn!=k)&&(p->err==XJS_OK)) pthread_cond_wait(&p->cv, &p->mx);
+      r=p->err;
+      pthread_mutex_unlock(&p->mx);
+      if (r!=XJS_OK) break;
+    }
+    if ((p->chunk_cb)&&(some)&&((r=p->chunk_cb(w->i, k, b, e-b, w->node_arg, p->chunk_arg))!=XJS_OK)) { i_par_fail(p, k, r, b); break; }
+    i_par_reset(w);
+    if (p->flags&XJS_PAR_ORDERED)
+    { pthread_mutex_lock(&p->mx);
+      p->turn++; pthread_cond_broadcast(&p->cv);
+      pthread_mutex_unlock(&p->mx);
+    }
+  }
+  i_par_reset(w);
+  return NULL;
+}
+
+/*
+** The input [b,e) chunk k parses and the number of its first element,
+** returns 0 if it has none. Each worker finds its own ends, the ends of
+** neighbours always agree.
+*/
+static int i_par_range(const XJSPar *p, XJSSize k, XJSSize *b, XJSSize *e, XJSSize *first)
+{ *first=0;
+  if (p->phase==IXJS_PAR_WHOLE) { *b=0; *e=p->len; return 1; }
+  if (p->phase==IXJS_PAR_LINES) { *b=i_par_start(p, k); *e=i_par_start(p, k+1); return (*e>*b); }
+  *b=i_par_sep(p, k); *e=i_par_sep(p, k+1); // the comma (or bracket) before the elements and after them
+  if ((*b)>=(*e)) return 0;
+  if (k) *first=p->sp[k].first;
+  (*b)++; return 1;
+}
+
+/*
+** Where chunk k starts: after the first newline from the byte before
+** k*chunk on.
+*/
+static XJSSize i_par_start(const XJSPar *p, XJSSize k)
+{ const char *q; XJSSize o;
+  if (k==0) return 0;
+  if (k>=p->nchunk) return p->len;
+  o=k*p->chunk-1;
+  if ((q=(const char*)memchr(p->json+o, '\n', p->len-o))==NULL) return p->len;
+  return (XJSSize)(q-p->json)+1;
+}
+
+/*
+** Scan chunk k of the array for both cases (see IXJSParSpan). A comma is
+** counted at the least depth so far, those at a lesser depth later start
+** the count again: in the array, depth 1 is the least there is.
+*/
+static void i_par_scan(XJSPar *p, XJSSize k)
+{ IXJSParSpan *sp=p->sp+k; XJSSize o=p->open+1+k*p->chunk; const char *q=p->json+o, *e=p->json+p->close;
+  long d[2]={0,0}, m[2]={0,0}; XJSSize n[2]={0,0}; int par=0, esc=i_par_esc(p, o);
+  if ((XJSSize)(e-q)>p->chunk) e=q+p->chunk;
+  for (; q<e; q++)
+  { if (esc) { esc=0; continue; }
+    switch (*q) // counted for the case where the byte is outside a string
+    { case '\\': esc=1; break;
+      case '"': par^=1; break;
+      case '[': case '{': d[par]++; break;
+      case ']': case '}': if ((--d[par])<m[par]) { m[par]=d[par]; n[par]=0; } break;
+      case ',': if (d[par]==m[par]) n[par]++; break;
+      default: break;
+    }
+  }
+  sp->q=par; sp->d[0]=d[0]; sp->d[1]=d[1]; sp->m[0]=m[0]; sp->m[1]=m[1]; sp->n[0]=n[0]; sp->n[1]=n[1];
+}
+
+/*
+** The first comma at depth 1 from the start of chunk k on (the close
+** bracket if there is none). Chunk 0 starts at the open bracket.
+*/
+static XJSSize i_par_sep(const XJSPar *p, XJSSize k)
+{ const IXJSParSpan *sp; const char *q, *e; XJSSize o; long d; int str, esc;
+  if (k==0) return p->open;
+  if (k>=p->nchunk) return p->close;
+  sp=p->sp+k; o=p->open+1+k*p->chunk; q=p->json+o; e=p->json+p->close;
+  str=sp->s; d=sp->depth; esc=i_par_esc(p, o);
+  for (; q<e; q++)
+  { if (esc) { esc=0; continue; }
+    if ((*q)=='\\') esc=1;
+    else if ((*q)=='"') str^=1;
+    else if (str) continue;
+    else if (((*q)=='[')||((*q)=='{')) d++;
+    else if (((*q)==']')||((*q)=='}')) d--;
+    else if (((*q)==',')&&(d==1)) return (XJSSize)(q-p->json);
+  }
+  return p->close;
+}
+
+/* The byte at o is escaped: an odd run of backslashes in the array ends before it. */
+static int i_par_esc(const XJSPar *p, XJSSize o)
+{ XJSSize i=o;
+  while ((i>p->open+1)&&(p->json[i-1]=='\\')) i--;
+  return (int)((o-i)&1);
+}
+
+/*
+** Parse [b,e) with a new parser, an error is at *erroff from b. Elements
+** of the array start at element first, the part before a comma must not be
+** empty.
+*/
+static int i_par_chunk(IXJSParW *w, XJSSize b, XJSSize e, XJSSize first, XJSSize *erroff)
+{ XJSPar *p=w->par; XJSParser *ps; const char *err=NULL, *q; int r;
+  *erroff=0;
+  if (p->phase==IXJS_PAR_ELEMS)
+  { q=p->json+b;
+    while ((q<p->json+e)&&(((*q)==' ')||((*q)=='\t')||((*q)=='\n')||((*q)=='\r'))) q++;
+    if (q==p->json+e) // only white space, only allowed in []
+    { if ((first==0)&&(e==p->close)) return XJS_OK;
+      *erroff=e-b; return XJS_ERR_BAD_INPUT; // at the comma
+    }
+  }
+  if ((ps=xjs_parser_new_view(p->node_cb, w->node_arg, (p->user)?p->mem_cb:NULL))==NULL) return XJS_ERR_MEM_ALLOC;
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+  if (w->arena) xjs_parser_arena(ps, w->arena);
+#endif
+  r=xjs_parser_options(ps, (p->phase==IXJS_PAR_LINES)?(p->opts|XJS_OPT_SEQ):p->opts);
+  if ((r==XJS_OK)&&(p->phase==IXJS_PAR_ELEMS)) r=xjs_parser_elements(ps, first);
+  if (r==XJS_OK) r=xjs_parser_parse(ps, p->json+b, e-b, NULL, NULL, &err);
+  if ((r!=XJS_OK)&&(err)) *erroff=(XJSSize)(err-(p->json+b));
+  xjs_parser_free(ps);
+  return r;
+}
+
+/* Record the error of chunk k if it is the first in input order, and stop. */
+static void i_par_fail(XJSPar *p, XJSSize k, int r, XJSSize off)
+{ pthread_mutex_lock(&p->mx);
+  if ((p->err==XJS_OK)||(k<p->errchunk)) { p->err=r; p->errchunk=k; p->erroff=off; }
+  pthread_cond_broadcast(&p->cv);
+  pthread_mutex_unlock(&p->mx);
+}
+
+/* Release what the worker's arena holds, the chunks stay for the next. */
+static void i_par_reset(IXJSParW *w)
+{
+#ifndef XJS_CFLAG_DISABLE_MEM_FALLBACK
+  if (w->arena) xjs_arena_reset(w->arena);
+#else
+  (void)w;
+#endif
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/* EOF */
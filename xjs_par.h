@@ -0,0 +1,155 @@
+/* ---------------------------------------------------------------------------
+** xjs_par is an optional parallel driver for xjs
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+** Permission to use, copy, modify, and/or distribute this software for any
+** purpose with or without fee is hereby granted.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+** THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+** Also offered with MIT License.
+** ---------------------------------------------------------------------------
+** # xjs_par
+**
+** **xjs_par** parses NDJSON (one document per line) on several threads. The
+** input, a file it maps into memory or a buffer, is cut into chunks that
+** end at a newline, and a pool of workers parses the chunks with a parser
+** each (`XJS_OPT_SEQ`). Every worker has its own node_arg for the callback
+** and its own arena, so the callbacks share nothing unless the caller makes
+** them. A chunk callback tells the caller when a worker has finished a
+** chunk, either as soon as it is done or in input order:
+**
+** ```
+** void *ctx[64]; int i, n=xjs_par_cpus();
+** for (i=0;i<n;i++) ctx[i]=new_stats();
+** XJSPar *p=xjs_par_new(recordcb, ctx, n, NULL);
+** xjs_par_chunks(p, mergecb, total, XJS_PAR_ORDERED, 0);
+** r=xjs_par_file(p, "day.ndjson", &erroff);
+** xjs_par_free(p);
+** ```
+**
+** The parser is reentrant, the driver only adds the threads (POSIX threads
+** and mmap, so it is for the systems that have them).
+** ---------------------------------------------------------------------------
+*/
+#ifndef __XJS_PAR_H__
+#define __XJS_PAR_H__
+
+#include "xjs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct XJSPar XJSPar; /* opaque, from xjs_par_new */
+
+/*
+** ---------------------------------------------------------------------------
+** CALLBACK: XJSParChunkCB
+** Called on the worker when it has parsed a chunk, before it starts the
+** next. With XJS_PAR_ORDERED the calls are in input order (a worker that is
+** done early waits for its turn), otherwise in the order the chunks are
+** done. Calls never overlap in ordered mode, otherwise workers call it at
+** the same time.
+**
+** Returns XJS_OK, any other value stops the parse
+** ---------------------------------------------------------------------------
+*/
+typedef int (*XJSParChunkCB)(
+  int worker,         /* IN : The worker, from 0 */
+  XJSSize chunk,      /* IN : Number of the chunk in the input, from 0 */
+  XJSSize offset,     /* IN : Where the chunk starts in the input */
+  XJSSize len,        /* IN : Number of bytes in the chunk */
+  void *node_arg,     /* IN : The worker's node_arg */
+  void *chunk_arg);   /* IN : argument from xjs_par_chunks */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_par_new creates a driver with nthreads workers (the
+** calling thread is one of them). Worker i calls node_cb with node_args[i]
+** (node_args holds nthreads pointers, or is NULL for all NULL). Without a
+** memory manager each worker parses from its own arena (xjs_par_arena),
+** mem_cb is called from every worker at the same time and must be thread
+** safe. xjs_par_cpus is the number of processors online, for nthreads.
+**
+** Returns the driver, or NULL if there is no storage for it.
+** ---------------------------------------------------------------------------
+*/
+XJSPar *xjs_par_new(
+  XJSNodeViewCB node_cb, /* IN : Node parsed callback function, can't be NULL */
+  void **node_args,      /* IN : node_arg of each worker, or NULL */
+  int nthreads,          /* IN : Number of workers, 1 or more */
+  XJSMemCB mem_cb);      /* IN : Optional thread safe memory manager callback (NULL for an arena per worker) */
+
+void xjs_par_free(XJSPar *par);
+int xjs_par_cpus(void);
+
+/*
+** ---------------------------------------------------------------------------
+** Public API:
+** xjs_par_options - XJS_OPT_* flags for every worker's parser (XJS_OPT_SEQ
+**                   is always on), see xjs_parser_options.
+** xjs_par_chunks  - the chunk callback (or NULL), XJS_PAR_* flags, and the
+**                   size of a chunk (0 for 4 MB). A chunk goes on to the
+**                   end of the line (or the element) it would otherwise
+**                   end in.
+** xjs_par_arena   - the arena of a worker when there is no memory manager,
+**                   otherwise NULL. Callbacks can build their results in it
+**                   with xjs_arena_alloc, it is reset after each chunk
+**                   callback returns.
+**
+** Return XJS_OK, or XJS_ERR_USAGE for unknown flags or a parse that is
+** running.
+** ---------------------------------------------------------------------------
+*/
+#define XJS_PAR_ORDERED  0x01   /* chunk callbacks in input order */
+#define XJS_PAR_ARRAY    0x02   /* the input is one array, not NDJSON */
+
+int xjs_par_options(XJSPar *par, int options);
+int xjs_par_chunks(XJSPar *par, XJSParChunkCB chunk_cb, void *chunk_arg, int flags, XJSSize chunk_size);
+XJSArena *xjs_par_arena(XJSPar *par, int worker);
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_par_parse parses the NDJSON in [json,json+len) on the
+** workers, xjs_par_file maps the file at path into memory (read only) and
+** does the same. Each document is signaled to one worker's node_cb,
+** followed by XJS_document_end, nothing is signaled across chunks. On an
+** error the workers stop after their current chunk.
+**
+** With XJS_PAR_ARRAY the input is one JSON array and its elements are
+** parsed on the workers instead: each element is signaled to one worker as
+** if it were in the array at depth 1, with its index (from 1) as the name,
+** and the array itself is not signaled. Input that is not an array is
+** parsed on one worker as it is. The chunks are first scanned in parallel
+** for quotes and brackets to find where each element starts.
+**
+** Returns XJS_OK, the error of the first chunk (in input order) that had
+** one, or XJS_ERR_IO if the file can't be opened or mapped.
+** ---------------------------------------------------------------------------
+*/
+int xjs_par_parse(
+  XJSPar *par,           /* IN : Driver from xjs_par_new */
+  const char *json,      /* IN : Input (need not be null terminated) */
+  XJSSize len,           /* IN : Number of bytes at json */
+  XJSSize *erroff);      /* OUT: Can be NULL, otherwise set to the offset in the input of an error */
+
+int xjs_par_file(
+  XJSPar *par,           /* IN : Driver from xjs_par_new */
+  const char *path,      /* IN : The file */
+  XJSSize *erroff);      /* OUT: Can be NULL, otherwise set to the offset in the file of an error */
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __XJS_PAR_H__
+
+/* EOF */
@@ -0,0 +1,440 @@
+/* ---------------------------------------------------------------------------
+** xjs_write is an optional streaming JSON writer for xjs
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+** Permission to use, copy, modify, and/or distribute this software for any
+** purpose with or without fee is hereby granted.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+** THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+** Also offered with MIT License.
+** ---------------------------------------------------------------------------
+*/
+
+#include "xjs_write.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#if !defined(XJS_CFLAG_DISABLE_SIMD) && (defined(__GNUC__)||defined(__clang__)) && defined(__SSE2__)
+#define IXJS_W_SSE2
+#include <emmintrin.h>
+#endif
+
+#if !defined(NULL)
+#define NULL ((void*)0)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+** ---------------------------------------------------------------------------
+** IXJS_W_BUF_SIZE - the buffer when xjs_writer_new is not given a size.
+** IXJS_W_BUF_MIN - the smallest buffer, every piece but strings and
+** numbers from the caller fits in it.
+** IXJS_W_STACK - containers open before the stack is taken from the memory
+** manager.
+** ---------------------------------------------------------------------------
+*/
+#define IXJS_W_BUF_SIZE  (64*1024)
+#define IXJS_W_BUF_MIN   64
+#define IXJS_W_STACK     64
+
+/* the kind of an open container, IXJS_W_MORE once it has an element */
+#define IXJS_W_OBJ   1
+#define IXJS_W_ARR   2
+#define IXJS_W_BLK   3
+#define IXJS_W_HDR   4
+#define IXJS_W_REC   5
+#define IXJS_W_MORE  0x80
+
+#define IXJS_W_CSTR  ((XJSSize)-1)  /* the name is null terminated, its length is taken when it is written */
+
+struct XJSWriter
+{ XJSMemCB mem_cb;
+  XJSFlushCB flush_cb; void *flush_arg;
+  char *buf; XJSSize n, size;         /* bytes used and allocated */
+  unsigned char *stk; int depth, stksz; /* the open containers (IXJS_W_*) */
+  int flags, err;                     /* XJS_WRITE_*, the error that stopped the writer */
+  int top;                            /* a top level value is complete */
+  unsigned char stk0[IXJS_W_STACK];
+};
+
+static int i_w_event(XJSWriter *w, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len);
+static int i_w_begin(XJSWriter *w, const char *name, XJSSize name_len);
+static int i_w_open(XJSWriter *w, int k, char ch);
+static int i_w_close(XJSWriter *w, int k, char ch);
+static int i_w_room(XJSWriter *w, XJSSize k);
+static int i_w_put(XJSWriter *w, const char *p, XJSSize n);
+static int i_w_str(XJSWriter *w, const char *p, XJSSize n);
+static XJSSize i_w_utoa(char *b, unsigned long long v);
+static XJSSize i_w_dtoa(char *b, double d);
+
+/*
+** Default memory management using libc malloc/free/realloc, like the parser's.
+** ---------------------------------------------------------------------------
+*/
+#ifdef XJS_CFLAG_DISABLE_MEM_FALLBACK
+static XJSMemCB i_w_mem = NULL;
+#else
+static void *i_w_mem(XJSMemReq action, XJSType context, void *prev, XJSSize size, XJSSize *actsz)
+{ void *ret=NULL; if (actsz) *actsz=0;
+  if (action==XJS_free) free(prev);
+  else if (action==XJS_alloc)
+  { if (prev) ret=realloc(prev, size);
+    else ret=malloc(size);
+  }
+  if ((ret)&&(actsz)) *actsz=size;
+  return ret;
+}
+#endif
+
+/*
+** The escape of each byte in a string, 0 if it is written as it is. 'u'
+** stands for \u00XX.
+*/
+static const char i_w_esc[256]=
+{ 'u','u','u','u','u','u','u','u','b','t','n','u','f','r','u','u',
+  'u','u','u','u','u','u','u','u','u','u','u','u','u','u','u','u',
+  0,0,'"',0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,'\\',0,0,0,
+};
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns a writer or NULL
+** ---------------------------------------------------------------------------
+*/
+XJSWriter *xjs_writer_new(XJSFlushCB flush_cb, void *flush_arg, XJSSize bufsize, int flags, XJSMemCB mem_cb)
+{ XJSWriter *w; XJSMemCB m=(mem_cb)?mem_cb:i_w_mem; XJSSize actsz=0;
+  if ((m==NULL)||(flags&~XJS_WRITE_RAW)) return NULL;
+  if ((w=(XJSWriter*)m(XJS_alloc, XJS_write, NULL, sizeof(XJSWriter), &actsz))==NULL) return NULL;
+  memset(w, 0, sizeof(XJSWriter));
+  w->mem_cb=m; w->flush_cb=flush_cb; w->flush_arg=flush_arg; w->flags=flags;
+  w->stk=w->stk0; w->stksz=IXJS_W_STACK;
+  if (bufsize==0) bufsize=IXJS_W_BUF_SIZE;
+  if (bufsize<IXJS_W_BUF_MIN) bufsize=IXJS_W_BUF_MIN;
+  if ((w->buf=(char*)m(XJS_alloc, XJS_write, NULL, bufsize, &actsz))==NULL) { xjs_writer_free(w); return NULL; }
+  w->size=actsz;
+  return w;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_writer_free(XJSWriter *w)
+{ if (w==NULL) return;
+  if (w->buf) w->mem_cb(XJS_free, XJS_write, w->buf, 0, NULL);
+  if (w->stk!=w->stk0) w->mem_cb(XJS_free, XJS_write, w->stk, 0, NULL);
+  w->mem_cb(XJS_free, XJS_write, w, 0, NULL);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_write(XJSWriter *w, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len)
+{ return i_w_event(w, kind, name, name_len, value, value_len);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_write_int(XJSWriter *w, const char *name, XJSSize name_len, long long v)
+{ char b[24]; XJSSize n;
+  if (v<0) { b[0]='-'; n=1+i_w_utoa(b+1, 0ULL-(unsigned long long)v); }
+  else n=i_w_utoa(b, (unsigned long long)v);
+  return i_w_event(w, XJS_number, name, name_len, b, n);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_write_double(XJSWriter *w, const char *name, XJSSize name_len, double v)
+{ char b[40]; XJSSize n=i_w_dtoa(b, v);
+  if (n==0) return i_w_event(w, XJS_null, name, name_len, NULL, 0); // not a number JSON has
+  return i_w_event(w, XJS_number, name, name_len, b, n);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTIONS
+** the parser's callbacks, return XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_write_node(void **parent, XJSType kind, const char *name, const char *value, void *node_arg)
+{ return i_w_event((XJSWriter*)node_arg, kind, name, IXJS_W_CSTR, value, (value)?strlen(value):0);
+}
+
+int xjs_write_view(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *node_arg)
+{ return i_w_event((XJSWriter*)node_arg, kind, name, name_len, value, value_len);
+}
+
+int xjs_write_num(void **parent, const char *name, XJSSize name_len, const char *text, XJSSize text_len, const XJSNumber *num, void *node_arg)
+{ return i_w_event((XJSWriter*)node_arg, XJS_number, name, name_len, text, text_len);
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns XJS_OK or an error code
+** ---------------------------------------------------------------------------
+*/
+int xjs_writer_finish(XJSWriter *w)
+{ int r;
+  if (w->err) return w->err;
+  if (w->depth) return XJS_ERR_USAGE;
+  if ((w->flush_cb)&&(w->n))
+  { if ((r=w->flush_cb(w->buf, w->n, w->flush_arg))!=XJS_OK) return w->err=r;
+    w->n=0;
+  }
+  return XJS_OK;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** returns the output kept so far
+** ---------------------------------------------------------------------------
+*/
+const char *xjs_writer_data(const XJSWriter *w, XJSSize *len)
+{ if (len) *len=w->n;
+  return w->buf;
+}
+
+/* ---------------------------------------------------------------------------
+** USER FUNCTION
+** ---------------------------------------------------------------------------
+*/
+void xjs_writer_reset(XJSWriter *w)
+{ w->n=0; w->depth=0; w->err=0; w->top=0;
+}
+
+/*
+** Write one event. A container's element or member starts with a comma
+** after the first one, a member with its name.
+*/
+static int i_w_event(XJSWriter *w, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len)
+{ int r;
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  int in=(w->depth)?(w->stk[w->depth-1]&~IXJS_W_MORE):0;
+#endif
+  if (w->err) return w->err;
+  switch (kind)
+  { case XJS_object_end: return i_w_close(w, IXJS_W_OBJ, '}');
+    case XJS_array_end:  return i_w_close(w, IXJS_W_ARR, ']');
+    case XJS_document_end: return (w->depth)?XJS_ERR_USAGE:XJS_OK; // the next value starts a new line anyway
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    case XJS_block_end:        return i_w_close(w, IXJS_W_BLK, ')');
+    case XJS_block_header_end: return i_w_close(w, IXJS_W_HDR, ']');
+    case XJS_block_array_end:  return i_w_close(w, IXJS_W_REC, ']');
+    case XJS_block_header:
+    case XJS_block_array:
+      if (in!=IXJS_W_BLK) return XJS_ERR_USAGE;
+      if ((kind==XJS_block_header)!=((w->stk[w->depth-1]&IXJS_W_MORE)==0)) return XJS_ERR_USAGE; // the header comes first
+      if ((r=i_w_begin(w, NULL, 0))!=XJS_OK) return r;
+      return i_w_open(w, (kind==XJS_block_header)?IXJS_W_HDR:IXJS_W_REC, '[');
+#endif
+    default: break;
+  }
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+  if ((in==IXJS_W_BLK)||((in==IXJS_W_HDR)!=(kind==XJS_name))) return XJS_ERR_USAGE; // records and header fields only where they go
+#else
+  if (kind==XJS_name) return XJS_ERR_USAGE;
+#endif
+  if ((r=i_w_begin(w, name, name_len))!=XJS_OK) return r;
+  switch (kind)
+  { case XJS_object: return i_w_open(w, IXJS_W_OBJ, '{');
+    case XJS_array:  return i_w_open(w, IXJS_W_ARR, '[');
+#ifdef XJS_CFLAG_ENABLE_BLOCKS
+    case XJS_block:  return i_w_open(w, IXJS_W_BLK, '(');
+#endif
+    case XJS_name:
+    case XJS_string: r=i_w_str(w, value, value_len); break;
+    case XJS_number:
+      if ((value==NULL)||(value_len==0)) return w->err=XJS_ERR_USAGE;
+      r=i_w_put(w, value, value_len); break;
+    case XJS_true:   r=i_w_put(w, "true", 4); break;
+    case XJS_false:  r=i_w_put(w, "false", 5); break;
+    case XJS_null:   r=i_w_put(w, "null", 4); break;
+    default: return w->err=XJS_ERR_USAGE;
+  }
+  if (w->depth==0) w->top=1;
+  return r;
+}
+
+/*
+** Before a value: the comma, and the name of a member. The next top level
+** value goes on a new line.
+*/
+static int i_w_begin(XJSWriter *w, const char *name, XJSSize name_len)
+{ unsigned char *t; int r;
+  if (w->depth==0)
+  { if (!w->top) return XJS_OK;
+    if ((r=i_w_room(w, 1))!=XJS_OK) return r;
+    w->buf[w->n++]='\n'; return XJS_OK;
+  }
+  t=w->stk+w->depth-1;
+  if ((*t)&IXJS_W_MORE) { if ((r=i_w_room(w, 1))!=XJS_OK) return r; w->buf[w->n++]=','; }
+  else *t|=IXJS_W_MORE;
+  if (((*t)&~IXJS_W_MORE)!=IXJS_W_OBJ) return XJS_OK;
+  if (name_len==IXJS_W_CSTR) name_len=(name)?strlen(name):0;
+  if ((r=i_w_str(w, name, name_len))!=XJS_OK) return r;
+  if ((r=i_w_room(w, 1))!=XJS_OK) return r;
+  w->buf[w->n++]=':';
+  return XJS_OK;
+}
+
+static int i_w_open(XJSWriter *w, int k, char ch)
+{ XJSSize actsz=0; unsigned char *s; int r;
+  if (w->depth>=w->stksz)
+  { if ((s=(unsigned char*)w->mem_cb(XJS_alloc, XJS_write, NULL, (XJSSize)w->stksz*2, &actsz))==NULL) return w->err=XJS_ERR_MEM_ALLOC;
+    memcpy(s, w->stk, (XJSSize)w->depth);
+    if (w->stk!=w->stk0) w->mem_cb(XJS_free, XJS_write, w->stk, 0, NULL);
+    w->stk=s; w->stksz=(int)actsz;
+  }
+  if ((r=i_w_room(w, 1))!=XJS_OK) return r;
+  w->buf[w->n++]=ch; w->stk[w->depth++]=(unsigned char)k;
+  return XJS_OK;
+}
+
+static int i_w_close(XJSWriter *w, int k, char ch)
+{ int r;
+  if (w->err) return w->err;
+  if ((w->depth==0)||((w->stk[w->depth-1]&~IXJS_W_MORE)!=k)) return XJS_ERR_USAGE;
+  if ((r=i_w_room(w, 1))!=XJS_OK) return r;
+  w->buf[w->n++]=ch;
+  if ((--w->depth)==0) w->top=1;
+  return XJS_OK;
+}
+
+/*
+** Room for k more bytes: a full fixed buffer is flushed (k no more than
+** IXJS_W_BUF_MIN), a kept one doubles until k fit.
+*/
+static int i_w_room(XJSWriter *w, XJSSize k)
+{ XJSSize sz, actsz=0; char *b; int r;
+  if ((w->size-w->n)>=k) return XJS_OK;
+  if (w->flush_cb)
+  { if ((r=w->flush_cb(w->buf, w->n, w->flush_arg))!=XJS_OK) return w->err=r;
+    w->n=0; return XJS_OK;
+  }
+  for (sz=w->size*2;(sz-w->n)<k;sz*=2);
+  if ((b=(char*)w->mem_cb(XJS_alloc, XJS_write, w->buf, sz, &actsz))==NULL) return w->err=XJS_ERR_MEM_ALLOC;
+  w->buf=b; w->size=actsz;
+  return ((w->size-w->n)>=k)?XJS_OK:(w->err=XJS_ERR_MEM_ALLOC);
+}
+
+/* Append n bytes, through the flush callback in pieces if they don't fit. */
+static int i_w_put(XJSWriter *w, const char *p, XJSSize n)
+{ XJSSize k; int r;
+  while (n)
+  { if (w->n==w->size) { if ((r=i_w_room(w, (n<IXJS_W_BUF_MIN)?n:IXJS_W_BUF_MIN))!=XJS_OK) return r; }
+    if ((w->flush_cb==NULL)&&((w->size-w->n)<n)) { if ((r=i_w_room(w, n))!=XJS_OK) return r; } // a kept buffer takes it whole
+    k=w->size-w->n; if (k>n) k=n;
+    memcpy(w->buf+w->n, p, k); w->n+=k; p+=k; n-=k;
+  }
+  return XJS_OK;
+}
+
+/*
+** The first byte in [p,e) that has to be escaped, or e. SSE2 checks 16
+** bytes at a time for a quote, a backslash or a control character.
+*/
+static const char *i_w_scan(const char *p, const char *e)
+{
+#ifdef IXJS_W_SSE2
+  const __m128i q=_mm_set1_epi8('"'), b=_mm_set1_epi8('\\'), s=_mm_set1_epi8(0x1F);
+  while ((e-p)>=16)
+  { __m128i x=_mm_loadu_si128((const __m128i*)p);
+    int k=_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(x, s), x), _mm_or_si128(_mm_cmpeq_epi8(x, q), _mm_cmpeq_epi8(x, b))));
+    if (k) return p+__builtin_ctz((unsigned)k);
+    p+=16;
+  }
+#endif
+  while ((p<e)&&(!i_w_esc[(unsigned char)*p])) p++;
+  return p;
+}
+
+/* A string (or name) between quotes, escaped unless it is raw. */
+static int i_w_str(XJSWriter *w, const char *p, XJSSize n)
+{ static const char hex[]="0123456789abcdef"; const char *e=p+n, *q; char *o; unsigned char ch; int r;
+  if ((r=i_w_room(w, 1))!=XJS_OK) return r;
+  w->buf[w->n++]='"';
+  if (w->flags&XJS_WRITE_RAW) { if ((n)&&((r=i_w_put(w, p, n))!=XJS_OK)) return r; }
+  else while (p<e)
+  { q=i_w_scan(p, e);
+    if ((q>p)&&((r=i_w_put(w, p, (XJSSize)(q-p)))!=XJS_OK)) return r;
+    if (q>=e) break;
+    if ((r=i_w_room(w, 6))!=XJS_OK) return r;
+    ch=(unsigned char)*q; o=w->buf+w->n; o[0]='\\';
+    if (i_w_esc[ch]=='u') { o[1]='u'; o[2]='0'; o[3]='0'; o[4]=hex[ch>>4]; o[5]=hex[ch&15]; w->n+=6; }
+    else { o[1]=i_w_esc[ch]; w->n+=2; }
+    p=q+1;
+  }
+  if ((r=i_w_room(w, 1))!=XJS_OK) return r;
+  w->buf[w->n++]='"';
+  return XJS_OK;
+}
+
+/* Decimal text of v in b (not null terminated), two digits at a time, returns its length. */
+static XJSSize i_w_utoa(char *b, unsigned long long v)
+{ static const char d2[]="00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                         "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                         "8081828384858687888990919293949596979899";
+  char t[24]; int k=24; XJSSize n;
+  while (v>=100) { unsigned i=(unsigned)(v%100)*2; v/=100; t[--k]=d2[i+1]; t[--k]=d2[i]; }
+  if (v>=10) { t[--k]=d2[v*2+1]; t[--k]=d2[v*2]; } else t[--k]=(char)('0'+v);
+  n=(XJSSize)(24-k); memcpy(b, t+k, n);
+  return n;
+}
+
+/*
+** The shortest text of d that reads back as d, returns its length (0 for
+** NaN and the infinities). Most doubles in JSON are a few decimals: the
+** first k up to 8 where d*10^k rounds to an integer m below 2^53 and m/10^k
+** is d again gives the digits of m with a point k from the right, exact
+** because both divisions round the same value. Otherwise 15, 16 and then
+** 17 significant digits are tried, checked with xjs_number (which rounds
+** correctly and ignores the locale).
+*/
+static XJSSize i_w_dtoa(char *b, double d)
+{ static const double p10[9]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8};
+  double x=(d<0)?-d:d; unsigned long long m; XJSSize n=0, i, z; int k, prec; char t[24]; XJSNumber num;
+  if ((d!=d)||((d-d)!=0)) return 0;
+  if ((d<0)||((d==0)&&((1/d)<0))) b[n++]='-'; // -0 too
+  if (x<9007199254740992.0) for (k=0;k<=8;k++)
+  { m=(unsigned long long)(x*p10[k]+0.5);
+    if ((m>=9007199254740992ULL)||(((double)m/p10[k])!=x)) continue;
+    z=i_w_utoa(t, m);
+    if (k==0) { memcpy(b+n, t, z); return n+z; }
+    if (z<=(XJSSize)k) { b[n++]='0'; b[n++]='.'; for (i=z;i<(XJSSize)k;i++) b[n++]='0'; memcpy(b+n, t, z); return n+z; }
+    memcpy(b+n, t, z-k); n+=z-k; b[n++]='.'; memcpy(b+n, t+z-k, k);
+    return n+k;
+  }
+  for (prec=15;prec<=17;prec++)
+  { n=(XJSSize)snprintf(b, 40, "%.*g", prec, d);
+    for (i=0;i<n;i++) if ((!((b[i]>='0')&&(b[i]<='9')))&&(b[i]!='-')&&(b[i]!='+')&&(b[i]!='e')) b[i]='.'; // the locale's decimal point
+    if ((xjs_number(b, n, &num)==XJS_OK)&&(num.d==d)) break;
+  }
+  return n;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/* EOF */
@@ -0,0 +1,172 @@
+/* ---------------------------------------------------------------------------
+** xjs_write is an optional streaming JSON writer for xjs
+** ---------------------------------------------------------------------------
+** Copyright (c) 2016 by Payton Bissell, payton.bissell@gmail.com
+** ---------------------------------------------------------------------------
+** Permission to use, copy, modify, and/or distribute this software for any
+** purpose with or without fee is hereby granted.
+**
+** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+** OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+** THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+** DEALINGS IN THE SOFTWARE.
+**
+** Also offered with MIT License.
+** ---------------------------------------------------------------------------
+** # xjs_write
+**
+** **xjs_write** writes JSON from the same events the parser signals: the
+** caller opens and closes containers and writes names and values with
+** `xjs_write`, the writer adds the commas, colons and quotes. The output
+** goes into one buffer from the memory manager (`XJS_write`) that grows by
+** doubling, or into a fixed buffer that is handed to a flush callback each
+** time it fills up. Nothing is allocated per token.
+**
+** The node callbacks of the parser can be pointed straight at a writer,
+** so a parse is written back out as it goes without a tree in between:
+**
+** ```
+** XJSWriter *w=xjs_writer_new(flushcb, file, 0, XJS_WRITE_RAW, NULL);
+** r=xjs_parse_view(json, len, xjs_write_view, w, NULL, NULL, NULL, &err);
+** if (r==XJS_OK) r=xjs_writer_finish(w);
+** xjs_writer_free(w);
+** ```
+**
+** Strings are escaped through a table, with SSE2 finding the runs that need
+** no escape 16 bytes at a time. Integers are formatted two digits at a
+** time. Doubles get a short fixed point form when one reads back the
+** same, otherwise the fewest of 15, 16 or 17 significant digits. Blocks
+** (`XJS_CFLAG_ENABLE_BLOCKS`) are written as blocks.
+** ---------------------------------------------------------------------------
+*/
+#ifndef __XJS_WRITE_H__
+#define __XJS_WRITE_H__
+
+#include "xjs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct XJSWriter XJSWriter; /* opaque, from xjs_writer_new */
+
+/*
+** ---------------------------------------------------------------------------
+** CALLBACK: XJSFlushCB
+** Gets the output of a writer with a fixed buffer each time the buffer is
+** full, and the rest at xjs_writer_finish. The data is only valid until
+** the callback returns.
+**
+** Returns XJS_OK, any other value stops the writer (every later call
+** returns it)
+** ---------------------------------------------------------------------------
+*/
+typedef int (*XJSFlushCB)(
+  const char *data,   /* IN : The output (not null terminated) */
+  XJSSize len,        /* IN : Number of bytes at data */
+  void *flush_arg);   /* IN : argument from xjs_writer_new */
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_writer_new creates a writer. With a flush callback the
+** output is collected in a buffer of bufsize bytes (0 for 64 KB) and passed
+** to it whenever the buffer fills, otherwise it is kept in a buffer that
+** grows (bufsize is its first size) and xjs_writer_data returns it.
+**
+** XJS_WRITE_RAW - strings and names are JSON text already (as the parser
+** passes them without XJS_OPT_DECODE), they are written between quotes as
+** they are. Otherwise they are UTF-8 text and are escaped.
+**
+** Returns the writer, or NULL if there is no storage for it.
+** ---------------------------------------------------------------------------
+*/
+#define XJS_WRITE_RAW    0x01   /* strings and names are written as they are */
+
+XJSWriter *xjs_writer_new(
+  XJSFlushCB flush_cb,   /* IN : Optional flush callback (NULL to keep the output) */
+  void *flush_arg,       /* IN : Parameter passed to flush_cb */
+  XJSSize bufsize,       /* IN : Size of the buffer, 0 for the default */
+  int flags,             /* IN : XJS_WRITE_* flags or'ed together */
+  XJSMemCB mem_cb);      /* IN : Optional memory manager callback (NULL for libc) */
+
+void xjs_writer_free(XJSWriter *w);
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: xjs_write writes the event kind, like the node callback gets
+** it. name is used for a member of an object (NULL for an empty name) and
+** ignored elsewhere. value is the text of a string or a number (the
+** number is written as it is), or NULL.
+**
+**   XJS_object, XJS_array            - open a container
+**   XJS_object_end, XJS_array_end    - close it
+**   XJS_string, XJS_number           - a value
+**   XJS_true, XJS_false, XJS_null    - a literal
+**   XJS_block, XJS_block_header, XJS_block_array and their ends - a block,
+**                                      its header and its records
+**   XJS_name                         - a field of a block header
+**
+** A value after a complete top level value starts a new line, so a writer
+** can write a sequence of documents (NDJSON). XJS_document_end (from a
+** parser with XJS_OPT_SEQ) writes nothing.
+**
+** xjs_write_int and xjs_write_double write a number from its value.
+** NaN and the infinities are not JSON, they are written as null.
+**
+** Return XJS_OK, XJS_ERR_USAGE if the event does not fit (a close that
+** does not match the open container, a record outside a block),
+** XJS_ERR_MEM_ALLOC, or the error that stopped the writer.
+** ---------------------------------------------------------------------------
+*/
+int xjs_write(
+  XJSWriter *w,          /* IN : Writer from xjs_writer_new */
+  XJSType kind,          /* IN : The event */
+  const char *name,      /* IN : Member name (need not be null terminated), or NULL */
+  XJSSize name_len,      /* IN : Length of name */
+  const char *value,     /* IN : Value text (need not be null terminated), or NULL */
+  XJSSize value_len);    /* IN : Length of value */
+
+int xjs_write_int(XJSWriter *w, const char *name, XJSSize name_len, long long v);
+int xjs_write_double(XJSWriter *w, const char *name, XJSSize name_len, double v);
+
+/*
+** ---------------------------------------------------------------------------
+** Public API: the parser's callbacks, node_arg is the writer.
+**
+** xjs_write_node - XJSNodeCB (xjs_parse, xjs_parser_new)
+** xjs_write_view - XJSNodeViewCB (xjs_parse_view, xjs_parser_new_view)
+** xjs_write_num  - XJSNumberCB (xjs_parser_numbers), writes the text
+** ---------------------------------------------------------------------------
+*/
+int xjs_write_node(void **parent, XJSType kind, const char *name, const char *value, void *node_arg);
+int xjs_write_view(void **parent, XJSType kind, const char *name, XJSSize name_len, const char *value, XJSSize value_len, void *node_arg);
+int xjs_write_num(void **parent, const char *name, XJSSize name_len, const char *text, XJSSize text_len, const XJSNumber *num, void *node_arg);
+
+/*
+** ---------------------------------------------------------------------------
+** Public API:
+** xjs_writer_finish - checks that every container is closed and passes the
+**                     rest of the output to the flush callback. Returns
+**                     XJS_OK, XJS_ERR_USAGE if a container is open, or the
+**                     error that stopped the writer.
+** xjs_writer_data   - the output so far of a writer without a flush
+**                     callback (not null terminated), valid until the next
+**                     write.
+** xjs_writer_reset  - drop the output and any open containers and errors,
+**                     the buffer is kept for the next document.
+** ---------------------------------------------------------------------------
+*/
+int xjs_writer_finish(XJSWriter *w);
+const char *xjs_writer_data(const XJSWriter *w, XJSSize *len);
+void xjs_writer_reset(XJSWriter *w);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // __XJS_WRITE_H__
+
+/* EOF */